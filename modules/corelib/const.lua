@@ -318,3 +318,24 @@ SoundChannels = {
     Ambient = 2,
     Effect = 3
 }
+
+DrawPoolType = {
+    Map = 0,
+    CreatureInformation = 1,
+    Light = 2,
+    Text = 3,
+    Foreground = 4
+}
+
+MemoryCategory = {
+    SpriteSheets = 0,
+    ThingTextures = 1,
+    Textures = 2,
+    Tiles = 3,
+    Items = 4,
+    Creatures = 5,
+    Minimap = 6,
+    OtmlNodes = 7,
+    LuaRefs = 8,
+    SoundBuffers = 9
+}
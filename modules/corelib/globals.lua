@@ -10,22 +10,28 @@ G = G or {}
 
 -- @docfuncs @{
 
-function scheduleEvent(callback, delay)
+function scheduleEvent(callback, delay, source)
     local event = g_dispatcher.scheduleEvent(callback, delay)
+    -- optional label, groups the event in g_dispatcher.getSourceStats()
+    if source then event:setSource(source) end
     -- must hold a reference to the callback, otherwise it would be collected
     event._callback = callback
     return event
 end
 
-function addEvent(callback, front)
+function addEvent(callback, front, source)
     local event = g_dispatcher.addEvent(callback, front)
+    -- optional label, groups the event in g_dispatcher.getSourceStats()
+    if source then event:setSource(source) end
     -- must hold a reference to the callback, otherwise it would be collected
     event._callback = callback
     return event
 end
 
-function cycleEvent(callback, interval)
+function cycleEvent(callback, interval, source)
     local event = g_dispatcher.cycleEvent(callback, interval)
+    -- optional label, groups the event in g_dispatcher.getSourceStats()
+    if source then event:setSource(source) end
     -- must hold a reference to the callback, otherwise it would be collected
     event._callback = callback
     return event
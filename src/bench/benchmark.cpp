@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "benchmark.h"
+
+#include <client/game.h>
+#include <client/spritemanager.h>
+#include <client/thingtypemanager.h>
+#include <framework/core/resourcemanager.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+namespace
+{
+    std::atomic<uint64_t> g_allocCount{ 0 };
+    std::atomic<uint64_t> g_allocBytes{ 0 };
+}
+
+void* operator new(size_t size)
+{
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace bench
+{
+    AllocationStats allocations()
+    {
+        return { g_allocCount.load(std::memory_order_relaxed), g_allocBytes.load(std::memory_order_relaxed) };
+    }
+
+    double Samples::total() const
+    {
+        double sum = 0;
+        for (const double v : m_values)
+            sum += v;
+        return sum;
+    }
+
+    double Samples::percentile(double p) const
+    {
+        if (m_values.empty())
+            return 0;
+
+        std::vector<double> sorted = m_values;
+        const size_t index = std::min<size_t>(sorted.size() - 1, static_cast<size_t>(p / 100.0 * sorted.size()));
+        std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+        return sorted[index];
+    }
+
+    nlohmann::json Samples::toJson() const
+    {
+        return {
+            { "count", size() },
+            { "avg", average() },
+            { "p50", percentile(50) },
+            { "p95", percentile(95) },
+            { "p99", percentile(99) },
+            { "max", percentile(100) }
+        };
+    }
+
+    bool hasArg(const std::vector<std::string>& args, const std::string_view name)
+    {
+        return std::find(args.begin(), args.end(), name) != args.end();
+    }
+
+    std::string getArg(const std::vector<std::string>& args, const std::string_view name, const std::string_view def)
+    {
+        const auto it = std::find(args.begin(), args.end(), name);
+        if (it == args.end() || it + 1 == args.end())
+            return std::string{ def };
+        return *(it + 1);
+    }
+
+    void writeReport(const std::vector<std::string>& args, const nlohmann::json& report)
+    {
+        const auto& out = getArg(args, "--out");
+        if (out.empty()) {
+            std::cout << report.dump(4) << std::endl;
+            return;
+        }
+
+        std::ofstream file(out);
+        file << report.dump(4) << std::endl;
+    }
+
+    bool loadThings(const std::vector<std::string>& args, const int version)
+    {
+        g_game.setClientVersion(version);
+        g_game.setProtocolVersion(version);
+
+        if (version >= 1281) {
+            const auto& things = getArg(args, "--things", stdext::format("/things/%d/catalog-content", version));
+            return g_things.loadAppearances(g_resources.resolvePath(things));
+        }
+
+        const auto& things = getArg(args, "--things", stdext::format("/data/things/%d/Tibia", version));
+        return g_things.loadDat(things) && g_sprites.loadSpr(things);
+    }
+}
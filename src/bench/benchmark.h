@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <framework/global.h>
+
+#include <nlohmann/json.hpp>
+
+ /**
+  * Helpers shared by the benchmark executables.
+  * Results are emitted as JSON so they can be tracked across commits.
+  */
+namespace bench
+{
+    struct AllocationStats
+    {
+        uint64_t count{ 0 };
+        uint64_t bytes{ 0 };
+
+        AllocationStats operator-(const AllocationStats& o) const { return { count - o.count, bytes - o.bytes }; }
+    };
+
+    // counters fed by the global operator new replacement in benchmark.cpp
+    AllocationStats allocations();
+
+    // collects timing samples (in microseconds) and summarizes them
+    class Samples
+    {
+    public:
+        void reserve(size_t size) { m_values.reserve(size); }
+        void add(double value) { m_values.push_back(value); }
+        void clear() { m_values.clear(); }
+
+        size_t size() const { return m_values.size(); }
+        bool empty() const { return m_values.empty(); }
+
+        double total() const;
+        double average() const { return empty() ? 0 : total() / size(); }
+        double percentile(double p) const;
+
+        nlohmann::json toJson() const;
+
+    private:
+        std::vector<double> m_values;
+    };
+
+    // prevents the optimizer from discarding a computed value
+    template<typename T>
+    inline void doNotOptimize(const T& value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const T* sink;
+        sink = &value;
+#endif
+    }
+
+    bool hasArg(const std::vector<std::string>& args, std::string_view name);
+    std::string getArg(const std::vector<std::string>& args, std::string_view name, std::string_view def = {});
+
+    // writes the json document to the file given by --out, or to stdout
+    void writeReport(const std::vector<std::string>& args, const nlohmann::json& report);
+
+    // sets the game version and loads its things, honoring --things
+    bool loadThings(const std::vector<std::string>& args, int version);
+}
@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+ /*
+  * Headless map rendering benchmark.
+  *
+  * Loads the client assets and a map, places a camera and replays a scripted
+  * camera path, measuring how long MapView takes to record the frame into the
+  * draw pools and how long the pools take to submit it to the painter.
+  *
+  * Usage:
+  *   otclient_bench --version 1098 --map /data/maps/forgotten.otbm --position 1000,1000,7
+  *                  [--scenario walk|floor|zoom|all] [--frames 600] [--size 960x704]
+  *                  [--things /data/things/1098/Tibia] [--otb /data/things/1098/items.otb]
+  *                  [--no-submit] [--out report.json]
+  *                  [--capture dir] [--golden dir] [--capture-every 60] [--tolerance 2]
+  *                  [--fixed-step 16667] [--no-reorder] [--no-instancing] [--no-streaming]
+  *                  [--null-painter]
+  *
+  * A (hidden) window is still created to own the GL context, so on machines
+  * without a display run it under a virtual X server with a software driver,
+  * e.g. "xvfb-run -a otclient_bench ...". With --no-submit only the record
+  * phase is measured and nothing reaches the GPU. Built with TOGGLE_OFFSCREEN the
+  * window renders into an EGL pbuffer instead, no display server is needed.
+  *
+  * --null-painter runs without window or GL context at all, for CI: the pools are
+  * submitted to a NullPainter that only counts the draws and texture changes, so
+  * submit_us measures the CPU side of the submission and no image can be captured.
+  *
+  * --capture saves every --capture-every frame as <scenario>_<frame>.png into
+  * the write directory, --golden compares those frames against the images of
+  * the same name in a directory of the search path and reports the pixels that
+  * differ by more than --tolerance on any channel. Both switch the clock to a
+  * fixed timestep (--fixed-step microseconds) so animations are reproducible.
+  */
+
+#include "benchmark.h"
+
+#include <client/client.h>
+#include <client/map.h>
+#include <client/mapview.h>
+#include <client/thingtypemanager.h>
+#include <framework/core/application.h>
+#include <framework/core/clock.h>
+#include <framework/core/eventdispatcher.h>
+#include <framework/core/resourcemanager.h>
+#include <framework/graphics/drawpoolmanager.h>
+#include <framework/graphics/graphics.h>
+#include <framework/graphics/image.h>
+#include <framework/graphics/nullpainter.h>
+
+namespace
+{
+    struct Options
+    {
+        Size size{ 960, 704 };
+        int frames{ 600 };
+        bool submit{ true };
+        bool nullPainter{ false };
+
+        std::string captureDir, goldenDir;
+        int captureEvery{ 60 };
+        int tolerance{ 2 };
+    };
+
+    struct GoldenStats
+    {
+        int compared{ 0 };
+        int missing{ 0 };
+        int mismatchedFrames{ 0 };
+        int maxMismatchedPixels{ 0 };
+    };
+
+    int countMismatchedPixels(const ImagePtr& image, const ImagePtr& golden, int tolerance)
+    {
+        if (image->getSize() != golden->getSize() || image->getBpp() != golden->getBpp())
+            return image->getPixelCount();
+
+        const int bpp = image->getBpp();
+        const uint8_t* a = image->getPixelData();
+        const uint8_t* b = golden->getPixelData();
+
+        int mismatched = 0;
+        for (int p = 0; p < image->getPixelCount(); ++p) {
+            for (int c = 0; c < bpp; ++c) {
+                if (std::abs(a[p * bpp + c] - b[p * bpp + c]) > tolerance) {
+                    ++mismatched;
+                    break;
+                }
+            }
+        }
+        return mismatched;
+    }
+
+    void captureFrame(const std::string& name, const Options& options, GoldenStats& golden)
+    {
+        const ImagePtr image = g_graphics.readScreen();
+        const std::string file = name + ".png";
+
+        if (!options.captureDir.empty())
+            image->savePNG(options.captureDir + "/" + file);
+
+        if (options.goldenDir.empty())
+            return;
+
+        const auto& goldenFile = options.goldenDir + "/" + file;
+        if (!g_resources.fileExists(goldenFile)) {
+            ++golden.missing;
+            return;
+        }
+
+        const ImagePtr goldenImage = Image::load(goldenFile);
+        const int mismatched = goldenImage ? countMismatchedPixels(image, goldenImage, options.tolerance) : image->getPixelCount();
+
+        ++golden.compared;
+        if (mismatched > 0) {
+            ++golden.mismatchedFrames;
+            g_logger.warning(stdext::format("frame '%s' differs from its golden image on %d pixels", name, mismatched));
+        }
+        golden.maxMismatchedPixels = std::max<int>(golden.maxMismatchedPixels, mismatched);
+    }
+
+    // moves the camera for a given frame, returns true when it changed
+    using CameraPath = std::function<bool(const MapViewPtr&, int frame)>;
+
+    CameraPath walkPath(const Position& start)
+    {
+        // walk a square of 10x10 tiles, one step every 8 frames
+        return [start](const MapViewPtr& mapView, const int frame) {
+            if (frame % 8 != 0)
+                return false;
+
+            const int step = (frame / 8) % 40;
+            Position pos = start;
+            if (step < 10) pos.x += step;
+            else if (step < 20) { pos.x += 10; pos.y += step - 10; }
+            else if (step < 30) { pos.x += 30 - step; pos.y += 10; }
+            else pos.y += 40 - step;
+
+            mapView->setCameraPosition(pos);
+            g_map.setCentralPosition(pos);
+            return true;
+        };
+    }
+
+    CameraPath floorPath(const Position& start)
+    {
+        // goes up and down the surrounding floors, one floor every 30 frames
+        static constexpr std::array<int, 6> offsets{ 0, -1, -2, -1, 0, 1 };
+
+        return [start](const MapViewPtr& mapView, const int frame) {
+            if (frame % 30 != 0)
+                return false;
+
+            Position pos = start;
+            pos.z = std::clamp<int>(start.z + offsets[(frame / 30) % offsets.size()], 0, MAX_Z);
+
+            mapView->setCameraPosition(pos);
+            g_map.setCentralPosition(pos);
+            return true;
+        };
+    }
+
+    CameraPath zoomPath()
+    {
+        // cycles through the zoom levels available on the game interface, one every 30 frames
+        static constexpr std::array<std::pair<int, int>, 5> dimensions{ {
+            { 15, 11 }, { 19, 15 }, { 23, 17 }, { 31, 23 }, { 19, 15 }
+        } };
+
+        return [](const MapViewPtr& mapView, const int frame) {
+            if (frame % 30 != 0)
+                return false;
+
+            const auto& [width, height] = dimensions[(frame / 30) % dimensions.size()];
+            mapView->setVisibleDimension(Size(width, height));
+            return true;
+        };
+    }
+
+    nlohmann::json runScenario(const std::string& name, const CameraPath& path, const Position& start, const Options& options)
+    {
+        const MapViewPtr mapView(new MapView);
+        mapView->setLimitVisibleDimension(false);
+        mapView->setVisibleDimension(Size(15, 11));
+        mapView->setCameraPosition(start);
+        g_map.addMapView(mapView);
+        g_map.setCentralPosition(start);
+
+        const Rect rect(Point(), options.size);
+        const auto* const mapPool = g_drawPool.get<DrawPool>(DrawPoolType::MAP);
+
+        bench::Samples record, recordMoved, submit, objects, tiles, allocCount, allocBytes, drawCalls, reorderMerges, stateChanges, vertices, instances, streamed, painterDrawCalls, textureChanges;
+        for (auto* samples : { &record, &submit, &objects, &tiles, &allocCount, &allocBytes, &drawCalls, &reorderMerges, &stateChanges, &vertices, &instances, &streamed, &painterDrawCalls, &textureChanges })
+            samples->reserve(options.frames);
+
+        auto* const nullPainter = options.nullPainter ? static_cast<NullPainter*>(g_painter) : nullptr;
+
+        const bool capturing = options.submit && (!options.captureDir.empty() || !options.goldenDir.empty());
+        GoldenStats golden;
+
+        stdext::timer timer;
+        for (int frame = -1; ++frame < options.frames;) {
+            g_clock.update();
+            g_dispatcher.poll();
+
+            const bool moved = path(mapView, frame);
+            const auto allocBefore = bench::allocations();
+
+            timer.restart();
+            mapView->draw(rect);
+            const auto recordTime = timer.elapsed_micros();
+
+            (moved ? recordMoved : record).add(recordTime);
+            objects.add(mapPool->getObjectsCount());
+            tiles.add(mapView->getVisibleTilesCount());
+
+            if (options.submit) {
+                if (nullPainter)
+                    nullPainter->resetStats();
+
+                timer.restart();
+                g_drawPool.draw();
+                if (!nullPainter)
+                    glFinish();
+                submit.add(timer.elapsed_micros());
+
+                // every pool reaches the painter, not only the map one
+                if (nullPainter) {
+                    painterDrawCalls.add(nullPainter->getStats().drawCalls);
+                    textureChanges.add(nullPainter->getStats().textureChanges);
+                }
+
+                const auto& stats = mapPool->getStats();
+                drawCalls.add(stats.drawCalls);
+                reorderMerges.add(stats.reorderMerges);
+                stateChanges.add(stats.stateChanges);
+                vertices.add(stats.verticesUploaded);
+                instances.add(stats.instances);
+                streamed.add(stats.bytesStreamed);
+            }
+
+            const auto allocs = bench::allocations() - allocBefore;
+            allocCount.add(allocs.count);
+            allocBytes.add(allocs.bytes);
+
+            if (capturing && frame % options.captureEvery == 0)
+                captureFrame(stdext::format("%s_%04d", name, frame), options, golden);
+        }
+
+        g_map.removeMapView(mapView);
+
+        nlohmann::json result = {
+            { "scenario", name },
+            { "frames", options.frames },
+            { "record_us", record.toJson() },
+            { "record_camera_change_us", recordMoved.toJson() },
+            { "draw_objects", objects.toJson() },
+            { "visible_tiles", tiles.toJson() },
+            { "allocations", allocCount.toJson() },
+            { "allocated_bytes", allocBytes.toJson() }
+        };
+
+        if (options.submit) {
+            result["submit_us"] = submit.toJson();
+            result["draw_calls"] = drawCalls.toJson();
+            result["draw_calls_saved_by_reorder"] = reorderMerges.toJson();
+            result["state_changes"] = stateChanges.toJson();
+            result["vertices_uploaded"] = vertices.toJson();
+            result["instanced_rects"] = instances.toJson();
+            result["bytes_streamed"] = streamed.toJson();
+
+            if (nullPainter) {
+                result["painter_draw_calls"] = painterDrawCalls.toJson();
+                result["painter_texture_changes"] = textureChanges.toJson();
+            }
+        }
+
+        if (capturing) {
+            result["captured_frames"] = options.frames / options.captureEvery + (options.frames % options.captureEvery ? 1 : 0);
+            if (!options.goldenDir.empty()) {
+                result["golden"] = {
+                    { "compared", golden.compared },
+                    { "missing", golden.missing },
+                    { "mismatched_frames", golden.mismatchedFrames },
+                    { "max_mismatched_pixels", golden.maxMismatchedPixels }
+                };
+            }
+        }
+
+        return result;
+    }
+
+    bool loadAssets(const std::vector<std::string>& args, const int version)
+    {
+        if (!bench::loadThings(args, version))
+            return false;
+
+        const auto& map = bench::getArg(args, "--map");
+        if (map.ends_with(".otcm"))
+            return g_map.loadOtcm(map);
+
+        g_things.loadOtb(bench::getArg(args, "--otb", stdext::format("/data/things/%d/items.otb", version)));
+        g_map.loadOtbm(map);
+        return true;
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    std::vector<std::string> args(argv, argv + argc);
+
+    g_app.setName("OTClient - Benchmark");
+    g_app.setCompactName("otclient");
+    g_app.setOrganizationName("otbr");
+
+    // must be known before the window and the context would be created
+    const bool nullPainter = bench::hasArg(args, "--null-painter");
+    g_graphics.setNullBackend(nullPainter);
+
+    g_app.init(args);
+    Client::init(args);
+
+    if (!g_resources.discoverWorkDir("init.lua"))
+        g_logger.fatal("Unable to find work directory, the benchmark cannot be initialized.");
+
+    const int version = stdext::from_string<int>(bench::getArg(args, "--version"));
+    if (version == 0 || bench::getArg(args, "--map").empty())
+        g_logger.fatal("usage: otclient_bench --version <version> --map <file> --position <x,y,z> [--scenario walk|floor|zoom|all] [--frames n] [--size wxh] [--no-submit] [--null-painter] [--out file]");
+
+    if (!loadAssets(args, version))
+        g_logger.fatal("Unable to load the client assets or the map.");
+
+    const auto& coords = stdext::split<int>(bench::getArg(args, "--position", "1000,1000,7"), ",");
+    if (coords.size() != 3)
+        g_logger.fatal("Invalid position, expected x,y,z");
+
+    const Position start(coords[0], coords[1], coords[2]);
+
+    Options options;
+    options.frames = std::max<int>(1, stdext::from_string<int>(bench::getArg(args, "--frames", "600")));
+    options.submit = !bench::hasArg(args, "--no-submit");
+    options.nullPainter = nullPainter;
+
+    const auto& size = stdext::split<int>(bench::getArg(args, "--size", "960x704"), "x");
+    if (size.size() == 2)
+        options.size = Size(size[0], size[1]);
+
+    options.captureDir = bench::getArg(args, "--capture");
+    options.goldenDir = bench::getArg(args, "--golden");
+    options.captureEvery = std::max<int>(1, stdext::from_string<int>(bench::getArg(args, "--capture-every", "60")));
+    options.tolerance = std::max<int>(0, stdext::from_string<int>(bench::getArg(args, "--tolerance", "2")));
+
+    if (nullPainter && (!options.captureDir.empty() || !options.goldenDir.empty()))
+        g_logger.fatal("--capture and --golden read the screen back, they need a GL context and can not be used with --null-painter");
+
+    // golden images only match when every frame sees the same clock
+    if (!options.captureDir.empty() || !options.goldenDir.empty() || bench::hasArg(args, "--fixed-step"))
+        g_clock.setFixedTimestep(std::max<int>(1, stdext::from_string<int>(bench::getArg(args, "--fixed-step", "16667"))));
+
+    // A/B switches for the batching, instancing and vertex streaming paths, golden images must match either way
+    if (bench::hasArg(args, "--no-reorder"))
+        g_drawPool.setReorderDrawings(DrawPoolType::MAP, false);
+    if (bench::hasArg(args, "--no-instancing"))
+        g_drawPool.setInstancing(false);
+    if (bench::hasArg(args, "--no-streaming"))
+        g_drawPool.setStreamingVertices(false);
+
+    const auto& scenario = bench::getArg(args, "--scenario", "all");
+
+    nlohmann::json report = {
+        { "benchmark", "map" },
+        { "version", version },
+        { "map", bench::getArg(args, "--map") },
+        { "position", { start.x, start.y, start.z } },
+        { "size", { options.size.width(), options.size.height() } },
+        { "submit", options.submit },
+        { "painter", nullPainter ? "null" : "gl" },
+        { "reorder", g_drawPool.isReorderingDrawings(DrawPoolType::MAP) },
+        { "instancing", g_drawPool.isInstancing() && g_painter->canDrawInstanced() },
+        { "vertex_streaming", g_drawPool.isStreamingVertices() },
+        { "fixed_step_us", g_clock.getFixedTimestep() },
+        { "results", nlohmann::json::array() }
+    };
+
+    if (scenario == "all" || scenario == "walk")
+        report["results"].push_back(runScenario("walk", walkPath(start), start, options));
+    if (scenario == "all" || scenario == "floor")
+        report["results"].push_back(runScenario("floor", floorPath(start), start, options));
+    if (scenario == "all" || scenario == "zoom")
+        report["results"].push_back(runScenario("zoom", zoomPath(), start, options));
+
+    bench::writeReport(args, report);
+
+    Client::terminate();
+    g_app.terminate();
+    return 0;
+}
@@ -0,0 +1,506 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+ /*
+  * Microbenchmarks for the framework primitives the client is built on.
+  *
+  * Every case runs its operation in batches sized to last at least
+  * --min-batch-us, and reports the nanoseconds and allocations per operation
+  * over --batches batches. Cases that need data missing from the work
+  * directory (e.g. no --otbm map) are reported as skipped.
+  *
+  * Usage:
+  *   otclient_microbench [--filter name] [--batches 30] [--min-batch-us 2000]
+  *                       [--otbm /data/maps/forgotten.otbm] [--out report.json]
+  *
+  * Like the map benchmark it creates a (hidden) window, the fonts need a GL
+  * context for their textures.
+  */
+
+#include "benchmark.h"
+
+#include <client/client.h>
+#include <client/map.h>
+#include <client/tile.h>
+#include <framework/core/application.h>
+#include <framework/core/binarytree.h>
+#include <framework/core/clock.h>
+#include <framework/core/eventdispatcher.h>
+#include <framework/core/filestream.h>
+#include <framework/core/resourcemanager.h>
+#include <framework/graphics/bitmapfont.h>
+#include <framework/graphics/fontmanager.h>
+#include <framework/graphics/image.h>
+#include <framework/net/inputmessage.h>
+#include <framework/net/outputmessage.h>
+#include <framework/net/protocol.h>
+#include <framework/otml/otmldocument.h>
+
+#include <chrono>
+#include <queue>
+
+namespace
+{
+    class Suite
+    {
+    public:
+        Suite(const std::vector<std::string>& args) :
+            m_filter(bench::getArg(args, "--filter")),
+            m_batches(std::max<int>(1, stdext::from_string<int>(bench::getArg(args, "--batches", "30")))),
+            m_minBatchTime(std::max<int64_t>(1, stdext::from_string<int64_t>(bench::getArg(args, "--min-batch-us", "2000"))) * 1000)
+        {}
+
+        bool accepts(const std::string_view name) const { return m_filter.empty() || name.find(m_filter) != std::string_view::npos; }
+
+        // operation(iterations) must run the measured operation that many times
+        template<typename F>
+        void run(const std::string& name, const F& operation)
+        {
+            if (!accepts(name))
+                return;
+
+            // doubles the batch until it is long enough for the clock resolution
+            uint64_t iterations = 1;
+            while (measure(operation, iterations) < m_minBatchTime && iterations < (1ull << 30))
+                iterations *= 2;
+
+            bench::Samples time, allocations;
+            time.reserve(m_batches);
+            allocations.reserve(m_batches);
+
+            for (int i = -1; ++i < m_batches;) {
+                const auto before = bench::allocations();
+                const int64_t elapsed = measure(operation, iterations);
+                const auto allocs = bench::allocations() - before;
+
+                time.add(static_cast<double>(elapsed) / iterations);
+                allocations.add(static_cast<double>(allocs.count) / iterations);
+            }
+
+            m_results.push_back({
+                { "name", name },
+                { "iterations", iterations },
+                { "batches", m_batches },
+                { "ns_per_op", time.toJson() },
+                { "allocations_per_op", allocations.average() }
+            });
+        }
+
+        void skip(const std::string& name, const std::string& reason)
+        {
+            if (accepts(name))
+                m_results.push_back({ { "name", name }, { "skipped", reason } });
+        }
+
+        const nlohmann::json& results() const { return m_results; }
+
+    private:
+        template<typename F>
+        static int64_t measure(const F& operation, uint64_t iterations)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            operation(iterations);
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        std::string m_filter;
+        int m_batches;
+        int64_t m_minBatchTime; // nanoseconds
+        nlohmann::json m_results = nlohmann::json::array();
+    };
+
+    // exposes the xtea routines, they are only reachable from protocols
+    class XteaProtocol : public Protocol
+    {
+    public:
+        using Protocol::xteaDecrypt;
+        using Protocol::xteaEncrypt;
+    };
+
+    void inputMessageCases(Suite& suite)
+    {
+        const InputMessagePtr msg(new InputMessage);
+        msg->setBuffer(std::string(InputMessage::BUFFER_MAXSIZE - InputMessage::MAX_HEADER_SIZE - 2, '\x2A'));
+
+        const auto rewind = [&msg] { msg->setReadPos(InputMessage::MAX_HEADER_SIZE); };
+
+        suite.run("input_message_get_u8", [&](uint64_t iterations) {
+            rewind();
+            for (uint64_t i = 0; i < iterations; ++i) {
+                if (msg->eof()) rewind();
+                bench::doNotOptimize(msg->getU8());
+            }
+        });
+
+        suite.run("input_message_get_u16", [&](uint64_t iterations) {
+            rewind();
+            for (uint64_t i = 0; i < iterations; ++i) {
+                if (msg->getUnreadSize() < 2) rewind();
+                bench::doNotOptimize(msg->getU16());
+            }
+        });
+
+        // 16 byte strings prefixed by their length, like creature names and texts
+        std::string strings;
+        while (strings.size() + 18 < InputMessage::BUFFER_MAXSIZE - InputMessage::MAX_HEADER_SIZE)
+            strings += std::string("\x10\x00", 2) + "sixteen chars...";
+
+        msg->setBuffer(strings);
+        suite.run("input_message_get_string", [&](uint64_t iterations) {
+            rewind();
+            for (uint64_t i = 0; i < iterations; ++i) {
+                if (msg->eof()) rewind();
+                bench::doNotOptimize(msg->getString());
+            }
+        });
+    }
+
+    void xteaCases(Suite& suite)
+    {
+        const auto protocol = stdext::shared_object_ptr<XteaProtocol>(new XteaProtocol);
+        protocol->generateXteaKey();
+
+        const OutputMessagePtr out(new OutputMessage);
+        const auto fill = [&out] {
+            out->reset();
+            out->addPaddingBytes(1024, 0x42);
+        };
+
+        suite.run("xtea_encrypt_1k", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                fill();
+                protocol->xteaEncrypt(out);
+            }
+        });
+
+        fill();
+        protocol->xteaEncrypt(out);
+        const std::string encrypted(out->getBuffer());
+
+        // includes copying the 1k message back, decryption works in place
+        const InputMessagePtr in(new InputMessage);
+        suite.run("xtea_decrypt_1k", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                in->setBuffer(encrypted);
+                in->setReadPos(InputMessage::MAX_HEADER_SIZE);
+                bench::doNotOptimize(protocol->xteaDecrypt(in));
+            }
+        });
+    }
+
+    void otmlCases(Suite& suite)
+    {
+        std::vector<std::pair<std::string, std::string>> styles;
+        size_t bytes = 0;
+        for (const auto& file : g_resources.listDirectoryFiles("/data/styles")) {
+            if (!file.ends_with(".otui"))
+                continue;
+
+            const std::string path = "/data/styles/" + file;
+            styles.emplace_back(path, g_resources.readFileContents(path));
+            bytes += styles.back().second.size();
+        }
+
+        if (styles.empty()) {
+            suite.skip("otml_parse_styles", "no styles found in /data/styles");
+            return;
+        }
+
+        // one operation parses every style file, already loaded in memory
+        suite.run(stdext::format("otml_parse_styles(%d files, %d KB)", static_cast<int>(styles.size()), static_cast<int>(bytes / 1024)), [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                for (const auto& [path, contents] : styles) {
+                    std::istringstream in(contents);
+                    bench::doNotOptimize(OTMLDocument::parse(in, path));
+                }
+            }
+        });
+    }
+
+    uint32_t countNodes(const BinaryTreePtr& node)
+    {
+        uint32_t count = 1;
+        for (const auto& child : node->getChildren())
+            count += countNodes(child);
+        return count;
+    }
+
+    void binaryTreeCases(Suite& suite, const std::string& otbm)
+    {
+        if (!g_resources.fileExists(otbm)) {
+            suite.skip("binary_tree_traverse_otbm", "map '" + otbm + "' not found, use --otbm");
+            return;
+        }
+
+        const FileStreamPtr fin(new FileStream(otbm, g_resources.readFileContents(otbm)));
+
+        // one operation walks every node of the map, skipping the 4 bytes identifier
+        suite.run("binary_tree_traverse_otbm", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                fin->seek(4);
+                bench::doNotOptimize(countNodes(fin->getBinaryTree()));
+            }
+        });
+    }
+
+    void fileStreamCases(Suite& suite)
+    {
+        const FileStreamPtr fin(new FileStream("cached", std::string(65536, '\x2A')));
+        const uint32_t end = fin->size() - 4;
+
+        suite.run("file_stream_get_u32_cached", [&](uint64_t iterations) {
+            fin->seek(0);
+            for (uint64_t i = 0; i < iterations; ++i) {
+                if (fin->tell() > end) fin->seek(0);
+                bench::doNotOptimize(fin->getU32());
+            }
+        });
+    }
+
+    void imageCases(Suite& suite)
+    {
+        const ImagePtr canvas(new Image(Size(256)));
+        const ImagePtr sprite(new Image(Size(32)));
+        for (int p = 0; p < sprite->getPixelCount(); ++p) {
+            // a sprite with a transparent border, like most of them
+            const bool border = p % 32 < 4 || p % 32 >= 28;
+            std::memcpy(sprite->getPixelData() + p * 4, border ? "\0\0\0\0" : "\x80\x40\x20\xFF", 4);
+        }
+
+        suite.run("image_blit_32x32", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i)
+                canvas->blit(Point((i * 32) % 256, (i / 8 * 32) % 256), sprite);
+        });
+
+        // outfit masks have one color per body part
+        const ImagePtr mask(new Image(Size(64)));
+        static constexpr std::array<uint32_t, 4> colors{ 0xFF0000FF, 0xFF00FF00, 0xFFFF0000, 0xFF00FFFF };
+        for (int p = 0; p < mask->getPixelCount(); ++p)
+            std::memcpy(mask->getPixelData() + p * 4, &colors[(p / 64 / 16) % colors.size()], 4);
+
+        const std::vector<uint8_t> pixels = mask->getPixels();
+
+        // includes restoring the 16 KB of pixels, the mask is applied in place
+        suite.run("image_overwrite_mask_64x64", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                mask->getPixels() = pixels;
+                mask->overwriteMask(Color::red);
+            }
+        });
+    }
+
+    void mapCases(Suite& suite)
+    {
+        if (!suite.accepts("map_get_tile"))
+            return;
+
+        // 256x256 tiles around the temple, lookups land on a 320x320 area so some of them miss
+        const Position origin(1000, 1000, 7);
+        for (int x = -1; ++x < 256;)
+            for (int y = -1; ++y < 256;)
+                g_map.createTile(origin.translated(x, y));
+
+        suite.run("map_get_tile", [&](uint64_t iterations) {
+            uint32_t seed = 12345;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                seed = seed * 1103515245 + 12345;
+                const Position pos = origin.translated((seed >> 8) % 320, (seed >> 20) % 320);
+                bench::doNotOptimize(g_map.getTile(pos).get());
+            }
+        });
+
+        g_map.clean();
+    }
+
+    // the scheduled event queue used before ScheduledEventQueue, canceled events stay in it until their ticks
+    class LazyCancelScheduler
+    {
+    public:
+        ScheduledEventPtr schedule(const std::function<void()>& callback, int delay)
+        {
+            ScheduledEventPtr event(new ScheduledEvent(callback, delay, 1));
+            m_queue.push(event);
+            return event;
+        }
+
+        void poll()
+        {
+            for (int count = 0, max = m_queue.size(); count < max && !m_queue.empty(); ++count) {
+                const ScheduledEventPtr event = m_queue.top();
+                if (event->remainingTicks() > 0)
+                    break;
+                m_queue.pop();
+                event->execute();
+            }
+        }
+
+        void clear() { m_queue = {}; }
+
+    private:
+        struct Compare
+        {
+            bool operator() (const ScheduledEventPtr& a, const ScheduledEventPtr& b) const { return b->ticks() < a->ticks(); }
+        };
+
+        std::priority_queue<ScheduledEventPtr, std::deque<ScheduledEventPtr>, Compare> m_queue;
+    };
+
+    // 1000 creatures walking at once, each step cancels the pending walk update and schedules the next one,
+    // like Creature::nextWalkUpdate; a 16 ms frame (clock step + poll) passes after every 1000 steps
+    template<typename Schedule, typename Poll>
+    void runWalkers(Suite& suite, const std::string& name, const Schedule& schedule, const Poll& poll)
+    {
+        constexpr int WALKERS = 1000;
+        std::vector<ScheduledEventPtr> walkUpdates(WALKERS);
+        int fired = 0;
+
+        suite.run(name, [&](uint64_t iterations) {
+            uint32_t seed = 12345;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                auto& walkUpdate = walkUpdates[i % WALKERS];
+                if (walkUpdate)
+                    walkUpdate->cancel();
+
+                seed = seed * 1103515245 + 12345;
+                walkUpdate = schedule([&fired] { ++fired; }, 50 + (seed >> 16) % 400);
+
+                if (i % WALKERS == WALKERS - 1) {
+                    g_clock.update();
+                    poll();
+                }
+            }
+        });
+
+        for (const auto& walkUpdate : walkUpdates) {
+            if (walkUpdate)
+                walkUpdate->cancel();
+        }
+        bench::doNotOptimize(fired);
+    }
+
+    void schedulerCases(Suite& suite)
+    {
+        g_clock.setFixedTimestep(16000);
+
+        // every poll has to drain what the iteration queued
+        const int pollBudget = g_dispatcher.getPollBudget();
+        g_dispatcher.setPollBudget(0);
+
+        LazyCancelScheduler lazy;
+        runWalkers(suite, "scheduler_walkers_1k_lazy_cancel", [&lazy](const std::function<void()>& callback, int delay) {
+            return lazy.schedule(callback, delay);
+        }, [&lazy] { lazy.poll(); });
+        lazy.clear();
+
+        runWalkers(suite, "scheduler_walkers_1k_dispatcher", [](const std::function<void()>& callback, int delay) {
+            return g_dispatcher.scheduleEvent(callback, delay);
+        }, [] { g_dispatcher.poll(); });
+
+        // fire and forget events capturing a ref counted object, like the [self] of the effect removals;
+        // allocations_per_op shows the pooled path does not allocate once warm
+        const auto self = stdext::shared_object_ptr<XteaProtocol>(new XteaProtocol);
+        int executed = 0;
+        suite.run("dispatcher_add_event", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i)
+                g_dispatcher.addEvent([self, &executed] { ++executed; });
+            g_dispatcher.poll();
+        });
+
+        suite.run("dispatcher_add_task", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i)
+                g_dispatcher.addTask([self, &executed] { ++executed; });
+            g_dispatcher.poll();
+        });
+
+        suite.run("dispatcher_schedule_task", [&](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i)
+                g_dispatcher.scheduleTask([self, &executed] { ++executed; }, 0);
+            g_dispatcher.poll();
+        });
+        bench::doNotOptimize(executed);
+
+        g_dispatcher.setPollBudget(pollBudget);
+        g_clock.setFixedTimestep(0);
+        g_clock.update();
+    }
+
+    void fontCases(Suite& suite)
+    {
+        if (!g_fonts.importFont("/data/fonts/verdana-11px-rounded")) {
+            suite.skip("bitmap_font_calculate_glyphs_positions", "unable to load /data/fonts/verdana-11px-rounded");
+            return;
+        }
+
+        const BitmapFontPtr font = g_fonts.getFont("verdana-11px-rounded");
+
+        // a server message sized text with line breaks
+        const std::string text =
+            "You see a magic plate armor (Arm:17).\n"
+            "It weighs 85.00 oz.\n"
+            "An enchanted gem glows on the plate armor. Ancient runes are engraved all over it, "
+            "protecting its wearer from physical and magic damage.";
+
+        for (const auto align : { Fw::AlignTopLeft, Fw::AlignCenter }) {
+            suite.run(align == Fw::AlignTopLeft ? "bitmap_font_calculate_glyphs_positions" : "bitmap_font_calculate_glyphs_positions_centered", [&](uint64_t iterations) {
+                Size textBoxSize;
+                for (uint64_t i = 0; i < iterations; ++i)
+                    bench::doNotOptimize(font->calculateGlyphsPositions(text, align, &textBoxSize).size());
+            });
+        }
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    std::vector<std::string> args(argv, argv + argc);
+
+    g_app.setName("OTClient - Microbenchmark");
+    g_app.setCompactName("otclient");
+    g_app.setOrganizationName("otbr");
+
+    g_app.init(args);
+    Client::init(args);
+
+    if (!g_resources.discoverWorkDir("init.lua"))
+        g_logger.fatal("Unable to find work directory, the benchmark cannot be initialized.");
+
+    Suite suite(args);
+
+    inputMessageCases(suite);
+    xteaCases(suite);
+    otmlCases(suite);
+    binaryTreeCases(suite, bench::getArg(args, "--otbm", "/data/maps/forgotten.otbm"));
+    fileStreamCases(suite);
+    imageCases(suite);
+    mapCases(suite);
+    fontCases(suite);
+    schedulerCases(suite);
+
+    bench::writeReport(args, {
+        { "benchmark", "micro" },
+        { "results", suite.results() }
+    });
+
+    Client::terminate();
+    g_app.terminate();
+    return 0;
+}
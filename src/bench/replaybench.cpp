@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+ /*
+  * Offline protocol replay benchmark.
+  *
+  * Feeds a session captured with g_game.startPacketRecording() back through
+  * ProtocolGame without any network, either as fast as possible or following
+  * the recorded timestamps, and reports the parse throughput and the parse
+  * time of every opcode.
+  *
+  * Usage:
+  *   otclient_replay --recording session.otpr [--realtime] [--repeat 1]
+  *                   [--things /data/things/1098/Tibia] [--out report.json]
+  */
+
+#include "benchmark.h"
+
+#include <client/client.h>
+#include <client/game.h>
+#include <framework/core/application.h>
+#include <framework/core/clock.h>
+#include <framework/core/eventdispatcher.h>
+#include <framework/core/resourcemanager.h>
+#include <framework/net/inputmessage.h>
+#include <framework/net/packetrecorder.h>
+
+namespace
+{
+    void poll()
+    {
+        g_clock.update();
+        g_dispatcher.poll();
+    }
+
+    nlohmann::json replay(const PacketRecorder::Recording& recording, const bool realtime)
+    {
+        const ProtocolGamePtr protocol = g_game.startReplay("Replay");
+        protocol->setOpcodeStatsEnabled(true);
+
+        const InputMessagePtr msg(new InputMessage);
+        bench::Samples parseTimes;
+        parseTimes.reserve(recording.packets.size());
+
+        uint64_t bytes = 0;
+        stdext::timer wallTimer, parseTimer;
+        for (const auto& packet : recording.packets) {
+            if (realtime) {
+                while (wallTimer.elapsed_millis() < packet.time) {
+                    poll();
+                    stdext::millisleep(1);
+                }
+            }
+
+            msg->setBuffer(packet.data);
+            msg->setReadPos(InputMessage::MAX_HEADER_SIZE);
+
+            parseTimer.restart();
+            protocol->replayMessage(msg);
+            parseTimes.add(parseTimer.elapsed_micros());
+            bytes += packet.data.size();
+
+            // let the events scheduled by the parser run, as they would between frames
+            poll();
+        }
+
+        const double wallSeconds = wallTimer.elapsed_micros() / 1000000.0;
+        const double parseSeconds = parseTimes.total() / 1000000.0;
+
+        nlohmann::json opcodes = nlohmann::json::array();
+        const auto& stats = protocol->getOpcodeStats();
+        for (int opcode = -1; ++opcode < static_cast<int>(stats.size());) {
+            const auto& stat = stats[opcode];
+            if (stat.count == 0)
+                continue;
+
+            opcodes.push_back({
+                { "opcode", opcode },
+                { "count", stat.count },
+                { "bytes", stat.bytes },
+                { "total_us", stat.time },
+                { "avg_us", static_cast<double>(stat.time) / stat.count },
+                { "max_us", stat.maxTime },
+                { "lua_claims", stat.luaClaims }
+            });
+        }
+
+        std::sort(opcodes.begin(), opcodes.end(), [](const auto& a, const auto& b) {
+            return a["total_us"].template get<ticks_t>() > b["total_us"].template get<ticks_t>();
+        });
+
+        g_game.stopReplay();
+
+        return {
+            { "messages", recording.packets.size() },
+            { "bytes", bytes },
+            { "wall_seconds", wallSeconds },
+            { "parse_seconds", parseSeconds },
+            { "messages_per_second", parseSeconds > 0 ? recording.packets.size() / parseSeconds : 0 },
+            { "bytes_per_second", parseSeconds > 0 ? bytes / parseSeconds : 0 },
+            { "message_parse_us", parseTimes.toJson() },
+            { "opcodes", opcodes }
+        };
+    }
+}
+
+int main(int argc, const char* argv[])
+{
+    std::vector<std::string> args(argv, argv + argc);
+
+    g_app.setName("OTClient - Replay");
+    g_app.setCompactName("otclient");
+    g_app.setOrganizationName("otbr");
+
+    g_app.init(args);
+    Client::init(args);
+
+    if (!g_resources.discoverWorkDir("init.lua"))
+        g_logger.fatal("Unable to find work directory, the benchmark cannot be initialized.");
+
+    const auto& file = bench::getArg(args, "--recording");
+    if (file.empty())
+        g_logger.fatal("usage: otclient_replay --recording <file> [--realtime] [--repeat n] [--things path] [--out file]");
+
+    PacketRecorder::Recording recording;
+    try {
+        recording = PacketRecorder::load(file);
+    } catch (const stdext::exception& e) {
+        g_logger.fatal(stdext::format("Unable to load packet recording: %s", e.what()));
+    }
+
+    if (!bench::loadThings(args, recording.clientVersion))
+        g_logger.fatal("Unable to load the client assets.");
+
+    // restore the exact features the session was recorded with
+    g_game.setProtocolVersion(recording.protocolVersion);
+    for (size_t i = 0; i < recording.features.size() && i < Otc::LastGameFeature; ++i)
+        g_game.setFeature(static_cast<Otc::GameFeature>(i), recording.features[i]);
+
+    const bool realtime = bench::hasArg(args, "--realtime");
+    const int repeat = std::max<int>(1, stdext::from_string<int>(bench::getArg(args, "--repeat", "1")));
+
+    nlohmann::json report = {
+        { "benchmark", "replay" },
+        { "recording", file },
+        { "client_version", recording.clientVersion },
+        { "protocol_version", recording.protocolVersion },
+        { "realtime", realtime },
+        { "results", nlohmann::json::array() }
+    };
+
+    for (int i = -1; ++i < repeat;)
+        report["results"].push_back(replay(recording, realtime));
+
+    bench::writeReport(args, report);
+
+    Client::terminate();
+    g_app.terminate();
+    return 0;
+}
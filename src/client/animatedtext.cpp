@@ -73,7 +73,7 @@ void AnimatedText::onAppear()
 
     // schedule removal
     auto self = asAnimatedText();
-    g_dispatcher.scheduleEvent([self] { g_map.removeThing(self); }, textDuration);
+    g_dispatcher.scheduleTask([self] { g_map.removeThing(self); }, textDuration);
 }
 
 bool AnimatedText::merge(const AnimatedTextPtr& other)
@@ -32,6 +32,7 @@
 
 #include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/memorytracker.h>
 #include <framework/graphics/drawpoolmanager.h>
 #include <framework/graphics/graphics.h>
 #include <framework/graphics/texturemanager.h>
@@ -46,6 +47,8 @@ Creature::Creature() :m_type(Proto::CreatureTypeUnknown)
     m_nameCache.setAlign(Fw::AlignTopCenter);
     m_speedFormula.fill(-1);
 
+    g_memory.add(MemoryTracker::CREATURES, sizeof(Creature));
+
     // Example of how to send a UniformValue to shader
     /*
     m_shaderAction = [=]()-> void {
@@ -61,6 +64,8 @@ Creature::Creature() :m_type(Proto::CreatureTypeUnknown)
     */
 }
 
+Creature::~Creature() { g_memory.remove(MemoryTracker::CREATURES, sizeof(Creature)); }
+
 void Creature::draw(const Point& dest, float scaleFactor, bool animate, uint32_t flags, const Highlight& highLight, TextureType textureType, Color color, LightView* lightView)
 {
     if (!canBeSeen())
@@ -401,7 +406,7 @@ void Creature::updateJump()
 
     // schedules next update
     const auto self = static_self_cast<Creature>();
-    g_dispatcher.scheduleEvent([self] {
+    g_dispatcher.scheduleTask([self] {
         self->updateJump();
     }, nextT - m_jumpTimer.ticksElapsed());
 }
@@ -791,7 +796,7 @@ void Creature::setShieldTexture(const std::string& filename, bool blink)
 
     if (blink && !m_shieldBlink) {
         auto self = static_self_cast<Creature>();
-        g_dispatcher.scheduleEvent([self] {
+        g_dispatcher.scheduleTask([self] {
             self->updateShield();
         }, SHIELD_BLINK_TICKS);
     }
@@ -806,7 +811,7 @@ void Creature::addTimedSquare(uint8_t color)
 
     // schedule removal
     const auto self = static_self_cast<Creature>();
-    g_dispatcher.scheduleEvent([self] {
+    g_dispatcher.scheduleTask([self] {
         self->removeTimedSquare();
     }, VOLATILE_SQUARE_DURATION);
 }
@@ -817,7 +822,7 @@ void Creature::updateShield()
 
     if (m_shield != Otc::ShieldNone && m_shieldBlink) {
         auto self = static_self_cast<Creature>();
-        g_dispatcher.scheduleEvent([self] {
+        g_dispatcher.scheduleTask([self] {
             self->updateShield();
         }, SHIELD_BLINK_TICKS);
     } else if (!m_shieldBlink)
@@ -37,6 +37,7 @@ public:
     static double speedA, speedB, speedC;
 
     Creature();
+    ~Creature() override;
 
     static bool hasSpeedFormula() { return speedA != 0 && speedB != 0 && speedC != 0; }
 
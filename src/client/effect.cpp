@@ -90,7 +90,7 @@ void Effect::onAppear()
 
     // schedule removal
     const auto self = asEffect();
-    g_dispatcher.scheduleEvent([self] { g_map.removeThing(self); }, m_duration);
+    g_dispatcher.scheduleTask([self] { g_map.removeThing(self); }, m_duration);
 
     generateBuffer();
 }
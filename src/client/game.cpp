@@ -30,6 +30,7 @@
 #include "protocolgame.h"
 #include <framework/core/application.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/net/packetrecorder.h>
 
 #include "framework/core/graphicalapplication.h"
 #include "tile.h"
@@ -43,6 +44,7 @@ void Game::init()
 
 void Game::terminate()
 {
+    stopPacketRecording();
     resetGameStates();
     m_protocolGame = nullptr;
 }
@@ -514,11 +516,58 @@ void Game::loginWorld(const std::string_view account, const std::string_view pas
     m_localPlayer->setName(characterName);
 
     m_protocolGame = ProtocolGamePtr(new ProtocolGame);
+    m_protocolGame->setRecorder(m_packetRecorder);
     m_protocolGame->login(account, password, worldHost, static_cast<uint16_t>(worldPort), characterName, authenticatorToken, sessionKey);
     m_characterName = characterName;
     m_worldName = worldName;
 }
 
+ProtocolGamePtr Game::startReplay(const std::string_view characterName)
+{
+    if (m_protocolGame || isOnline())
+        throw Exception("Unable to replay a session while already online or logging.");
+
+    resetGameStates();
+
+    m_localPlayer = LocalPlayerPtr(new LocalPlayer);
+    m_localPlayer->setName(characterName);
+
+    m_protocolGame = ProtocolGamePtr(new ProtocolGame);
+    m_protocolGame->m_localPlayer = m_localPlayer;
+    m_characterName = characterName;
+    return m_protocolGame;
+}
+
+void Game::startPacketRecording(const std::string& fileName)
+{
+    std::vector<bool> features(m_features.size());
+    for (size_t i = 0; i < m_features.size(); ++i)
+        features[i] = m_features.test(i);
+
+    try {
+        m_packetRecorder = std::make_shared<PacketRecorder>(fileName, m_clientVersion, m_protocolVersion, features);
+    } catch (const stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to start packet recording: %s", e.what()));
+        m_packetRecorder = nullptr;
+    }
+
+    if (m_protocolGame)
+        m_protocolGame->setRecorder(m_packetRecorder);
+}
+
+void Game::stopPacketRecording()
+{
+    if (!m_packetRecorder)
+        return;
+
+    if (m_protocolGame)
+        m_protocolGame->setRecorder(nullptr);
+
+    m_packetRecorder->close();
+    g_logger.info(stdext::format("Packet recording finished with %d packets.", m_packetRecorder->getPacketCount()));
+    m_packetRecorder = nullptr;
+}
+
 void Game::cancelLogin()
 {
     // send logout even if the game has not started yet, to make sure that the player doesn't stay logged there
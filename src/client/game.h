@@ -301,6 +301,15 @@ public:
     // otclient only
     void changeMapAwareRange(int xrange, int yrange);
 
+    // packet recording, start it before logging in so the replay has the whole session
+    void startPacketRecording(const std::string& fileName);
+    void stopPacketRecording();
+    bool isRecordingPackets() { return m_packetRecorder != nullptr; }
+
+    // starts an offline session fed by recorded packets instead of a connection
+    ProtocolGamePtr startReplay(const std::string_view characterName);
+    void stopReplay() { processDisconnect(); }
+
     // dynamic support for game features
     void enableFeature(Otc::GameFeature feature) { m_features.set(feature, true); }
     void disableFeature(Otc::GameFeature feature) { m_features.set(feature, false); }
@@ -417,6 +426,7 @@ private:
     ScheduledEventPtr m_pingEvent;
     ScheduledEventPtr m_walkEvent;
     ScheduledEventPtr m_checkConnectionEvent;
+    PacketRecorderPtr m_packetRecorder;
     bool m_connectionFailWarned;
     int m_protocolVersion{ 0 },
         m_clientVersion{ 0 },
@@ -33,9 +33,13 @@
 #include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
 #include <framework/core/filestream.h>
+#include <framework/core/memorytracker.h>
 
 #include "shadermanager.h"
 
+Item::Item() { g_memory.add(MemoryTracker::ITEMS, sizeof(Item)); }
+Item::~Item() { g_memory.remove(MemoryTracker::ITEMS, sizeof(Item)); }
+
 ItemPtr Item::create(int id)
 {
     ItemPtr item(new Item);
@@ -74,8 +74,8 @@ enum ItemAttr : uint8_t
 class Item : public Thing
 {
 public:
-    Item() = default;
-    ~Item() override = default;
+    Item();
+    ~Item() override;
 
     static ItemPtr create(int id);
     static ItemPtr createFromOtb(int id);
@@ -24,6 +24,7 @@
 #include "map.h"
 #include "mapview.h"
 #include "spritemanager.h"
+#include <framework/core/profiler.h>
 #include <framework/graphics/drawpoolmanager.h>
 
 LightView::LightView() : m_pool(g_drawPool.get<DrawPoolFramed>(DrawPoolType::LIGHT)) {}
@@ -49,6 +50,8 @@ void LightView::addLightSource(const Point& pos, const Light& light)
 
 void LightView::draw(const Rect& dest, const Rect& src)
 {
+    PROFILE_ZONE("LightView::draw");
+
     // draw light, only if there is darkness
     m_pool->setEnable(isDark());
     if (!isDark()) return;
@@ -129,6 +129,7 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_map", "removeCreatureById", &Map::removeCreatureById, &g_map);
     g_lua.bindSingletonFunction("g_map", "getSpectators", &Map::getSpectators, &g_map);
     g_lua.bindSingletonFunction("g_map", "findPath", &Map::findPath, &g_map);
+    g_lua.bindSingletonFunction("g_map", "findPathAsync", &Map::findPathAsyncLua, &g_map);
     g_lua.bindSingletonFunction("g_map", "loadOtbm", &Map::loadOtbm, &g_map);
     g_lua.bindSingletonFunction("g_map", "saveOtbm", &Map::saveOtbm, &g_map);
     g_lua.bindSingletonFunction("g_map", "loadOtcm", &Map::loadOtcm, &g_map);
@@ -273,6 +274,9 @@ void Client::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_game", "ping", &Game::ping, &g_game);
     g_lua.bindSingletonFunction("g_game", "setPingDelay", &Game::setPingDelay, &g_game);
     g_lua.bindSingletonFunction("g_game", "changeMapAwareRange", &Game::changeMapAwareRange, &g_game);
+    g_lua.bindSingletonFunction("g_game", "startPacketRecording", &Game::startPacketRecording, &g_game);
+    g_lua.bindSingletonFunction("g_game", "stopPacketRecording", &Game::stopPacketRecording, &g_game);
+    g_lua.bindSingletonFunction("g_game", "isRecordingPackets", &Game::isRecordingPackets, &g_game);
     g_lua.bindSingletonFunction("g_game", "canPerformGameAction", &Game::canPerformGameAction, &g_game);
     g_lua.bindSingletonFunction("g_game", "canReportBugs", &Game::canReportBugs, &g_game);
     g_lua.bindSingletonFunction("g_game", "checkBotProtection", &Game::checkBotProtection, &g_game);
@@ -364,6 +368,11 @@ void Client::registerLuaFunctions()
     g_lua.bindClassMemberFunction<ProtocolGame>("getCreature", &ProtocolGame::getCreature);
     g_lua.bindClassMemberFunction<ProtocolGame>("getItem", &ProtocolGame::getItem);
     g_lua.bindClassMemberFunction<ProtocolGame>("getPosition", &ProtocolGame::getPosition);
+    g_lua.bindClassMemberFunction<ProtocolGame>("setOpcodeStatsEnabled", &ProtocolGame::setOpcodeStatsEnabled);
+    g_lua.bindClassMemberFunction<ProtocolGame>("isOpcodeStatsEnabled", &ProtocolGame::isOpcodeStatsEnabled);
+    g_lua.bindClassMemberFunction<ProtocolGame>("resetOpcodeStats", &ProtocolGame::resetOpcodeStats);
+    g_lua.bindClassMemberFunction<ProtocolGame>("getOpcodeStats", &ProtocolGame::getOpcodeStatsTable);
+    g_lua.bindClassMemberFunction<ProtocolGame>("dumpOpcodeStats", &ProtocolGame::dumpOpcodeStats);
 
     g_lua.registerClass<Container>();
     g_lua.bindClassMemberFunction<Container>("getItem", &Container::getItem);
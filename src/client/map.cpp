@@ -36,6 +36,8 @@
 #include "houses.h"
 #include "towns.h"
 
+#include <queue>
+
 static constexpr uint8_t
 MAX_VIEWPORT_X = 8, MAX_VIEWPORT_Y = 6;
 
@@ -563,7 +565,7 @@ void Map::setCentralPosition(const Position& centralPosition)
     // this fixes local player position when the local player is removed from the map,
     // the local player is removed from the map when there are too many creatures on his tile,
     // so there is no enough stackpos to the server send him
-    g_dispatcher.addEvent([this] {
+    g_dispatcher.addTask([this] {
         const LocalPlayerPtr localPlayer = g_game.getLocalPlayer();
         if (!localPlayer || localPlayer->getPosition() == m_centralPosition)
             return;
@@ -1071,8 +1073,13 @@ void Map::findPathAsync(const Position& start, const Position& goal, const std::
         }
     }
 
-    g_asyncDispatcher.dispatch([=] {
-        auto ret = g_map.newFindPath(start, goal, visibleNodes);
-        g_dispatcher.addEvent(std::bind(callback, ret));
+    // the callback stays on the main thread, it usually holds shared objects
+    g_asyncDispatcher.scheduleThen([=] { return g_map.newFindPath(start, goal, visibleNodes); }, callback, AsyncDispatcher::HIGH);
+}
+
+void Map::findPathAsyncLua(const Position& start, const Position& goal, const std::function<void(std::vector<Otc::Direction>, int)>& callback)
+{
+    findPathAsync(start, goal, [callback](const PathFindResult_ptr& result) {
+        callback(result->path, result->status);
     });
 }
@@ -262,6 +262,8 @@ public:
     PathFindResult_ptr newFindPath(const Position& start, const Position& goal, const std::shared_ptr<std::list<Node*>>& visibleNodes);
     void findPathAsync(const Position& start, const Position& goal,
                        const std::function<void(PathFindResult_ptr)>& callback);
+    // callback(path, status), awaitable from lua coroutines
+    void findPathAsyncLua(const Position& start, const Position& goal, const std::function<void(std::vector<Otc::Direction>, int)>& callback);
 
     void setFloatingEffect(bool enable) { m_floatingEffect = enable; }
     bool isDrawingFloatingEffects() { return m_floatingEffect; }
@@ -34,6 +34,7 @@
 
 #include <framework/core/application.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/profiler.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/graphics/drawpoolmanager.h>
 #include <framework/graphics/graphics.h>
@@ -46,7 +47,9 @@ MapView::MapView()
 {
     auto* mapPool = g_drawPool.get<DrawPoolFramed>(DrawPoolType::MAP);
 
-    mapPool->onBeforeDraw([&] {
+    // the fade, the shader switch and the uniforms are worked out here, on the main thread,
+    // the draw only gets their values since it may run on the render thread
+    mapPool->onBeforeDraw([this]() -> std::function<void()> {
         const auto& cameraPosition = getCameraPosition();
 
         float fadeOpacity = 1.f;
@@ -63,28 +66,35 @@ MapView::MapView()
         if (m_shaderSwitchDone && m_shader && m_fadeInTime > 0)
             fadeOpacity = std::min<float>(m_fadeTimer.timeElapsed() / m_fadeInTime, 1.f);
 
-        if (m_shader) {
-            auto framebufferRect = Rect(0, 0, m_drawDimension * m_tileSize);
-            const Point center = m_posInfo.srcRect.center();
-            const Point globalCoord = Point(cameraPosition.x - m_drawDimension.width() / 2, -(cameraPosition.y - m_drawDimension.height() / 2)) * m_tileSize;
-            m_shader->bind();
-            m_shader->setUniformValue(ShaderManager::MAP_CENTER_COORD, center.x / static_cast<float>(m_rectDimension.width()), 1.f - center.y / static_cast<float>(m_rectDimension.height()));
-            m_shader->setUniformValue(ShaderManager::MAP_GLOBAL_COORD, globalCoord.x / static_cast<float>(m_rectDimension.height()), globalCoord.y / static_cast<float>(m_rectDimension.height()));
-            m_shader->setUniformValue(ShaderManager::MAP_ZOOM, m_scaleFactor);
+        if (!m_shader)
+            return [fadeOpacity] { g_painter->setOpacity(fadeOpacity); };
 
-            Point last = transformPositionTo2D(cameraPosition, m_shader->getPosition());
-            //Reverse vertical axis.
-            last.y = -last.y;
+        const Point center = m_posInfo.srcRect.center();
+        const Point globalCoord = Point(cameraPosition.x - m_drawDimension.width() / 2, -(cameraPosition.y - m_drawDimension.height() / 2)) * m_tileSize;
 
-            m_shader->setUniformValue(ShaderManager::MAP_WALKOFFSET, last.x / static_cast<float>(m_rectDimension.width()), last.y / static_cast<float>(m_rectDimension.height()));
+        Point last = transformPositionTo2D(cameraPosition, m_shader->getPosition());
+        //Reverse vertical axis.
+        last.y = -last.y;
 
-            g_painter->setShaderProgram(m_shader);
-        }
+        const float width = m_rectDimension.width(),
+            height = m_rectDimension.height();
+
+        return [shader = m_shader, fadeOpacity, zoom = m_scaleFactor,
+            centerCoord = PointF(center.x / width, 1.f - center.y / height),
+            globalCoord = PointF(globalCoord.x / height, globalCoord.y / height),
+            walkOffset = PointF(last.x / width, last.y / height)] {
+            shader->bind();
+            shader->setUniformValue(ShaderManager::MAP_CENTER_COORD, centerCoord.x, centerCoord.y);
+            shader->setUniformValue(ShaderManager::MAP_GLOBAL_COORD, globalCoord.x, globalCoord.y);
+            shader->setUniformValue(ShaderManager::MAP_ZOOM, zoom);
+            shader->setUniformValue(ShaderManager::MAP_WALKOFFSET, walkOffset.x, walkOffset.y);
 
-        g_painter->setOpacity(fadeOpacity);
+            g_painter->setShaderProgram(shader);
+            g_painter->setOpacity(fadeOpacity);
+        };
     });
 
-    mapPool->onAfterDraw([&] {
+    mapPool->onAfterDraw([] {
         g_painter->resetShaderProgram();
         g_painter->resetOpacity();
     });
@@ -105,6 +115,8 @@ MapView::~MapView()
 
 void MapView::draw(const Rect& rect)
 {
+    PROFILE_ZONE("MapView::draw");
+
     m_posInfo.camera = getCameraPosition();
 
     // update visible tiles cache when needed
@@ -172,6 +172,14 @@ public:
 
     void setFloorFading(uint16_t value) { m_floorFading = value; }
 
+    size_t getVisibleTilesCount()
+    {
+        size_t count = 0;
+        for (const auto& floor : m_cachedVisibleTiles)
+            count += floor.tiles.size();
+        return count;
+    }
+
 protected:
     void onGlobalLightChange(const Light& light);
     void onFloorChange(uint8_t floor, uint8_t previousFloor);
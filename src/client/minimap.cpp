@@ -24,6 +24,7 @@
 #include "tile.h"
 
 #include <framework/core/filestream.h>
+#include <framework/core/memorytracker.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/graphics/drawpoolmanager.h>
 #include <framework/graphics/image.h>
@@ -32,6 +33,12 @@
 
 Minimap g_minimap;
 
+MinimapBlock::~MinimapBlock()
+{
+    if (m_image)
+        g_memory.remove(MemoryTracker::MINIMAP, m_image->getPixelCount() * m_image->getBpp());
+}
+
 void MinimapBlock::clean()
 {
     m_tiles.fill(MinimapTile());
@@ -46,8 +53,10 @@ void MinimapBlock::update()
 
     if (m_image)
         m_image->resize(m_size);
-    else
+    else {
         m_image = new Image(m_size);
+        g_memory.add(MemoryTracker::MINIMAP, m_image->getPixelCount() * m_image->getBpp());
+    }
 
     bool shouldDraw = false;
     for (uint_fast8_t x = 0; x < MMBLOCK_SIZE; ++x) {
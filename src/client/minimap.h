@@ -52,6 +52,8 @@ struct MinimapTile
 class MinimapBlock
 {
 public:
+    ~MinimapBlock();
+
     void clean();
     void update();
     void updateTile(int x, int y, const MinimapTile& tile);
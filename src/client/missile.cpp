@@ -87,7 +87,7 @@ void Missile::setPath(const Position& fromPosition, const Position& toPosition)
 
     // schedule removal
     const auto self = asMissile();
-    g_dispatcher.scheduleEvent([self] { g_map.removeThing(self); }, m_duration);
+    g_dispatcher.scheduleTask([self] { g_map.removeThing(self); }, m_duration);
 
     generateBuffer();
 }
@@ -75,3 +75,79 @@ void ProtocolGame::onError(const std::error_code& error)
     g_game.processConnectionError(error);
     disconnect();
 }
+
+void ProtocolGame::setOpcodeStatsEnabled(bool enabled)
+{
+    if (enabled && !m_opcodeStatsEnabled)
+        m_opcodeRateTimer.restart();
+    m_opcodeStatsEnabled = enabled;
+}
+
+void ProtocolGame::resetOpcodeStats()
+{
+    m_opcodeStats = {};
+    m_opcodeRateTimer.restart();
+}
+
+void ProtocolGame::updateOpcodeRates()
+{
+    const ticks_t elapsed = m_opcodeRateTimer.elapsed_millis();
+    if (elapsed < 1000)
+        return;
+
+    for (auto& stats : m_opcodeStats) {
+        stats.countPerSecond = (stats.count - stats.windowCount) * 1000.f / elapsed;
+        stats.bytesPerSecond = (stats.bytes - stats.windowBytes) * 1000.f / elapsed;
+        stats.windowCount = stats.count;
+        stats.windowBytes = stats.bytes;
+    }
+    m_opcodeRateTimer.restart();
+}
+
+std::map<int, std::vector<double>> ProtocolGame::getOpcodeStatsTable()
+{
+    updateOpcodeRates();
+
+    std::map<int, std::vector<double>> ret;
+    for (int opcode = -1; ++opcode < static_cast<int>(m_opcodeStats.size());) {
+        const auto& stats = m_opcodeStats[opcode];
+        if (stats.count == 0)
+            continue;
+
+        ret.emplace(opcode, std::vector<double>{
+            static_cast<double>(stats.count),
+            static_cast<double>(stats.bytes),
+            stats.time / 1000.,
+            stats.maxTime / 1000.,
+            static_cast<double>(stats.luaClaims),
+            stats.countPerSecond,
+            stats.bytesPerSecond
+        });
+    }
+    return ret;
+}
+
+std::string ProtocolGame::dumpOpcodeStats(int limit)
+{
+    updateOpcodeRates();
+
+    std::vector<int> opcodes;
+    for (int opcode = -1; ++opcode < static_cast<int>(m_opcodeStats.size());) {
+        if (m_opcodeStats[opcode].count > 0)
+            opcodes.push_back(opcode);
+    }
+
+    std::sort(opcodes.begin(), opcodes.end(), [this](int a, int b) { return m_opcodeStats[a].bytes > m_opcodeStats[b].bytes; });
+    if (limit > 0 && static_cast<int>(opcodes.size()) > limit)
+        opcodes.resize(limit);
+
+    std::string ret = stdext::format("%-8s %10s %12s %10s %10s %8s %10s %12s\n", "opcode", "count", "bytes", "total ms", "max ms", "lua", "msgs/s", "bytes/s");
+    for (const int opcode : opcodes) {
+        const auto& stats = m_opcodeStats[opcode];
+        ret += stdext::format("0x%02X     %10s %12s %10.2f %10.2f %8s %10.1f %12.1f\n", opcode,
+                              std::to_string(stats.count), std::to_string(stats.bytes),
+                              stats.time / 1000., stats.maxTime / 1000., std::to_string(stats.luaClaims),
+                              stats.countPerSecond, stats.bytesPerSecond);
+    }
+    return ret;
+}
@@ -132,6 +132,35 @@ public:
     // otclient only
     void sendChangeMapAwareRange(int xrange, int yrange);
 
+    struct OpcodeStats
+    {
+        uint64_t count{ 0 };
+        uint64_t bytes{ 0 };
+        ticks_t time{ 0 }; // microseconds
+        ticks_t maxTime{ 0 };
+        uint64_t luaClaims{ 0 }; // messages consumed by the lua onOpcode hook
+
+        // rates measured over the last complete second
+        float countPerSecond{ 0 };
+        float bytesPerSecond{ 0 };
+        uint64_t windowCount{ 0 };
+        uint64_t windowBytes{ 0 };
+    };
+
+    // per opcode parse statistics, only collected while enabled
+    void setOpcodeStatsEnabled(bool enabled);
+    bool isOpcodeStatsEnabled() { return m_opcodeStatsEnabled; }
+    const std::array<OpcodeStats, 256>& getOpcodeStats() { return m_opcodeStats; }
+    void resetOpcodeStats();
+
+    // opcode -> { count, bytes, parse ms, max parse ms, lua claims, messages/s, bytes/s }, only opcodes that were received
+    std::map<int, std::vector<double>> getOpcodeStatsTable();
+    // human readable table of the opcodes sorted by bytes received
+    std::string dumpOpcodeStats(int limit = 0);
+
+    // feeds an already decrypted message, used to replay recorded sessions
+    void replayMessage(const InputMessagePtr& inputMessage) { onRecv(inputMessage); }
+
 protected:
     void onConnect() override;
     void onRecv(const InputMessagePtr& inputMessage) override;
@@ -316,10 +345,16 @@ public:
     Position getPosition(const InputMessagePtr& msg);
 
 private:
+    void updateOpcodeRates();
+
     bool m_enableSendExtendedOpcode{ false },
         m_gameInitialized{ false },
         m_mapKnown{ false },
-        m_firstRecv{ true };
+        m_firstRecv{ true },
+        m_opcodeStatsEnabled{ false };
+
+    std::array<OpcodeStats, 256> m_opcodeStats{};
+    stdext::timer m_opcodeRateTimer;
 
     std::string m_accountName;
     std::string m_accountPassword;
@@ -36,6 +36,40 @@
 #include "time.h"
 #include <framework/core/eventdispatcher.h>
 
+namespace
+{
+    // accumulates the size and parse time of a single opcode, including its opcode byte
+    class OpcodeStatsScope
+    {
+    public:
+        OpcodeStatsScope(ProtocolGame::OpcodeStats* stats, const InputMessagePtr& msg) :
+            m_stats(stats), m_msg(msg)
+        {
+            if (m_stats) {
+                m_readPos = msg->getReadPos() - 1;
+                m_start = stdext::micros();
+            }
+        }
+
+        ~OpcodeStatsScope()
+        {
+            if (!m_stats) return;
+
+            const ticks_t elapsed = stdext::micros() - m_start;
+            ++m_stats->count;
+            m_stats->bytes += m_msg->getReadPos() - m_readPos;
+            m_stats->time += elapsed;
+            m_stats->maxTime = std::max<ticks_t>(m_stats->maxTime, elapsed);
+        }
+
+    private:
+        ProtocolGame::OpcodeStats* m_stats;
+        const InputMessagePtr& m_msg;
+        int m_readPos{ 0 };
+        ticks_t m_start{ 0 };
+    };
+}
+
 void ProtocolGame::parseMessage(const InputMessagePtr& msg)
 {
     int opcode = -1;
@@ -53,10 +87,15 @@ void ProtocolGame::parseMessage(const InputMessagePtr& msg)
                 }
             }
 
+            OpcodeStatsScope statsScope(m_opcodeStatsEnabled ? &m_opcodeStats[opcode] : nullptr, msg);
+
             // try to parse in lua first
             const int readPos = msg->getReadPos();
-            if (callLuaField<bool>("onOpcode", opcode, msg))
+            if (callLuaField<bool>("onOpcode", opcode, msg)) {
+                if (m_opcodeStatsEnabled)
+                    ++m_opcodeStats[opcode].luaClaims;
                 continue;
+            }
             msg->setReadPos(readPos);
             // restore read pos
 
@@ -523,6 +562,9 @@ void ProtocolGame::parseMessage(const InputMessagePtr& msg)
         g_logger.error(stdext::format("ProtocolGame parse message exception (%d bytes unread, last opcode is %d, prev opcode is %d): %s",
                                       msg->getUnreadSize(), opcode, prevOpcode, e.what()));
     }
+
+    if (m_opcodeStatsEnabled)
+        updateOpcodeRates();
 }
 
 void ProtocolGame::parseLogin(const InputMessagePtr& msg)
@@ -895,11 +937,11 @@ void ProtocolGame::parseFloorDescription(const InputMessagePtr& msg)
             m_localPlayer->setPosition(pos);
         g_map.setCentralPosition(pos);
         if (!m_mapKnown) {
-            g_dispatcher.addEvent([] { g_lua.callGlobalField("g_game", "onMapKnown"); });
+            g_dispatcher.addTask([] { g_lua.callGlobalField("g_game", "onMapKnown"); });
             m_mapKnown = true;
         }
 
-        g_dispatcher.addEvent([] { g_lua.callGlobalField("g_game", "onMapDescription"); });
+        g_dispatcher.addTask([] { g_lua.callGlobalField("g_game", "onMapDescription"); });
         g_lua.callGlobalField("g_game", "onTeleport", m_localPlayer, pos, oldPos);
     }
 
@@ -920,11 +962,11 @@ void ProtocolGame::parseMapDescription(const InputMessagePtr& msg)
     setMapDescription(msg, pos.x - range.left, pos.y - range.top, pos.z, range.horizontal(), range.vertical());
 
     if (!m_mapKnown) {
-        g_dispatcher.addEvent([] { g_lua.callGlobalField("g_game", "onMapKnown"); });
+        g_dispatcher.addTask([] { g_lua.callGlobalField("g_game", "onMapKnown"); });
         m_mapKnown = true;
     }
 
-    g_dispatcher.addEvent([] { g_lua.callGlobalField("g_game", "onMapDescription"); });
+    g_dispatcher.addTask([] { g_lua.callGlobalField("g_game", "onMapDescription"); });
 }
 
 void ProtocolGame::parseMapMoveNorth(const InputMessagePtr& msg)
@@ -55,6 +55,10 @@ void ShaderManager::terminate()
 
 PainterShaderProgramPtr ShaderManager::createShader(const std::string_view name)
 {
+    // the null painter draws without shaders
+    if (g_graphics.isNullBackend())
+        return nullptr;
+
     PainterShaderProgramPtr shader(new PainterShaderProgram);
     m_shaders[name.data()] = shader;
     return shader;
@@ -23,6 +23,7 @@
 #include "spriteappearances.h"
 #include "game.h"
 #include <framework/core/filestream.h>
+#include <framework/core/memorytracker.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/graphics/image.h>
 
@@ -38,6 +39,12 @@ using json = nlohmann::json;
 
 SpriteAppearances g_spriteAppearances;
 
+SpriteSheet::~SpriteSheet()
+{
+    if (data)
+        g_memory.remove(MemoryTracker::SPRITE_SHEETS, LZMA_UNCOMPRESSED_SIZE);
+}
+
 void SpriteAppearances::init()
 {
     // in tibia 12.81 there is currently 3482 sheets
@@ -149,6 +156,7 @@ bool SpriteAppearances::loadSpriteSheet(const SpriteSheetPtr& sheet)
 
         sheet->data = std::make_unique<uint8_t[]>(LZMA_UNCOMPRESSED_SIZE);
         std::memcpy(sheet->data.get(), bufferStart, BYTES_IN_SPRITE_SHEET);
+        g_memory.add(MemoryTracker::SPRITE_SHEETS, LZMA_UNCOMPRESSED_SIZE);
 
         sheet->loaded = true;
         sheet->loading = false;
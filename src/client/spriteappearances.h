@@ -38,6 +38,7 @@ class SpriteSheet : public LuaObject
 {
 public:
     SpriteSheet(int firstId, int lastId, SpriteLayout spriteLayout, const std::string& file) : firstId(firstId), lastId(lastId), spriteLayout(spriteLayout), file(file) {}
+    ~SpriteSheet() override;
 
     Size getSpriteSize()
     {
@@ -91,7 +91,7 @@ void StaticText::update()
     if (m_messages.empty()) {
         // schedule removal
         auto self = asStaticText();
-        g_dispatcher.addEvent([self] { g_map.removeThing(self); });
+        g_dispatcher.addTask([self] { g_map.removeThing(self); });
     } else {
         compose();
         scheduleUpdate();
@@ -399,6 +399,8 @@ void ThingType::unserializeAppearance(uint16_t clientId, ThingCategory category,
     m_textures.resize(m_animationPhases);
     m_blankTextures.resize(m_animationPhases);
     m_smoothTextures.resize(m_animationPhases);
+    m_atlasRegions.resize(m_animationPhases);
+    m_blankAtlasRegions.resize(m_animationPhases);
     m_texturesFramesRects.resize(m_animationPhases);
     m_texturesFramesOriginRects.resize(m_animationPhases);
     m_texturesFramesOffsets.resize(m_animationPhases);
@@ -648,6 +650,8 @@ void ThingType::unserialize(uint16_t clientId, ThingCategory category, const Fil
     m_textures.resize(m_animationPhases);
     m_blankTextures.resize(m_animationPhases);
     m_smoothTextures.resize(m_animationPhases);
+    m_atlasRegions.resize(m_animationPhases);
+    m_blankAtlasRegions.resize(m_animationPhases);
     m_texturesFramesRects.resize(m_animationPhases);
     m_texturesFramesOriginRects.resize(m_animationPhases);
     m_texturesFramesOffsets.resize(m_animationPhases);
@@ -720,7 +724,14 @@ void ThingType::draw(const Point& dest, float scaleFactor, int layer, int xPatte
         return;
 
     const Point& textureOffset = m_texturesFramesOffsets[animationPhase][frameIndex];
-    const Rect& textureRect = textureRectList[frameIndex];
+    Rect textureRect = textureRectList[frameIndex];
+
+    // packed images are drawn from their place in the atlas page
+    if (textureType != TextureType::SMOOTH) {
+        const auto& region = (textureType == TextureType::ALL_BLANK ? m_blankAtlasRegions : m_atlasRegions)[animationPhase];
+        if (!region.isNull())
+            textureRect.translate(region.origin);
+    }
 
     const Rect screenRect(dest + (textureOffset - m_displacement - (m_size.toPoint() - Point(1)) * SPRITE_SIZE) * scaleFactor, textureRect.size() * scaleFactor);
 
@@ -752,7 +763,20 @@ TexturePtr ThingType::getTexture(int animationPhase, const TextureType txtType)
         allBlank ? m_blankTextures :
         smooth ? m_smoothTextures : m_textures)[animationPhase];
 
-    if (animationPhaseTexture) return animationPhaseTexture;
+    // images in a page have a clamped border of a texel, enough for nearest sampling and for
+    // shaders reading next to a frame; smooth textures are filtered over scaled sizes and outfit
+    // shaders sample further around the frame, so both keep their own texture
+    const bool packed = !smooth && m_category != ThingCategoryCreature;
+    TextureAtlas::Region* atlasRegion = packed ? &(allBlank ? m_blankAtlasRegions : m_atlasRegions)[animationPhase] : nullptr;
+
+    if (animationPhaseTexture) {
+        // once its page was evicted the image is built and packed again
+        if (!atlasRegion || atlasRegion->isNull() || g_atlas.touch(*atlasRegion))
+            return animationPhaseTexture;
+
+        animationPhaseTexture = nullptr;
+        *atlasRegion = {};
+    }
 
     // we don't need layers in common items, they will be pre-drawn
     int textureLayers = 1;
@@ -860,7 +884,16 @@ TexturePtr ThingType::getTexture(int animationPhase, const TextureType txtType)
 
     m_opaque = !fullImage->hasTransparentPixel();
 
+    if (atlasRegion) {
+        if (const auto& page = g_atlas.add(fullImage, *atlasRegion)) {
+            animationPhaseTexture = page;
+            return animationPhaseTexture;
+        }
+        *atlasRegion = {};
+    }
+
     animationPhaseTexture = TexturePtr(new Texture(fullImage, true, false, m_size.area() == 1 && !hasElevation(), false));
+    animationPhaseTexture->setMemoryCategory(MemoryTracker::THING_TEXTURES);
     if (smooth)
         animationPhaseTexture->setSmooth(true);
 
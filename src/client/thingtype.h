@@ -27,6 +27,7 @@
 
 #include <framework/core/declarations.h>
 #include <framework/graphics/texture.h>
+#include <framework/graphics/textureatlas.h>
 #include <framework/graphics/drawpoolmanager.h>
 #include <framework/luaengine/luaobject.h>
 #include <framework/net/server.h>
@@ -302,6 +303,10 @@ private:
         m_blankTextures,
         m_smoothTextures;
 
+    // where m_textures and m_blankTextures are packed, null for the ones with their own texture
+    std::vector<TextureAtlas::Region> m_atlasRegions,
+        m_blankAtlasRegions;
+
     std::vector<std::vector<Rect>> m_texturesFramesRects;
     std::vector<std::vector<Rect>> m_texturesFramesOriginRects;
     std::vector<std::vector<Point>> m_texturesFramesOffsets;
@@ -28,6 +28,7 @@
 #include "map.h"
 #include "protocolgame.h"
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/memorytracker.h>
 #include <framework/graphics/drawpoolmanager.h>
 
 #include <ranges>
@@ -35,8 +36,11 @@
 Tile::Tile(const Position& position) : m_position(position)
 {
     m_completelyCoveredCache.fill(-1);
+    g_memory.add(MemoryTracker::TILES, sizeof(Tile));
 }
 
+Tile::~Tile() { g_memory.remove(MemoryTracker::TILES, sizeof(Tile)); }
+
 void Tile::drawThing(const ThingPtr& thing, const Point& dest, float scaleFactor, bool animate, int flags, LightView* lightView)
 {
     thing->draw(dest, scaleFactor, animate, flags, m_highlight, TextureType::NONE, Color::white, lightView);
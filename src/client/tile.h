@@ -55,6 +55,7 @@ class Tile : public LuaObject
 {
 public:
     Tile(const Position& position);
+    ~Tile() override;
 
     void onAddInMapView();
     void draw(const Point& dest, const MapPosInfo& mapRect, float scaleFactor, int flags, bool isCovered, LightView* lightView = nullptr);
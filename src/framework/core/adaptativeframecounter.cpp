@@ -22,30 +22,116 @@
 
 #include "adaptativeframecounter.h"
 
+#include <cmath>
+#include <thread>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+namespace
+{
+    // plain sleep_for is rounded up to the 15.6 ms system tick on windows
+    void preciseSleep(const ticks_t us)
+    {
+#ifdef WIN32
+        static const HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (timer) {
+            LARGE_INTEGER dueTime;
+            dueTime.QuadPart = -us * 10; // relative, in 100 ns units
+            if (SetWaitableTimer(timer, &dueTime, 0, nullptr, nullptr, FALSE)) {
+                WaitForSingleObject(timer, INFINITE);
+                return;
+            }
+        }
+#endif
+        stdext::microsleep(us);
+    }
+}
+
+uint32_t AdaptativeFrameCounter::getCurrentMaxFps() const
+{
+    switch (m_windowState) {
+        case UNFOCUSED: return m_unfocusedMaxFps ? m_unfocusedMaxFps : m_maxFps;
+        case MINIMIZED: return m_minimizedMaxFps;
+        default: return m_maxFps;
+    }
+}
+
+ticks_t AdaptativeFrameCounter::getPeriod() const
+{
+    const uint32_t maxFps = getCurrentMaxFps();
+    return maxFps ? 1000000 / maxFps : 0;
+}
+
 bool AdaptativeFrameCounter::canRefresh()
 {
-    if (m_maxFps == 0) return true;
+    const ticks_t period = getPeriod();
+    if (period == 0) return true;
 
-    m_currentTime = stdext::micros();
-    return m_currentTime - m_lastTime >= 1000000 / m_maxFps;
+    const ticks_t now = stdext::micros();
+    if (now < m_nextFrame)
+        return false;
+
+    // keeps the cadence when slightly late, restarts it when more than a frame behind or after a cap change
+    if (now - m_nextFrame > period)
+        m_nextFrame = now;
+    m_nextFrame += period;
+    return true;
+}
+
+void AdaptativeFrameCounter::waitForNextFrame()
+{
+    const ticks_t period = getPeriod();
+    if (period == 0) {
+        // minimized without a cap, only the polls are paced
+        if (m_windowState == MINIMIZED)
+            preciseSleep(m_serviceInterval);
+        return;
+    }
+
+    const ticks_t remaining = m_nextFrame - stdext::micros();
+    if (remaining > SPIN_MARGIN) {
+        // input latency does not matter while minimized, sleep the whole wait at once
+        const ticks_t slice = m_windowState == MINIMIZED ? remaining : std::min<ticks_t>(remaining - SPIN_MARGIN, m_serviceInterval);
+        preciseSleep(slice);
+    } else if (remaining > 0)
+        std::this_thread::yield();
 }
 
 bool AdaptativeFrameCounter::update()
 {
     ++m_fpsCount;
 
-    m_lastTime = m_currentTime;
+    const ticks_t now = stdext::micros();
+    if (m_lastFrame > 0) {
+        const ticks_t frameTime = now - m_lastFrame;
+        m_frameTimeSum += frameTime;
+        m_frameTimeSquareSum += static_cast<double>(frameTime) * frameTime;
+        m_frameTimeMax = std::max<ticks_t>(m_frameTimeMax, frameTime);
+    }
+    m_lastFrame = now;
 
     const uint32_t tickCount = stdext::millis();
     if (tickCount - m_interval <= 1000)
         return false;
 
+    if (m_fpsCount > 0) {
+        const double mean = m_frameTimeSum / m_fpsCount;
+        const double variance = std::max<double>(0, m_frameTimeSquareSum / m_fpsCount - mean * mean);
+        m_frameTime = mean / 1000.;
+        m_maxFrameTime = m_frameTimeMax / 1000.;
+        m_jitter = std::sqrt(variance) / 1000.;
+    }
+    m_frameTimeSum = m_frameTimeSquareSum = 0;
+    m_frameTimeMax = 0;
+
     const bool fpsChanged = m_fps != m_fpsCount;
-    if (fpsChanged) {
+    if (fpsChanged)
         m_fps = m_fpsCount;
-        m_fpsCount = 0;
-        m_interval = tickCount;
-    }
+
+    m_fpsCount = 0;
+    m_interval = tickCount;
 
     return fpsChanged;
 }
@@ -26,27 +26,76 @@
 
  /**
   * Class that help counting and limiting frames per second in a application,
+  *
+  * Frames are paced against a deadline that advances by the frame period, so a
+  * late frame does not push every following one. While the deadline is not
+  * reached, waitForNextFrame sleeps in slices of the service interval, letting
+  * the caller poll input and network between them, and only yields during the
+  * last SPIN_MARGIN microseconds to hit the deadline precisely.
   */
 class AdaptativeFrameCounter
 {
 public:
+    enum WindowState : uint8_t
+    {
+        FOCUSED,
+        UNFOCUSED,
+        MINIMIZED
+    };
+
     AdaptativeFrameCounter() : m_interval(stdext::millis()) {}
 
     bool update();
     bool canRefresh();
+    void waitForNextFrame();
 
     uint32_t getFps() const { return m_fps; }
     uint32_t getMaxFps() const { return m_maxFps; }
 
     void setMaxFps(const uint32_t max) { m_maxFps = max; }
 
+    // 0 uses the focused cap
+    void setUnfocusedMaxFps(const uint32_t max) { m_unfocusedMaxFps = max; }
+    uint32_t getUnfocusedMaxFps() const { return m_unfocusedMaxFps; }
+
+    // nothing is drawn while minimized, this caps how often the loop polls; 0 polls every service interval
+    void setMinimizedMaxFps(const uint32_t max) { m_minimizedMaxFps = max; }
+    uint32_t getMinimizedMaxFps() const { return m_minimizedMaxFps; }
+
+    void setWindowState(const WindowState state) { m_windowState = state; }
+    WindowState getWindowState() const { return m_windowState; }
+
+    // longest sleep between two polls while waiting for a frame, in microseconds
+    void setServiceInterval(const uint32_t us) { m_serviceInterval = std::max<uint32_t>(100, us); }
+    uint32_t getServiceInterval() const { return m_serviceInterval; }
+
+    // frame time statistics over the last second, in milliseconds
+    float getFrameTime() const { return m_frameTime; }
+    float getMaxFrameTime() const { return m_maxFrameTime; }
+    // standard deviation of the frame time
+    float getJitter() const { return m_jitter; }
+
 private:
-    double getMaxPeriod() { return 1.0 / m_maxFps; }
+    static constexpr ticks_t SPIN_MARGIN = 500; // microseconds
+
+    uint32_t getCurrentMaxFps() const;
+    ticks_t getPeriod() const;
 
     uint32_t m_fps{ 0 },
         m_maxFps{ 0 },
+        m_unfocusedMaxFps{ 0 },
+        m_minimizedMaxFps{ 0 },
+        m_serviceInterval{ 2000 },
         m_fpsCount{ 0 },
         m_interval{ 0 };
 
-    ticks_t m_currentTime{ 0 }, m_lastTime{ 0 };
+    WindowState m_windowState{ FOCUSED };
+
+    ticks_t m_nextFrame{ 0 }, m_lastFrame{ 0 };
+
+    // frame time accumulators of the current second, in microseconds
+    double m_frameTimeSum{ 0 }, m_frameTimeSquareSum{ 0 };
+    ticks_t m_frameTimeMax{ 0 };
+
+    float m_frameTime{ 0 }, m_maxFrameTime{ 0 }, m_jitter{ 0 };
 };
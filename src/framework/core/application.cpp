@@ -25,6 +25,7 @@
 #include <csignal>
 #include <framework/core/configmanager.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/memorytracker.h>
 #include <framework/core/modulemanager.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/luaengine/luainterface.h>
@@ -40,6 +41,7 @@
 
 #ifdef FRAMEWORK_NET
 #include <framework/net/connection.h>
+#include <framework/net/networkthread.h>
 #endif
 
 void exitSignalHandler(int sig)
@@ -120,12 +122,16 @@ void Application::terminate()
 {
 #ifdef FRAMEWORK_NET
     // terminate network
+    g_network.terminate();
     Connection::terminate();
 #endif
 
     // release configs
     g_configs.terminate();
 
+    // stop the periodic memory log
+    g_memory.terminate();
+
     // release resources
     g_resources.terminate();
 
@@ -141,9 +147,21 @@ void Application::terminate()
 void Application::poll()
 {
 #ifdef FRAMEWORK_NET
-    Connection::poll();
+    {
+        // network callbacks are not deferred by the dispatcher budget
+        EventDispatcher::UrgentScope urgent;
+
+        Connection::poll();
+
+        // deliver what the network thread received
+        g_network.poll();
+    }
 #endif
 
+    // results of worker tasks, they may wake lua coroutines
+    g_asyncDispatcher.poll();
+    g_lua.pollCoroutines();
+
     g_dispatcher.poll();
 
     // poll connection again to flush pending write
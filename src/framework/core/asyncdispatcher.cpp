@@ -24,21 +24,53 @@
 
 AsyncDispatcher g_asyncDispatcher;
 
-void AsyncDispatcher::init()
+namespace
 {
-    spawn_thread();
+    // index of the worker running on this thread, -1 outside of the pool
+    thread_local int t_workerIndex = -1;
+}
+
+bool AsyncDispatcher::TaskHandle::cancel()
+{
+    uint8_t expected = PENDING;
+    return m_state && m_state->compare_exchange_strong(expected, CANCELED);
+}
+
+void AsyncDispatcher::init(int threads)
+{
+    if (threads <= 0)
+        threads = std::max<int>(1, std::thread::hardware_concurrency());
+
+    m_running = true;
+    for (int i = -1; ++i < threads;)
+        m_workers.emplace_back(std::make_unique<Worker>());
+
+    for (int i = -1; ++i < threads;)
+        m_workers[i]->thread = std::thread([this, i] { exec_loop(i); });
 }
 
 void AsyncDispatcher::terminate()
 {
     stop();
-    m_tasks.clear();
+    m_workers.clear();
+
+    // the callbacks of tasks that never ran are dropped
+    m_callbacks.clear();
 }
 
-void AsyncDispatcher::spawn_thread()
+void AsyncDispatcher::poll()
 {
-    m_running = true;
-    m_threads.emplace_back([this] { exec_loop(); });
+    if (m_callbacks.empty())
+        return;
+
+    // callbacks may schedule new tasks
+    auto callbacks = std::move(m_callbacks);
+    m_callbacks.clear();
+
+    for (auto& callback : callbacks) {
+        if (!callback())
+            m_callbacks.emplace_back(std::move(callback));
+    }
 }
 
 void AsyncDispatcher::stop()
@@ -47,26 +79,139 @@ void AsyncDispatcher::stop()
     m_running = false;
     m_condition.notify_all();
     m_mutex.unlock();
-    for (std::thread& thread : m_threads)
-        thread.join();
-    m_threads.clear();
+    for (const auto& worker : m_workers) {
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
 };
 
-void AsyncDispatcher::exec_loop()
+AsyncDispatcher::TaskHandle AsyncDispatcher::push(std::function<void()>&& f, const Priority priority)
+{
+    if (m_workers.empty())
+        return {};
+
+    const auto state = std::make_shared<std::atomic<uint8_t>>(TaskHandle::PENDING);
+
+    // workers keep their own tasks, other threads spread them
+    const int workerIndex = t_workerIndex >= 0 ? t_workerIndex : m_nextWorker++ % m_workers.size();
+    auto& worker = *m_workers[workerIndex];
+    {
+        // counted before it can be taken, a stealer must never bring the count below zero
+        std::lock_guard lock(worker.mutex);
+        ++m_pending;
+        worker.tasks[priority].push_back({ std::move(f), state });
+    }
+
+    {
+        // taking the lock avoids a lost wakeup between the pending check and the wait of a worker
+        std::lock_guard lock(m_mutex);
+    }
+    m_condition.notify_one();
+
+    return TaskHandle(state);
+}
+
+bool AsyncDispatcher::popTask(const int workerIndex, Task& task)
 {
-    std::unique_lock lock(m_mutex);
+    for (int priority = -1; ++priority < LAST_PRIORITY;) {
+        {
+            // own tasks are taken from the back, the most recent ones are the hottest in cache
+            auto& worker = *m_workers[workerIndex];
+            std::lock_guard lock(worker.mutex);
+            auto& tasks = worker.tasks[priority];
+            if (!tasks.empty()) {
+                task = std::move(tasks.back());
+                tasks.pop_back();
+                --m_pending;
+                return true;
+            }
+        }
+
+        if (stealTask(workerIndex, static_cast<Priority>(priority), task))
+            return true;
+    }
+    return false;
+}
+
+bool AsyncDispatcher::stealTask(const int workerIndex, const Priority priority, Task& task)
+{
+    const int size = m_workers.size();
+    for (int i = 0; ++i < size;) {
+        auto& victim = *m_workers[(workerIndex + i) % size];
+        std::lock_guard lock(victim.mutex);
+        auto& tasks = victim.tasks[priority];
+        if (!tasks.empty()) {
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            --m_pending;
+            return true;
+        }
+    }
+    return false;
+}
+
+void AsyncDispatcher::runTask(Task& task)
+{
+    uint8_t expected = TaskHandle::PENDING;
+    if (!task.state->compare_exchange_strong(expected, TaskHandle::RUNNING))
+        return; // canceled
+
+    task.function();
+    *task.state = TaskHandle::FINISHED;
+    task.state->notify_all();
+}
+
+void AsyncDispatcher::exec_loop(const int workerIndex)
+{
+    t_workerIndex = workerIndex;
+
+    Task task;
     while (true) {
-        while (m_tasks.empty() && m_running)
+        if (popTask(workerIndex, task)) {
+            runTask(task);
+            task = {};
+            continue;
+        }
+
+        std::unique_lock lock(m_mutex);
+        while (m_pending == 0 && m_running)
             m_condition.wait(lock);
 
         if (!m_running)
             return;
+    }
+}
+
+void AsyncDispatcher::parallel_for(const size_t begin, const size_t end, const std::function<void(size_t)>& f, size_t grain)
+{
+    if (begin >= end)
+        return;
+
+    grain = std::max<size_t>(1, grain);
+    std::atomic<size_t> next{ begin };
+    const auto work = [&] {
+        for (size_t i; (i = next.fetch_add(grain)) < end;) {
+            for (size_t j = i, last = std::min<size_t>(end, i + grain); j < last; ++j)
+                f(j);
+        }
+    };
+
+    const size_t chunks = (end - begin + grain - 1) / grain;
+    const size_t helpers = std::min<size_t>(chunks, m_workers.size() + 1) - 1;
+
+    std::vector<TaskHandle> handles;
+    handles.reserve(helpers);
+    for (size_t i = 0; i < helpers; ++i)
+        handles.emplace_back(push(work, HIGH));
+
+    work();
 
-        std::function<void()> task = m_tasks.front();
-        m_tasks.pop_front();
+    // every index is taken, helpers that did not start are not needed anymore; the running ones are waited
+    for (auto& handle : handles) {
+        if (!handle.m_state || handle.cancel())
+            continue;
 
-        lock.unlock();
-        task();
-        lock.lock();
+        for (uint8_t state; (state = *handle.m_state) != TaskHandle::FINISHED;)
+            handle.m_state->wait(state);
     }
 }
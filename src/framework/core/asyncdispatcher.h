@@ -22,44 +22,130 @@
 
 #pragma once
 
+#include <array>
+#include <condition_variable>
+#include <deque>
 #include <future>
-#include <list>
+#include <thread>
+#include <vector>
 
+/**
+ * Thread pool sized to the hardware concurrency.
+ *
+ * Every worker owns one deque per priority; tasks pushed from a worker go to
+ * its own deques, tasks pushed from other threads are spread round robin.
+ * Idle workers steal from the front of the other deques, and HIGH tasks are
+ * always taken before BULK ones.
+ */
 class AsyncDispatcher
 {
 public:
-    void init();
+    enum Priority : uint8_t
+    {
+        HIGH, // latency sensitive, e.g. path finding
+        BULK, // throughput work, e.g. sprite sheet decoding
+        LAST_PRIORITY
+    };
+
+    // cancels a task that did not start yet, copies share the same task
+    class TaskHandle
+    {
+    public:
+        TaskHandle() = default;
+
+        bool cancel();
+        bool isCanceled() const { return m_state && *m_state == CANCELED; }
+        bool isFinished() const { return m_state && *m_state == FINISHED; }
+
+    private:
+        enum State : uint8_t { PENDING, RUNNING, FINISHED, CANCELED };
+
+        TaskHandle(const std::shared_ptr<std::atomic<uint8_t>>& state) : m_state(state) {}
+
+        std::shared_ptr<std::atomic<uint8_t>> m_state;
+
+        friend class AsyncDispatcher;
+    };
+
+    // threads = 0 uses the hardware concurrency
+    void init(int threads = 0);
     void terminate();
 
-    void spawn_thread();
     void stop();
 
     template<class F>
-    std::shared_future<std::invoke_result_t<F>> schedule(const F& task)
+    std::shared_future<std::invoke_result_t<F>> schedule(const F& task, Priority priority = BULK)
     {
-        std::lock_guard lock(m_mutex);
         auto prom = std::make_shared<std::promise<std::invoke_result_t<F>>>();
-        m_tasks.push_back([=] { prom->set_value(task()); });
-        m_condition.notify_all();
+        push([=] { prom->set_value(task()); }, priority);
         return std::shared_future<std::invoke_result_t<F>>(prom->get_future());
     }
 
-    void dispatch(const std::function<void()>& f)
+    // runs task on a worker and hands its result to callback on the main thread, in a later poll;
+    // only task crosses threads, so callback may hold lua functions and shared objects
+    template<class F, class C>
+    void scheduleThen(const F& task, const C& callback, Priority priority = BULK)
     {
-        std::lock_guard lock(m_mutex);
-        m_tasks.push_back(f);
-        m_condition.notify_all();
+        using R = std::invoke_result_t<F>;
+
+        std::shared_future<R> future;
+        if (m_workers.empty()) {
+            std::promise<R> prom;
+            prom.set_value(task());
+            future = prom.get_future().share();
+        } else
+            future = schedule(task, priority);
+
+        m_callbacks.emplace_back([future, callback] {
+            if (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return false;
+            callback(future.get());
+            return true;
+        });
     }
 
-protected:
-    void exec_loop();
+    // main thread, calls the callbacks of the finished scheduleThen tasks
+    void poll();
+
+    void dispatch(const std::function<void()>& f, Priority priority = BULK) { push(std::function<void()>(f), priority); }
+
+    TaskHandle submit(std::function<void()> f, Priority priority = BULK) { return push(std::move(f), priority); }
+
+    // calls f(i) for every i in [begin, end) spread over the workers, in chunks of grain indices,
+    // and returns once all of them ran; the calling thread takes part, f must not throw
+    void parallel_for(size_t begin, size_t end, const std::function<void(size_t)>& f, size_t grain = 1);
+
+    int getWorkerCount() { return m_workers.size(); }
 
 private:
-    std::list<std::function<void()>> m_tasks;
-    std::list<std::thread> m_threads;
+    struct Task
+    {
+        std::function<void()> function;
+        std::shared_ptr<std::atomic<uint8_t>> state;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::array<std::deque<Task>, LAST_PRIORITY> tasks;
+        std::thread thread;
+    };
+
+    TaskHandle push(std::function<void()>&& f, Priority priority);
+    bool popTask(int workerIndex, Task& task);
+    bool stealTask(int workerIndex, Priority priority, Task& task);
+    void runTask(Task& task);
+    void exec_loop(int workerIndex);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<uint32_t> m_nextWorker{ 0 };
+    std::atomic<int> m_pending{ 0 };
+
     std::mutex m_mutex;
     std::condition_variable m_condition;
     bool m_running{ false };
+
+    std::vector<std::function<bool()>> m_callbacks;
 };
 
 extern AsyncDispatcher g_asyncDispatcher;
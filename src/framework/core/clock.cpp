@@ -33,7 +33,7 @@ Clock::Clock()
 
 void Clock::update()
 {
-    m_currentMicros = stdext::micros();
+    m_currentMicros = m_fixedTimestep > 0 ? m_currentMicros + m_fixedTimestep : stdext::micros();
     m_currentMillis = m_currentMicros / 1000;
     m_currentSeconds = m_currentMicros / 1000000.0f;
 }
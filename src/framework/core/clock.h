@@ -36,7 +36,13 @@ public:
     ticks_t millis() { return m_currentMillis; }
     float seconds() { return m_currentSeconds; }
 
+    // when set, every update advances the clock by this many microseconds instead of
+    // reading the real time, so scripted renders are reproducible; 0 goes back to real time
+    void setFixedTimestep(ticks_t micros) { m_fixedTimestep = std::max<ticks_t>(0, micros); }
+    ticks_t getFixedTimestep() { return m_fixedTimestep; }
+
 private:
+    ticks_t m_fixedTimestep{ 0 };
     ticks_t m_currentMicros;
     ticks_t m_currentMillis;
     float m_currentSeconds;
@@ -31,6 +31,7 @@ class Module;
 class Config;
 class Event;
 class ScheduledEvent;
+struct EventTask;
 class FileStream;
 class BinaryTree;
 class OutputBinaryTree;
@@ -32,13 +32,18 @@ public:
     ~Event() override;
 
     virtual void execute();
-    void cancel();
+    virtual void cancel();
 
     bool isCanceled() { return m_canceled; }
     bool isExecuted() { return m_executed; }
 
+    // optional label used to group the dispatcher telemetry by origin
+    void setSource(const std::string_view source) { m_source = source; }
+    const std::string& getSource() { return m_source; }
+
 protected:
     std::function<void()> m_callback;
+    std::string m_source;
     bool m_canceled;
     bool m_executed;
 };
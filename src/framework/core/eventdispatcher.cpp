@@ -24,58 +24,331 @@
 
 #include "timer.h"
 #include <framework/core/clock.h>
+#include <framework/core/profiler.h>
 
 EventDispatcher g_dispatcher;
 
 void EventDispatcher::shutdown()
 {
-    while (!m_eventList.empty())
+    m_pollBudget = 0;
+    while (m_events.head || m_urgentEvents.head)
         poll();
 
     while (!m_scheduledEventList.empty()) {
-        const ScheduledEventPtr scheduledEvent = m_scheduledEventList.top();
-        scheduledEvent->cancel();
-        m_scheduledEventList.pop();
+        EventTask* task = m_scheduledEventList.pop();
+        if (task->event) {
+            const auto scheduledEvent = task->event->static_self_cast<ScheduledEvent>();
+            scheduledEvent->m_task = nullptr;
+            scheduledEvent->cancel();
+        }
+        m_taskPool.release(task);
     }
     m_disabled = true;
 }
 
 void EventDispatcher::poll()
 {
-    for (int count = 0, max = m_scheduledEventList.size(); count < max && !m_scheduledEventList.empty(); ++count) {
-        ScheduledEventPtr scheduledEvent = m_scheduledEventList.top();
-        if (scheduledEvent->remainingTicks() > 0)
-            break;
-        m_scheduledEventList.pop();
-        scheduledEvent->execute();
+    PROFILE_ZONE("EventDispatcher::poll");
+
+    const int64_t pollStart = stdext::micros();
+    const int64_t deadline = m_pollBudget > 0 ? pollStart + m_pollBudget : 0;
+    int loops = 0;
+
+    // input and network work, never deferred
+    int urgentExecuted;
+    {
+        PROFILE_ZONE("EventDispatcher::urgent");
+        urgentExecuted = executeEvents(m_urgentEvents, 0, loops);
+    }
+
+    int scheduledExecuted = 0, spilledScheduled = 0;
+    {
+        PROFILE_ZONE("EventDispatcher::scheduled");
+        for (int count = 0, max = m_scheduledEventList.size(); count < max && !m_scheduledEventList.empty(); ++count) {
+            if (m_scheduledEventList.top()->ticks > g_clock.millis())
+                break;
+
+            // the queue keeps its order, the due events run first in the next poll
+            if (deadline && count > 0 && stdext::micros() >= deadline) {
+                const auto& tasks = m_scheduledEventList.tasks();
+                spilledScheduled = std::count_if(tasks.begin(), tasks.end(), [](const EventTask* task) { return task->ticks <= g_clock.millis(); });
+                break;
+            }
+
+            if (executeScheduledTask(m_scheduledEventList.pop()))
+                ++scheduledExecuted;
+        }
+    }
 
-        if (scheduledEvent->nextCycle())
-            m_scheduledEventList.push(scheduledEvent);
+    int eventsExecuted;
+    {
+        PROFILE_ZONE("EventDispatcher::events");
+        eventsExecuted = executeEvents(m_events, deadline, loops);
     }
 
+    m_stats.scheduledExecuted = scheduledExecuted;
+    m_stats.eventsExecuted = eventsExecuted;
+    m_stats.urgentExecuted = urgentExecuted;
+    m_stats.loops = loops;
+    m_stats.spilledScheduled = spilledScheduled;
+    m_stats.spilledEvents = deadline ? m_events.size : 0;
+    m_stats.time = stdext::micros() - pollStart;
+
+    ++m_stats.polls;
+    m_stats.totalScheduledExecuted += scheduledExecuted;
+    m_stats.totalEventsExecuted += eventsExecuted + urgentExecuted;
+    m_stats.totalTime += m_stats.time;
+    m_stats.maxTime = std::max<int64_t>(m_stats.maxTime, m_stats.time);
+    m_stats.maxEventsExecuted = std::max<int>(m_stats.maxEventsExecuted, scheduledExecuted + eventsExecuted + urgentExecuted);
+
+    if (m_stats.spilledScheduled > 0 || m_stats.spilledEvents > 0)
+        ++m_stats.spills;
+
+    if (m_pollBudget > 0 && m_stats.time > m_pollBudget) {
+        ++m_stats.budgetOverruns;
+        m_stats.maxBudgetOverrun = std::max<int64_t>(m_stats.maxBudgetOverrun, m_stats.time - m_pollBudget);
+    }
+}
+
+int EventDispatcher::executeEvents(EventList& list, const int64_t deadline, int& loops)
+{
+    const bool urgent = &list == &m_urgentEvents;
+
     // execute events list until all events are out, this is needed because some events can schedule new events that would
     // change the UIWidgets layout, in this case we must execute these new events before we continue rendering,
-    m_pollEventsSize = m_eventList.size();
-    int loops = 0;
-    while (m_pollEventsSize > 0) {
-        if (loops > 50) {
+    // unless the poll budget runs out
+    list.pollSize = list.size;
+    int executed = 0, listLoops = 0;
+    while (list.pollSize > 0) {
+        if (listLoops > 50) {
+            ++m_stats.loopLimitHits;
             static Timer reportTimer;
             if (reportTimer.running() && reportTimer.ticksElapsed() > 100) {
-                g_logger.error("ATTENTION the event list is not getting empty, this could be caused by some bad code");
+                g_logger.error(stdext::format("ATTENTION the event list is not getting empty, this could be caused by some bad code (%d events left)", list.pollSize));
                 reportTimer.restart();
             }
             break;
         }
 
-        for (int i = 0; i < m_pollEventsSize; ++i) {
-            const EventPtr event = m_eventList.front();
-            m_eventList.pop_front();
-            event->execute();
+        while (list.pollSize > 0) {
+            if (deadline && executed > 0 && stdext::micros() >= deadline)
+                return executed;
+
+            // a front push while the event runs grows pollSize again
+            --list.pollSize;
+            if (urgent) {
+                ++m_urgentDepth;
+                executeEventTask(popEventTask(list));
+                --m_urgentDepth;
+            } else
+                executeEventTask(popEventTask(list));
+            ++executed;
         }
-        m_pollEventsSize = m_eventList.size();
+        list.pollSize = list.size;
 
+        ++listLoops;
         ++loops;
     }
+
+    return executed;
+}
+
+void EventDispatcher::cancelTask(EventTask* task)
+{
+    if (task->state == EventTask::FREE || task->canceled)
+        return;
+
+    task->canceled = true;
+    if (task->state == EventTask::SCHEDULED) {
+        m_scheduledEventList.remove(task);
+        if (task->event)
+            task->event->static_self_cast<ScheduledEvent>()->m_task = nullptr;
+        m_taskPool.release(task);
+    } else if (task->state == EventTask::QUEUED) {
+        // free the captures now, the node itself leaves the list when it is reached
+        task->callback.reset();
+    }
+    // a running task is released once its callback returns
+}
+
+void EventDispatcher::pushEventTask(EventTask* task, const bool pushFront)
+{
+    task->state = EventTask::QUEUED;
+
+    EventList& list = m_urgentDepth > 0 ? m_urgentEvents : m_events;
+
+    // front pushing is a way to execute an event before others
+    if (pushFront) {
+        task->next = list.head;
+        list.head = task;
+        if (!list.tail)
+            list.tail = task;
+        // the poll event list only grows when pushing into front
+        ++list.pollSize;
+    } else {
+        task->next = nullptr;
+        if (list.tail)
+            list.tail->next = task;
+        else
+            list.head = task;
+        list.tail = task;
+    }
+    ++list.size;
+}
+
+void EventDispatcher::pushScheduledTask(EventTask* task, const ticks_t ticks)
+{
+    task->ticks = ticks;
+    task->state = EventTask::SCHEDULED;
+    m_scheduledEventList.push(task);
+}
+
+EventTask* EventDispatcher::popEventTask(EventList& list)
+{
+    EventTask* task = list.head;
+    list.head = task->next;
+    if (!list.head)
+        list.tail = nullptr;
+    task->next = nullptr;
+    --list.size;
+    return task;
+}
+
+void EventDispatcher::executeEventTask(EventTask* task)
+{
+    task->state = EventTask::RUNNING;
+
+    if (!task->event) {
+        if (!task->canceled)
+            task->callback();
+    } else if (task->event->getSource().empty()) {
+        task->event->execute();
+    } else {
+        const int64_t startTime = stdext::micros();
+        task->event->execute();
+        auto& source = m_sourceStats[task->event->getSource()];
+        ++source.executed;
+        source.totalTime += stdext::micros() - startTime;
+    }
+
+    m_taskPool.release(task);
+}
+
+bool EventDispatcher::executeScheduledTask(EventTask* task)
+{
+    const int lateness = g_clock.millis() - task->ticks;
+    task->state = EventTask::RUNNING;
+
+    if (!task->event) {
+        const bool canceled = task->canceled;
+        if (!canceled) {
+            task->callback();
+            addLateness({}, lateness, 0);
+        }
+        m_taskPool.release(task);
+        return !canceled;
+    }
+
+    // holds the event, releasing the node drops its reference
+    const auto scheduledEvent = task->event->static_self_cast<ScheduledEvent>();
+
+    const bool canceled = scheduledEvent->isCanceled();
+    const int64_t startTime = scheduledEvent->getSource().empty() ? 0 : stdext::micros();
+
+    scheduledEvent->execute();
+
+    if (!canceled)
+        addLateness(scheduledEvent->getSource(), lateness, startTime);
+
+    if (scheduledEvent->nextCycle()) {
+        pushScheduledTask(task, scheduledEvent->m_ticks);
+        return !canceled;
+    }
+
+    scheduledEvent->m_task = nullptr;
+    m_taskPool.release(task);
+    return !canceled;
+}
+
+void EventDispatcher::addLateness(const std::string& sourceName, const int lateness, const int64_t startTime)
+{
+    const auto& buckets = getLatenessBuckets();
+    const auto bucket = std::upper_bound(buckets.begin(), buckets.end(), lateness) - buckets.begin();
+    ++m_stats.lateness[bucket];
+    m_stats.maxLateness = std::max<int>(m_stats.maxLateness, lateness);
+
+    if (sourceName.empty())
+        return;
+
+    auto& source = m_sourceStats[sourceName];
+    ++source.executed;
+    ++source.scheduled;
+    source.totalLateness += lateness;
+    source.maxLateness = std::max<int>(source.maxLateness, lateness);
+    source.totalTime += stdext::micros() - startTime;
+}
+
+const std::vector<int>& EventDispatcher::getLatenessBuckets()
+{
+    static const std::vector<int> buckets{ 1, 2, 5, 10, 20, 50, 100, 250, 500 };
+    return buckets;
+}
+
+std::map<std::string, double> EventDispatcher::getStats()
+{
+    return {
+        { "scheduledExecuted", m_stats.scheduledExecuted },
+        { "eventsExecuted", m_stats.eventsExecuted },
+        { "urgentExecuted", m_stats.urgentExecuted },
+        { "loops", m_stats.loops },
+        { "spilledScheduled", m_stats.spilledScheduled },
+        { "spilledEvents", m_stats.spilledEvents },
+        { "pollBudget", m_pollBudget / 1000. },
+        { "pollTime", m_stats.time / 1000. },
+        { "polls", m_stats.polls },
+        { "totalScheduledExecuted", m_stats.totalScheduledExecuted },
+        { "totalEventsExecuted", m_stats.totalEventsExecuted },
+        { "maxEventsExecuted", m_stats.maxEventsExecuted },
+        { "averagePollTime", m_stats.polls ? m_stats.totalTime / 1000. / m_stats.polls : 0. },
+        { "maxPollTime", m_stats.maxTime / 1000. },
+        { "maxLateness", m_stats.maxLateness },
+        { "loopLimitHits", m_stats.loopLimitHits },
+        { "spills", m_stats.spills },
+        { "budgetOverruns", m_stats.budgetOverruns },
+        { "maxBudgetOverrun", m_stats.maxBudgetOverrun / 1000. },
+        { "pendingEvents", getEventsSize() },
+        { "pendingScheduledEvents", m_scheduledEventList.size() },
+        { "canceledScheduledEvents", getCanceledScheduledEvents() },
+        { "taskPoolCapacity", m_taskPool.getCapacity() },
+        { "taskPoolInUse", m_taskPool.getInUse() },
+        { "heapCallbacks", m_stats.heapCallbacks }
+    };
+}
+
+std::map<std::string, std::vector<double>> EventDispatcher::getSourceStats()
+{
+    std::map<std::string, std::vector<double>> ret;
+    for (const auto& [name, source] : m_sourceStats) {
+        ret.emplace(name, std::vector<double>{
+            static_cast<double>(source.executed),
+            source.scheduled ? static_cast<double>(source.totalLateness) / source.scheduled : 0.,
+            static_cast<double>(source.maxLateness),
+            source.totalTime / 1000.
+        });
+    }
+    return ret;
+}
+
+int EventDispatcher::getCanceledScheduledEvents()
+{
+    const auto& tasks = m_scheduledEventList.tasks();
+    return std::count_if(tasks.begin(), tasks.end(), [](const EventTask* task) { return task->canceled || (task->event && task->event->isCanceled()); });
+}
+
+void EventDispatcher::resetStats()
+{
+    m_stats = {};
+    m_sourceStats.clear();
 }
 
 ScheduledEventPtr EventDispatcher::scheduleEvent(const std::function<void()>& callback, int delay)
@@ -85,7 +358,7 @@ ScheduledEventPtr EventDispatcher::scheduleEvent(const std::function<void()>& ca
 
     assert(delay >= 0);
     ScheduledEventPtr scheduledEvent(new ScheduledEvent(callback, delay, 1));
-    m_scheduledEventList.push(scheduledEvent);
+    pushScheduledEvent(scheduledEvent);
     return scheduledEvent;
 }
 
@@ -96,7 +369,7 @@ ScheduledEventPtr EventDispatcher::cycleEvent(const std::function<void()>& callb
 
     assert(delay > 0);
     ScheduledEventPtr scheduledEvent(new ScheduledEvent(callback, delay, 0));
-    m_scheduledEventList.push(scheduledEvent);
+    pushScheduledEvent(scheduledEvent);
     return scheduledEvent;
 }
 
@@ -106,12 +379,16 @@ EventPtr EventDispatcher::addEvent(const std::function<void()>& callback, bool p
         return { new Event(nullptr) };
 
     EventPtr event(new Event(callback));
-    // front pushing is a way to execute an event before others
-    if (pushFront) {
-        m_eventList.push_front(event);
-        // the poll event list only grows when pushing into front
-        ++m_pollEventsSize;
-    } else
-        m_eventList.push_back(event);
+    EventTask* task = m_taskPool.acquire();
+    task->event = event;
+    pushEventTask(task, pushFront);
     return event;
 }
+
+void EventDispatcher::pushScheduledEvent(const ScheduledEventPtr& scheduledEvent)
+{
+    EventTask* task = m_taskPool.acquire();
+    task->event = scheduledEvent;
+    scheduledEvent->m_task = task;
+    pushScheduledTask(task, scheduledEvent->m_ticks);
+}
@@ -23,9 +23,9 @@
 #pragma once
 
 #include "clock.h"
+#include "eventtask.h"
 #include "scheduledevent.h"
-
-#include <queue>
+#include "scheduledeventqueue.h"
 
  // @bindsingleton g_dispatcher
 class EventDispatcher
@@ -38,11 +38,145 @@ public:
     ScheduledEventPtr scheduleEvent(const std::function<void()>& callback, int delay);
     ScheduledEventPtr cycleEvent(const std::function<void()>& callback, int delay);
 
+    // fast path for internal events that Lua never sees: the callback is stored inside a pooled node,
+    // so there is no Event object, no std::function and no heap allocation once the pool is warm
+    template<typename F>
+    EventTaskHandle addTask(F&& callback, bool pushFront = false)
+    {
+        EventTask* task = createTask(std::forward<F>(callback));
+        if (!task)
+            return {};
+
+        pushEventTask(task, pushFront);
+        return task;
+    }
+
+    template<typename F>
+    EventTaskHandle scheduleTask(F&& callback, int delay)
+    {
+        assert(delay >= 0);
+        EventTask* task = createTask(std::forward<F>(callback));
+        if (!task)
+            return {};
+
+        pushScheduledTask(task, g_clock.millis() + delay);
+        return task;
+    }
+
+    void cancelTask(EventTask* task);
+
+    // time a poll may spend on non urgent work, in microseconds, 0 disables the budget;
+    // what does not fit stays queued in order for the next poll, the first event of a poll always runs.
+    // ui layout and style updates are added as urgent, so the frame never renders them half done
+    void setPollBudget(int micros) { m_pollBudget = micros; }
+    int getPollBudget() { return m_pollBudget; }
+
+    // events added while a scope is alive, or by an urgent event, are urgent: they run first and ignore the budget
+    class UrgentScope
+    {
+    public:
+        UrgentScope();
+        ~UrgentScope();
+    };
+
+    // upper bounds (exclusive, in milliseconds) of the scheduled event lateness histogram, the last bucket is open
+    static const std::vector<int>& getLatenessBuckets();
+    // number of scheduled events executed in each lateness bucket
+    std::vector<int> getLatenessHistogram() { return { m_stats.lateness.begin(), m_stats.lateness.end() }; }
+    // counters of the last poll and accumulated since the last reset
+    std::map<std::string, double> getStats();
+    // source label -> { executed, average lateness ms, max lateness ms, total execution ms }
+    // the lateness columns only account scheduled and cycle events
+    std::map<std::string, std::vector<double>> getSourceStats();
+    // canceled scheduled events still queued, they leave the queue as soon as they are canceled so this should stay at 0
+    int getCanceledScheduledEvents();
+    int getScheduledEventsSize() { return m_scheduledEventList.size(); }
+    int getEventsSize() { return m_events.size + m_urgentEvents.size; }
+    void resetStats();
+
 private:
-    std::deque<EventPtr> m_eventList;
-    int m_pollEventsSize;
+    static constexpr int LATENESS_BUCKETS = 10;
+
+    struct SourceStats
+    {
+        uint32_t executed{ 0 };
+        uint32_t scheduled{ 0 };
+        int64_t totalLateness{ 0 }; // milliseconds
+        int maxLateness{ 0 };
+        int64_t totalTime{ 0 }; // microseconds
+    };
+
+    struct Stats
+    {
+        std::array<int, LATENESS_BUCKETS> lateness{};
+        int maxLateness{ 0 };
+
+        // last poll
+        int scheduledExecuted{ 0 };
+        int eventsExecuted{ 0 };
+        int urgentExecuted{ 0 };
+        int loops{ 0 };
+        int spilledScheduled{ 0 }; // due scheduled events left for the next poll
+        int spilledEvents{ 0 };
+        int64_t time{ 0 }; // microseconds
+
+        // accumulated
+        uint64_t polls{ 0 };
+        uint64_t totalScheduledExecuted{ 0 };
+        uint64_t totalEventsExecuted{ 0 };
+        int64_t totalTime{ 0 };
+        int64_t maxTime{ 0 };
+        int maxEventsExecuted{ 0 };
+        int loopLimitHits{ 0 };
+        uint64_t spills{ 0 }; // polls that left work for the next one
+        uint64_t budgetOverruns{ 0 }; // polls that took longer than the budget
+        int64_t maxBudgetOverrun{ 0 }; // microseconds past the budget
+        uint64_t heapCallbacks{ 0 }; // tasks whose callback did not fit the inline storage
+    };
+
+    template<typename F>
+    EventTask* createTask(F&& callback)
+    {
+        if (m_disabled)
+            return nullptr;
+
+        EventTask* task = m_taskPool.acquire();
+        if (!task->callback.set(std::forward<F>(callback)))
+            ++m_stats.heapCallbacks;
+        return task;
+    }
+
+    // intrusive FIFO of pending events, linked through EventTask::next
+    struct EventList
+    {
+        EventTask* head{ nullptr };
+        EventTask* tail{ nullptr };
+        int size{ 0 };
+        int pollSize{ 0 }; // events the running round still has to execute
+    };
+
+    void pushEventTask(EventTask* task, bool pushFront);
+    void pushScheduledTask(EventTask* task, ticks_t ticks);
+    EventTask* popEventTask(EventList& list);
+    int executeEvents(EventList& list, int64_t deadline, int& loops);
+    void pushScheduledEvent(const ScheduledEventPtr& scheduledEvent);
+    void executeEventTask(EventTask* task);
+    bool executeScheduledTask(EventTask* task);
+    void addLateness(const std::string& sourceName, int lateness, int64_t startTime);
+
+    EventList m_events;
+    EventList m_urgentEvents;
+    int m_urgentDepth{ 0 };
+    int m_pollBudget{ 8000 };
     bool m_disabled{ false };
-    std::priority_queue<ScheduledEventPtr, std::deque<ScheduledEventPtr>, ScheduledEvent::Compare> m_scheduledEventList;
+    ScheduledEventQueue m_scheduledEventList;
+    EventTaskPool m_taskPool;
+
+    Stats m_stats;
+    std::unordered_map<std::string, SourceStats> m_sourceStats;
 };
 
 extern EventDispatcher g_dispatcher;
+
+inline EventDispatcher::UrgentScope::UrgentScope() { ++g_dispatcher.m_urgentDepth; }
+inline EventDispatcher::UrgentScope::~UrgentScope() { --g_dispatcher.m_urgentDepth; }
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "eventtask.h"
+#include "eventdispatcher.h"
+
+EventTask* EventTaskPool::acquire()
+{
+    if (!m_free) {
+        auto& chunk = m_chunks.emplace_back(new EventTask[CHUNK_SIZE]);
+        for (size_t i = CHUNK_SIZE; i-- > 0;) {
+            chunk[i].next = m_free;
+            m_free = &chunk[i];
+        }
+    }
+
+    EventTask* task = m_free;
+    m_free = task->next;
+    task->next = nullptr;
+    ++m_inUse;
+    return task;
+}
+
+void EventTaskPool::release(EventTask* task)
+{
+    task->callback.reset();
+    task->event = nullptr;
+    task->heapIndex = -1;
+    task->canceled = false;
+    task->state = EventTask::FREE;
+    ++task->generation;
+
+    task->next = m_free;
+    m_free = task;
+    --m_inUse;
+}
+
+void EventTaskHandle::cancel()
+{
+    if (m_task && m_task->generation == m_generation)
+        g_dispatcher.cancelTask(m_task);
+}
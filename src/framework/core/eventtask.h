@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "declarations.h"
+#include "event.h"
+
+/**
+ * Type erased void() callable that keeps captures of up to INLINE_SIZE bytes
+ * inside the object, so queuing a lambda does not allocate. Larger callables
+ * fall back to the heap. Objects are never moved, they live inside the pooled
+ * EventTask nodes.
+ */
+class TaskCallback
+{
+public:
+    static constexpr size_t INLINE_SIZE = 48;
+
+    TaskCallback() = default;
+    ~TaskCallback() { reset(); }
+
+    TaskCallback(const TaskCallback&) = delete;
+    TaskCallback& operator=(const TaskCallback&) = delete;
+
+    // returns false when the callable did not fit in the inline storage
+    template<typename F>
+    bool set(F&& callback)
+    {
+        using Fn = std::decay_t<F>;
+        reset();
+
+        if constexpr (sizeof(Fn) <= INLINE_SIZE && alignof(Fn) <= alignof(std::max_align_t)) {
+            new (m_storage) Fn(std::forward<F>(callback));
+            m_invoke = [](void* storage) { (*static_cast<Fn*>(storage))(); };
+            m_destroy = [](void* storage) { static_cast<Fn*>(storage)->~Fn(); };
+            return true;
+        } else {
+            *reinterpret_cast<Fn**>(m_storage) = new Fn(std::forward<F>(callback));
+            m_invoke = [](void* storage) { (**static_cast<Fn**>(storage))(); };
+            m_destroy = [](void* storage) { delete *static_cast<Fn**>(storage); };
+            return false;
+        }
+    }
+
+    void reset()
+    {
+        if (!m_destroy)
+            return;
+
+        // cleared before destroying, the captures may queue new events
+        const auto destroy = m_destroy;
+        m_invoke = nullptr;
+        m_destroy = nullptr;
+        destroy(m_storage);
+    }
+
+    void operator()() { m_invoke(m_storage); }
+    explicit operator bool() const { return m_invoke != nullptr; }
+
+private:
+    alignas(std::max_align_t) uint8_t m_storage[INLINE_SIZE];
+    void (*m_invoke)(void*) { nullptr };
+    void (*m_destroy)(void*) { nullptr };
+};
+
+/**
+ * Node of the dispatcher queues. Internal C++ events only use the inline
+ * callback, events created for Lua (addEvent, scheduleEvent, cycleEvent)
+ * carry their Event handle instead.
+ */
+struct EventTask
+{
+    enum State : uint8_t
+    {
+        FREE,
+        QUEUED, // in the event list
+        SCHEDULED, // in the scheduled event queue
+        RUNNING
+    };
+
+    TaskCallback callback;
+    EventPtr event;
+    ticks_t ticks{ 0 };
+    uint64_t sequence{ 0 };
+    EventTask* next{ nullptr };
+    int heapIndex{ -1 };
+    uint32_t generation{ 0 };
+    State state{ FREE };
+    bool canceled{ false };
+};
+
+// free list of EventTask nodes allocated in chunks, nodes are never returned to the system
+class EventTaskPool
+{
+public:
+    EventTask* acquire();
+    void release(EventTask* task);
+
+    size_t getCapacity() { return m_chunks.size() * CHUNK_SIZE; }
+    size_t getInUse() { return m_inUse; }
+
+private:
+    static constexpr size_t CHUNK_SIZE = 256;
+
+    std::vector<std::unique_ptr<EventTask[]>> m_chunks;
+    EventTask* m_free{ nullptr };
+    size_t m_inUse{ 0 };
+};
+
+// handle to a queued task, it is safe to keep after the task ran since the node generation is checked
+class EventTaskHandle
+{
+public:
+    EventTaskHandle() = default;
+    EventTaskHandle(EventTask* task) : m_task(task), m_generation(task->generation) {}
+
+    bool isPending() const
+    {
+        return m_task && m_task->generation == m_generation && !m_task->canceled &&
+            (m_task->state == EventTask::QUEUED || m_task->state == EventTask::SCHEDULED);
+    }
+
+    void cancel();
+
+private:
+    EventTask* m_task{ nullptr };
+    uint32_t m_generation{ 0 };
+};
@@ -23,8 +23,10 @@
 #include "graphicalapplication.h"
 #include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/profiler.h>
 #include <framework/graphics/drawpoolmanager.h>
 #include <framework/graphics/graphics.h>
+#include <framework/graphics/image.h>
 #include <framework/graphics/particlemanager.h>
 #include <framework/graphics/texturemanager.h>
 #include <framework/input/mouse.h>
@@ -43,9 +45,11 @@ void GraphicalApplication::init(std::vector<std::string>& args)
 {
     Application::init(args);
 
-    // setup platform window
-    g_window.init();
-    g_window.hide();
+    // setup platform window, the null graphics backend has none
+    if (!g_graphics.isNullBackend()) {
+        g_window.init();
+        g_window.hide();
+    }
     g_window.setOnResize([this](auto&& PH1) { resize(std::forward<decltype(PH1)>(PH1)); });
     g_window.setOnInputEvent([this](auto&& PH1) { inputEvent(std::forward<decltype(PH1)>(PH1)); });
     g_window.setOnClose([this] { close(); });
@@ -71,7 +75,8 @@ void GraphicalApplication::init(std::vector<std::string>& args)
 void GraphicalApplication::deinit()
 {
     // hide the window because there is no render anymore
-    g_window.hide();
+    if (!g_graphics.isNullBackend())
+        g_window.hide();
 
     Application::deinit();
 }
@@ -97,7 +102,8 @@ void GraphicalApplication::terminate()
     // terminate graphics
     g_drawPool.terminate();
     g_graphics.terminate();
-    g_window.terminate();
+    if (!g_graphics.isNullBackend())
+        g_window.terminate();
 
     m_terminated = true;
 }
@@ -128,19 +134,35 @@ void GraphicalApplication::run()
     while (!m_stopping) {
         g_clock.update();
 
-        // poll all events before rendering
-        poll();
+        m_frameCounter.setWindowState(!g_window.isVisible() ? AdaptativeFrameCounter::MINIMIZED :
+                                      g_window.hasFocus() ? AdaptativeFrameCounter::FOCUSED : AdaptativeFrameCounter::UNFOCUSED);
 
-        if (!g_window.isVisible()) {
-            // sleeps until next poll to avoid massive cpu usage
-            stdext::millisleep(1);
+        // nothing is drawn while minimized or before the next frame deadline, sleeps in short slices
+        // instead of spinning, still polling input and network between them
+        if (!m_frameCounter.canRefresh() || !g_window.isVisible()) {
+            poll();
+            m_frameCounter.waitForNextFrame();
             continue;
         }
 
-        if (!m_frameCounter.canRefresh()) {
-            continue;
+        PROFILE_BEGIN_FRAME();
+
+        if (m_renderThreadEnabled != m_renderThread.joinable()) {
+            if (m_renderThreadEnabled) startRenderThread();
+            else stopRenderThread();
+        }
+
+        // poll all events before rendering
+        {
+            PROFILE_ZONE("poll");
+            poll();
         }
 
+        // the frame recorded by the previous iteration is drawn while this one is recorded,
+        // polling stays before the handoff as it may load textures and shaders
+        if (m_framePending)
+            submitFrame();
+
         // the screen consists of two panes
         {
             if (foregroundRefresh.ticksElapsed() >= 100) { // 10 FPS (1000 / 10)
@@ -150,37 +172,158 @@ void GraphicalApplication::run()
 
             // foreground pane - steady pane with few animated stuff (UI)
             if (foreground->canRepaint()) {
+                PROFILE_ZONE("ui.foreground");
                 g_drawPool.use(DrawPoolType::FOREGROUND);
                 g_ui.render(Fw::ForegroundPane);
             }
 
             // background pane - high updated and animated pane (where the game are stuff happens)
+            PROFILE_ZONE("ui.background");
             g_ui.render(Fw::BackgroundPane);
         }
 
-        // Draw All Pools
-        g_drawPool.draw();
+        g_drawPool.addStatsOverlay();
+
+        if (m_renderThread.joinable()) {
+            {
+                PROFILE_ZONE("render.wait");
+                waitFrame();
+            }
+
+            g_drawPool.swap();
+            m_renderCaptureFile = std::move(m_frameCaptureFile);
+            m_frameCaptureFile.clear();
+            m_framePending = true;
+        } else {
+            // Draw All Pools
+            {
+                PROFILE_ZONE("drawpool.draw");
+                g_drawPool.draw();
+            }
+
+            if (!m_frameCaptureFile.empty()) {
+                try {
+                    g_graphics.readScreen()->savePNG(m_frameCaptureFile);
+                } catch (const stdext::exception& e) {
+                    g_logger.error(stdext::format("Unable to capture frame to '%s': %s", m_frameCaptureFile, e.what()));
+                }
+                m_frameCaptureFile.clear();
+            }
+
+            // update screen pixels
+            {
+                PROFILE_ZONE("swapBuffers");
+                g_window.swapBuffers();
+            }
+        }
 
-        // update screen pixels
-        g_window.swapBuffers();
+        PROFILE_END_FRAME();
 
         if (m_frameCounter.update()) {
             g_lua.callGlobalField("g_app", "onFps", m_frameCounter.getFps());
         }
     }
 
+    stopRenderThread();
+
     m_stopping = false;
     m_running = false;
 }
 
+void GraphicalApplication::renderFrame(const std::string& captureFile)
+{
+    g_drawPool.drawFrame();
+
+    if (!captureFile.empty()) {
+        try {
+            g_graphics.readScreen()->savePNG(captureFile);
+        } catch (const stdext::exception& e) {
+            g_logger.error(stdext::format("Unable to capture frame to '%s': %s", captureFile, e.what()));
+        }
+    }
+
+    g_window.swapBuffers();
+}
+
+void GraphicalApplication::startRenderThread()
+{
+    m_renderThread = std::thread([this] {
+        std::unique_lock lock(m_renderMutex);
+        while (true) {
+            m_renderCondition.wait(lock, [this] { return m_renderBusy || m_renderExit; });
+            if (!m_renderBusy)
+                break;
+
+            lock.unlock();
+            g_graphics.makeCurrent();
+            renderFrame(m_renderCaptureFile);
+            g_graphics.releaseCurrent();
+            lock.lock();
+
+            m_renderBusy = false;
+            m_renderCondition.notify_all();
+        }
+    });
+}
+
+void GraphicalApplication::stopRenderThread()
+{
+    if (!m_renderThread.joinable())
+        return;
+
+    waitFrame();
+    {
+        std::scoped_lock lock(m_renderMutex);
+        m_renderExit = true;
+    }
+    m_renderCondition.notify_all();
+    m_renderThread.join();
+    m_renderExit = false;
+
+    // the frame that was handed off is not lost, it is drawn here
+    if (m_framePending) {
+        renderFrame(m_renderCaptureFile);
+        g_drawPool.release();
+        m_framePending = false;
+    }
+}
+
+void GraphicalApplication::submitFrame()
+{
+    g_graphics.releaseCurrent();
+    {
+        std::scoped_lock lock(m_renderMutex);
+        m_renderBusy = true;
+    }
+    m_renderCondition.notify_all();
+    m_framePending = false;
+}
+
+void GraphicalApplication::waitFrame()
+{
+    // the context is still here when nothing was submitted
+    if (g_graphics.isCurrent())
+        return;
+
+    {
+        std::unique_lock lock(m_renderMutex);
+        m_renderCondition.wait(lock, [this] { return !m_renderBusy; });
+    }
+
+    g_graphics.makeCurrent();
+}
+
 void GraphicalApplication::poll()
 {
 #ifdef FRAMEWORK_SOUND
     g_sounds.poll();
 #endif
 
-    // poll window input events
-    g_window.poll();
+    // poll window input events, what they queue is not deferred by the dispatcher budget
+    {
+        EventDispatcher::UrgentScope urgent;
+        g_window.poll();
+    }
     g_particles.poll();
     g_textures.poll();
 
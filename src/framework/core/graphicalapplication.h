@@ -29,6 +29,10 @@
 
 #include "application.h"
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 class GraphicalApplication : public Application
 {
 public:
@@ -44,6 +48,15 @@ public:
     int getFps() { return m_frameCounter.getFps(); }
     int getMaxFps() { return m_frameCounter.getMaxFps(); }
 
+    void setUnfocusedMaxFps(int maxFps) { m_frameCounter.setUnfocusedMaxFps(maxFps); }
+    int getUnfocusedMaxFps() { return m_frameCounter.getUnfocusedMaxFps(); }
+    void setMinimizedMaxFps(int maxFps) { m_frameCounter.setMinimizedMaxFps(maxFps); }
+    int getMinimizedMaxFps() { return m_frameCounter.getMinimizedMaxFps(); }
+
+    float getFrameTime() { return m_frameCounter.getFrameTime(); }
+    float getMaxFrameTime() { return m_frameCounter.getMaxFrameTime(); }
+    float getFrameJitter() { return m_frameCounter.getJitter(); }
+
     bool isOnInputEvent() { return m_onInputEvent; }
     bool canOptimize() { return m_optimize && getFps() < 60; }
     bool isForcedEffectOptimization() { return m_forceEffectOptimization; }
@@ -56,11 +69,26 @@ public:
 
     void repaint();
 
+    // saves the next rendered frame as a png file, in the write directory
+    void captureFrame(const std::string& fileName) { m_frameCaptureFile = fileName; }
+
+    // submits the frames from a render thread, which owns the gl context while the main thread
+    // records the next frame, takes effect on the next frame
+    void setRenderThread(bool enable) { m_renderThreadEnabled = enable; }
+    bool isRenderThreadEnabled() { return m_renderThreadEnabled; }
+
 protected:
     void resize(const Size& size);
     void inputEvent(const InputEvent& event);
 
 private:
+    void renderFrame(const std::string& captureFile);
+
+    void startRenderThread();
+    void stopRenderThread();
+    void submitFrame();
+    void waitFrame();
+
     bool m_onInputEvent{ false },
         m_optimize{ true },
         m_forceEffectOptimization{ false },
@@ -69,7 +97,19 @@ private:
 
     Timer m_foregroundRefreshTime;
 
+    std::string m_frameCaptureFile;
+
     AdaptativeFrameCounter m_frameCounter;
+
+    std::thread m_renderThread;
+    std::mutex m_renderMutex;
+    std::condition_variable m_renderCondition;
+    std::string m_renderCaptureFile;
+
+    bool m_renderThreadEnabled{ false },
+        m_renderBusy{ false },
+        m_renderExit{ false },
+        m_framePending{ false };
 };
 
 extern GraphicalApplication g_app;
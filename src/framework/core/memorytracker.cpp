@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "memorytracker.h"
+#include "eventdispatcher.h"
+
+MemoryTracker g_memory;
+
+void MemoryTracker::terminate()
+{
+    if (m_logEvent) {
+        m_logEvent->cancel();
+        m_logEvent = nullptr;
+    }
+}
+
+int64_t MemoryTracker::getTotalBytes()
+{
+    int64_t total = 0;
+    for (const auto& usage : m_usage)
+        total += usage.bytes.load(std::memory_order_relaxed);
+    return total;
+}
+
+std::string MemoryTracker::getCategoryName(Category category)
+{
+    switch (category) {
+        case SPRITE_SHEETS: return "spriteSheets";
+        case THING_TEXTURES: return "thingTextures";
+        case TEXTURES: return "textures";
+        case TILES: return "tiles";
+        case ITEMS: return "items";
+        case CREATURES: return "creatures";
+        case MINIMAP: return "minimap";
+        case OTML_NODES: return "otmlNodes";
+        case LUA_REFS: return "luaRefs";
+        case SOUND_BUFFERS: return "soundBuffers";
+        default: return "unknown";
+    }
+}
+
+std::map<std::string, std::vector<int64_t>> MemoryTracker::getUsage()
+{
+    std::map<std::string, std::vector<int64_t>> usage;
+    for (int_fast8_t i = -1; ++i < LAST_CATEGORY;) {
+        const auto category = static_cast<Category>(i);
+        usage[getCategoryName(category)] = { getBytes(category), getCount(category) };
+    }
+    return usage;
+}
+
+std::string MemoryTracker::getSummary()
+{
+    constexpr double MB = 1024. * 1024.;
+
+    std::string summary;
+    for (int_fast8_t i = -1; ++i < LAST_CATEGORY;) {
+        const auto category = static_cast<Category>(i);
+        const int64_t count = getCount(category);
+        if (count == 0)
+            continue;
+
+        summary += stdext::format("%s %.2fMB (%s), ", getCategoryName(category), getBytes(category) / MB, std::to_string(count));
+    }
+
+    return summary + stdext::format("total %.2fMB", getTotalBytes() / MB);
+}
+
+void MemoryTracker::setLogInterval(int interval)
+{
+    m_logInterval = std::max<int>(0, interval);
+
+    if (m_logEvent) {
+        m_logEvent->cancel();
+        m_logEvent = nullptr;
+    }
+
+    if (m_logInterval > 0)
+        m_logEvent = g_dispatcher.cycleEvent([this] { g_logger.info("Memory usage: " + getSummary()); }, m_logInterval);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "declarations.h"
+
+#include <atomic>
+
+/**
+ * Live memory accounting, keeps the bytes and the number of objects that each
+ * subsystem currently holds so leaks and oversized caches can be spotted on
+ * long running clients. Sizes are the payload each subsystem allocates
+ * (pixels, samples, sizeof of the instance), not the allocator overhead.
+ * Counters are atomic because sheets and textures may be loaded outside the
+ * main thread.
+ */
+class MemoryTracker
+{
+public:
+    enum Category : uint8_t
+    {
+        SPRITE_SHEETS,
+        THING_TEXTURES,
+        TEXTURES,
+        TILES,
+        ITEMS,
+        CREATURES,
+        MINIMAP,
+        OTML_NODES,
+        LUA_REFS,
+        SOUND_BUFFERS,
+        LAST_CATEGORY
+    };
+
+    void terminate();
+
+    void add(Category category, int64_t bytes, int64_t count = 1)
+    {
+        m_usage[category].bytes.fetch_add(bytes, std::memory_order_relaxed);
+        m_usage[category].count.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void remove(Category category, int64_t bytes, int64_t count = 1) { add(category, -bytes, -count); }
+
+    int64_t getBytes(Category category) { return m_usage[category].bytes.load(std::memory_order_relaxed); }
+    int64_t getCount(Category category) { return m_usage[category].count.load(std::memory_order_relaxed); }
+    int64_t getTotalBytes();
+
+    static std::string getCategoryName(Category category);
+
+    // category name -> { bytes, count }
+    std::map<std::string, std::vector<int64_t>> getUsage();
+    // single line with every non empty category, the one written by the periodic log
+    std::string getSummary();
+
+    // logs the summary every interval milliseconds, 0 disables it
+    void setLogInterval(int interval);
+    int getLogInterval() { return m_logInterval; }
+
+private:
+    struct Usage
+    {
+        std::atomic<int64_t> bytes{ 0 };
+        std::atomic<int64_t> count{ 0 };
+    };
+
+    std::array<Usage, LAST_CATEGORY> m_usage;
+
+    int m_logInterval{ 0 };
+    ScheduledEventPtr m_logEvent;
+};
+
+extern MemoryTracker g_memory;
@@ -198,6 +198,9 @@ void Module::discover(const OTMLNodePtr& moduleNode)
     m_sandboxed = moduleNode->valueAt<bool>("sandboxed", false);
     m_autoLoadPriority = moduleNode->valueAt<int>("autoload-priority", 9999);
 
+    const std::string& source = moduleNode->source();
+    m_path = source.substr(0, source.find_last_of('/'));
+
     if (const OTMLNodePtr node = moduleNode->get("dependencies")) {
         for (const OTMLNodePtr& tmp : node->children())
             m_dependencies.push_back(tmp->value());
@@ -51,6 +51,7 @@ public:
     std::string getAuthor() { return m_author; }
     std::string getWebsite() { return m_website; }
     std::string getVersion() { return m_version; }
+    std::string getPath() { return m_path; }
     bool isAutoLoad() { return m_autoLoad; }
     int getAutoLoadPriority() { return m_autoLoadPriority; }
 
@@ -76,6 +77,7 @@ private:
     std::string m_author;
     std::string m_website;
     std::string m_version;
+    std::string m_path;
     std::function<void()> m_loadCallback;
     std::function<void()> m_unloadCallback;
     std::list<std::string> m_dependencies;
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "profiler.h"
+#include <framework/core/resourcemanager.h>
+
+Profiler g_profiler;
+
+void Profiler::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+
+#ifndef FRAMEWORK_PROFILER
+    if (enabled)
+        g_logger.warning("The profiler zones were not compiled in, rebuild with TOGGLE_PROFILER to use them.");
+#endif
+
+    m_enabled = enabled;
+    m_recording = false;
+    m_depth = 0;
+
+    for (auto& frame : m_frames) {
+        frame.id = 0;
+        frame.zones.clear();
+    }
+}
+
+void Profiler::setFrameCount(int count)
+{
+    m_frames.clear();
+    m_frames.resize(std::max<int>(1, count));
+    m_recording = false;
+}
+
+void Profiler::beginFrame()
+{
+    if (!m_enabled)
+        return;
+
+    // a frame that was started but never ended (nothing rendered) is overwritten
+    auto& frame = m_frames[m_frameId % m_frames.size()];
+    frame.id = 0;
+    frame.start = now();
+    frame.zones.clear();
+
+    m_depth = 0;
+    m_recording = true;
+}
+
+void Profiler::endFrame()
+{
+    if (!m_recording)
+        return;
+
+    auto& frame = m_frames[m_frameId % m_frames.size()];
+    frame.duration = now() - frame.start;
+    frame.id = ++m_frameId;
+
+    m_recording = false;
+}
+
+void Profiler::leaveZone(const char* name, int64_t start, uint8_t depth)
+{
+    m_depth = depth;
+    if (!m_recording)
+        return;
+
+    m_frames[m_frameId % m_frames.size()].zones.push_back({ name, start, now() - start, depth });
+}
+
+template<typename F>
+void Profiler::forEachFrame(int count, const F& f)
+{
+    const size_t size = m_frames.size();
+    for (size_t i = 1; i <= size && count > 0; ++i) {
+        const auto& frame = m_frames[(m_frameId - i + size * 2) % size];
+        if (frame.id == 0)
+            break;
+
+        f(frame);
+        --count;
+    }
+}
+
+std::vector<std::map<std::string, double>> Profiler::getFrames(int count)
+{
+    std::vector<std::map<std::string, double>> frames;
+    forEachFrame(count, [&](const Frame& frame) {
+        auto& zones = frames.emplace_back();
+        zones["frame"] = frame.id;
+        zones["total"] = frame.duration / 1000000.0;
+        for (const auto& zone : frame.zones)
+            zones[zone.name] += zone.duration / 1000000.0;
+    });
+    return frames;
+}
+
+std::map<std::string, std::vector<double>> Profiler::getSummary()
+{
+    std::map<std::string, std::vector<double>> summary;
+    int frames = 0;
+
+    forEachFrame(m_frames.size(), [&](const Frame& frame) {
+        std::map<std::string, double> zones;
+        zones["total"] = frame.duration / 1000000.0;
+        for (const auto& zone : frame.zones)
+            zones[zone.name] += zone.duration / 1000000.0;
+
+        for (const auto& [name, ms] : zones) {
+            auto& values = summary[name];
+            if (values.empty())
+                values = { 0, 0 };
+            values[0] += ms;
+            values[1] = std::max<double>(values[1], ms);
+        }
+        ++frames;
+    });
+
+    for (auto& [name, values] : summary)
+        values[0] /= frames;
+
+    return summary;
+}
+
+bool Profiler::dumpTrace(const std::string& fileName)
+{
+    int64_t origin = -1;
+    forEachFrame(m_frames.size(), [&](const Frame& frame) { origin = frame.start; });
+    if (origin < 0)
+        return false;
+
+    // the ring is walked from the newest frame, the trace viewer sorts by timestamp anyway
+    std::string trace = "{\"traceEvents\":[";
+    bool first = true;
+    const auto addEvent = [&](const std::string_view name, const int64_t start, const int64_t duration) {
+        if (!first) trace += ',';
+        first = false;
+        trace += stdext::format(R"({"name":"%s","ph":"X","pid":1,"tid":1,"ts":%.3f,"dur":%.3f})",
+                                name, (start - origin) / 1000.0, duration / 1000.0);
+    };
+
+    forEachFrame(m_frames.size(), [&](const Frame& frame) {
+        addEvent("frame " + std::to_string(frame.id), frame.start, frame.duration);
+        for (const auto& zone : frame.zones)
+            addEvent(zone.name, zone.start, zone.duration);
+    });
+    trace += "],\"displayTimeUnit\":\"ms\"}";
+
+    if (!g_resources.writeFileContents(fileName, trace)) {
+        g_logger.error(stdext::format("Unable to write profiler trace '%s'", fileName));
+        return false;
+    }
+    return true;
+}
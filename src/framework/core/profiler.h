@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <framework/global.h>
+
+#include <chrono>
+
+/**
+ * Frame profiler, records the duration of named zones inside the main loop.
+ *
+ * Zones are declared with PROFILE_ZONE("name") and only exist when the client
+ * is built with FRAMEWORK_PROFILER, otherwise the macros expand to nothing.
+ * Recording is also disabled at runtime until setEnabled(true) is called.
+ * Zones must be opened on the main thread, between beginFrame and endFrame.
+ */
+class Profiler
+{
+public:
+    struct Zone
+    {
+        const char* name;
+        int64_t start; // nanoseconds
+        int64_t duration;
+        uint8_t depth;
+    };
+
+    struct Frame
+    {
+        uint64_t id{ 0 };
+        int64_t start{ 0 };
+        int64_t duration{ 0 };
+        std::vector<Zone> zones;
+    };
+
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void setEnabled(bool enabled);
+    bool isEnabled() { return m_enabled; }
+    bool isRecording() { return m_recording; }
+
+    void setFrameCount(int count);
+    int getFrameCount() { return m_frames.size(); }
+
+    void beginFrame();
+    void endFrame();
+
+    uint8_t enterZone() { return m_depth++; }
+    void leaveZone(const char* name, int64_t start, uint8_t depth);
+
+    // zone name -> milliseconds spent on it, for each of the last recorded frames (newest first)
+    std::vector<std::map<std::string, double>> getFrames(int count);
+    // zone name -> { average, max } milliseconds per frame over the whole ring
+    std::map<std::string, std::vector<double>> getSummary();
+
+    // writes the recorded frames in the chrome trace event format (chrome://tracing, ui.perfetto.dev)
+    bool dumpTrace(const std::string& fileName);
+
+private:
+    template<typename F>
+    void forEachFrame(int count, const F& f);
+
+    bool m_enabled{ false },
+        m_recording{ false };
+
+    uint8_t m_depth{ 0 };
+    uint64_t m_frameId{ 0 };
+
+    std::vector<Frame> m_frames{ 300 };
+};
+
+extern Profiler g_profiler;
+
+class ProfilerZone
+{
+public:
+    ProfilerZone(const char* name)
+    {
+        if (g_profiler.isRecording()) {
+            m_name = name;
+            m_depth = g_profiler.enterZone();
+            m_start = Profiler::now();
+        }
+    }
+
+    ~ProfilerZone()
+    {
+        if (m_name)
+            g_profiler.leaveZone(m_name, m_start, m_depth);
+    }
+
+    ProfilerZone(const ProfilerZone&) = delete;
+    ProfilerZone& operator=(const ProfilerZone&) = delete;
+
+private:
+    const char* m_name{ nullptr };
+    int64_t m_start{ 0 };
+    uint8_t m_depth{ 0 };
+};
+
+#ifdef FRAMEWORK_PROFILER
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_ZONE(name) const ProfilerZone PROFILE_CONCAT(profilerZone, __LINE__)(name)
+#define PROFILE_BEGIN_FRAME() g_profiler.beginFrame()
+#define PROFILE_END_FRAME() g_profiler.endFrame()
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_BEGIN_FRAME()
+#define PROFILE_END_FRAME()
+#endif
@@ -27,6 +27,7 @@
 #include "filestream.h"
 
 #include <framework/core/application.h>
+#include <framework/core/asyncdispatcher.h>
 #include <framework/luaengine/luainterface.h>
 #include <framework/platform/platform.h>
 
@@ -203,6 +204,22 @@ std::string ResourceManager::readFileContents(const std::string& fileName)
     return buffer;
 }
 
+void ResourceManager::readFileContentsAsync(const std::string& fileName, const std::function<void(std::string, std::string)>& callback)
+{
+    // resolving needs the current script, only the full path goes to the worker
+    const std::string fullPath = resolvePath(fileName);
+
+    g_asyncDispatcher.scheduleThen([this, fullPath] {
+        try {
+            return std::make_pair(readFileContents(fullPath), std::string());
+        } catch (const stdext::exception& e) {
+            return std::make_pair(std::string(), std::string(e.what()));
+        }
+    }, [callback](const std::pair<std::string, std::string>& result) {
+        callback(result.first, result.second);
+    });
+}
+
 bool ResourceManager::writeFileBuffer(const std::string& fileName, const uint8_t* data, uint32_t size)
 {
     PHYSFS_file* file = PHYSFS_openWrite(fileName.c_str());
@@ -48,6 +48,8 @@ public:
     // @dontbind
     void readFileStream(const std::string& fileName, std::iostream& out);
     std::string readFileContents(const std::string& fileName);
+    // reads on a worker, callback(contents, error) runs on the main thread
+    void readFileContentsAsync(const std::string& fileName, const std::function<void(std::string, std::string)>& callback);
     // @dontbind
     bool writeFileBuffer(const std::string& fileName, const uint8_t* data, uint32_t size);
     bool writeFileContents(const std::string& fileName, const std::string& data);
@@ -21,6 +21,7 @@
  */
 
 #include "scheduledevent.h"
+#include "eventdispatcher.h"
 
 ScheduledEvent::ScheduledEvent(const std::function<void()>& callback, int delay, int maxCycles) : Event(callback)
 {
@@ -44,6 +45,15 @@ void ScheduledEvent::execute()
     ++m_cyclesExecuted;
 }
 
+void ScheduledEvent::cancel()
+{
+    Event::cancel();
+
+    // leave the dispatcher queue now instead of waiting for the ticks, the queue may hold the last reference
+    if (m_task)
+        g_dispatcher.cancelTask(m_task);
+}
+
 bool ScheduledEvent::nextCycle()
 {
     if (m_callback && !m_canceled && (m_maxCycles == 0 || m_cyclesExecuted < m_maxCycles)) {
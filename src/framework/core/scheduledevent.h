@@ -31,6 +31,7 @@ class ScheduledEvent : public Event
 public:
     ScheduledEvent(const std::function<void()>& callback, int delay, int maxCycles);
     void execute() override;
+    void cancel() override;
     bool nextCycle();
 
     int ticks() { return m_ticks; }
@@ -39,17 +40,14 @@ public:
     int cyclesExecuted() { return m_cyclesExecuted; }
     int maxCycles() { return m_maxCycles; }
 
-    struct Compare
-    {
-        bool operator() (const ScheduledEventPtr& a, const ScheduledEventPtr& b) const
-        {
-            return b->ticks() < a->ticks();
-        }
-    };
-
 private:
     ticks_t m_ticks;
     int m_delay;
     int m_maxCycles;
     int m_cyclesExecuted;
+
+    // dispatcher node, while the event is queued
+    EventTask* m_task{ nullptr };
+
+    friend class EventDispatcher;
 };
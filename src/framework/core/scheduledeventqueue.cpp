@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "scheduledeventqueue.h"
+
+void ScheduledEventQueue::push(EventTask* task)
+{
+    assert(task->heapIndex == -1);
+
+    task->sequence = m_sequence++;
+    m_heap.emplace_back(task);
+    task->heapIndex = m_heap.size() - 1;
+    siftUp(m_heap.size() - 1);
+}
+
+EventTask* ScheduledEventQueue::pop()
+{
+    return removeAt(0);
+}
+
+void ScheduledEventQueue::remove(EventTask* task)
+{
+    if (task->heapIndex >= 0)
+        removeAt(task->heapIndex);
+}
+
+EventTask* ScheduledEventQueue::removeAt(const size_t index)
+{
+    EventTask* task = m_heap[index];
+    EventTask* last = m_heap.back();
+    m_heap.pop_back();
+
+    // fills the hole with the last task and restores the heap from there
+    if (index < m_heap.size()) {
+        place(index, last);
+        if (index > 0 && before(m_heap[index], m_heap[(index - 1) / 2]))
+            siftUp(index);
+        else
+            siftDown(index);
+    }
+
+    task->heapIndex = -1;
+    return task;
+}
+
+void ScheduledEventQueue::place(const size_t index, EventTask* task)
+{
+    task->heapIndex = index;
+    m_heap[index] = task;
+}
+
+void ScheduledEventQueue::siftUp(size_t index)
+{
+    EventTask* task = m_heap[index];
+    while (index > 0) {
+        const size_t parent = (index - 1) / 2;
+        if (!before(task, m_heap[parent]))
+            break;
+
+        place(index, m_heap[parent]);
+        index = parent;
+    }
+    place(index, task);
+}
+
+void ScheduledEventQueue::siftDown(size_t index)
+{
+    EventTask* task = m_heap[index];
+    const size_t size = m_heap.size();
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= size)
+            break;
+
+        if (child + 1 < size && before(m_heap[child + 1], m_heap[child]))
+            ++child;
+
+        if (!before(m_heap[child], task))
+            break;
+
+        place(index, m_heap[child]);
+        index = child;
+    }
+    place(index, task);
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "eventtask.h"
+
+/**
+ * Min-heap of scheduled tasks ordered by ticks, then by insertion order.
+ *
+ * Every task knows its position in the heap, so canceling an event removes
+ * it right away in O(log n) instead of leaving a dead entry behind until its
+ * ticks are reached.
+ */
+class ScheduledEventQueue
+{
+public:
+    void push(EventTask* task);
+    EventTask* pop();
+    void remove(EventTask* task);
+
+    EventTask* top() const { return m_heap.front(); }
+    bool empty() const { return m_heap.empty(); }
+    size_t size() const { return m_heap.size(); }
+
+    const std::vector<EventTask*>& tasks() const { return m_heap; }
+
+private:
+    static bool before(const EventTask* a, const EventTask* b)
+    {
+        return a->ticks < b->ticks || (a->ticks == b->ticks && a->sequence < b->sequence);
+    }
+
+    EventTask* removeAt(size_t index);
+    void place(size_t index, EventTask* task);
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+
+    std::vector<EventTask*> m_heap;
+    uint64_t m_sequence{ 0 };
+};
@@ -47,6 +47,20 @@ AnimatedTexture::AnimatedTexture(const Size& size, const std::vector<ImagePtr>&
 AnimatedTexture::~AnimatedTexture()
 = default;
 
+void AnimatedTexture::create()
+{
+    // frames loaded without the context are uploaded here
+    for (const TexturePtr& frame : m_frames)
+        frame->create();
+
+    m_id = m_frames[m_currentFrame]->getId();
+}
+
+bool AnimatedTexture::isUploadPending()
+{
+    return std::any_of(m_frames.begin(), m_frames.end(), [](const TexturePtr& frame) { return frame->isUploadPending(); });
+}
+
 bool AnimatedTexture::buildHardwareMipmaps()
 {
     for (const TexturePtr& frame : m_frames)
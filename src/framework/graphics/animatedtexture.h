@@ -31,6 +31,8 @@ public:
     AnimatedTexture(const Size& size, const std::vector<ImagePtr>& frames, std::vector<int> framesDelay, bool buildMipmaps = false, bool compress = false);
     ~AnimatedTexture() override;
 
+    void create() override;
+    bool isUploadPending() override;
     bool buildHardwareMipmaps() override;
 
     void setSmooth(bool smooth) override;
@@ -70,12 +70,13 @@ int shift2[4] = { 6,4,2,0 };
 int mask1[8] = { 128,64,32,16,8,4,2,1 };
 int shift1[8] = { 7,6,5,4,3,2,1,0 };
 
-uint32_t    keep_original = 1;
-uint8_t   pal[256][3];
-uint8_t   trns[256];
-uint32_t    palsize, trnssize;
-uint32_t    hasTRNS;
-unsigned short  trns1, trns2, trns3;
+// decoding state, per thread so textures can be decoded on the workers
+thread_local uint32_t    keep_original = 1;
+thread_local uint8_t   pal[256][3];
+thread_local uint8_t   trns[256];
+thread_local uint32_t    palsize, trnssize;
+thread_local uint32_t    hasTRNS;
+thread_local unsigned short  trns1, trns2, trns3;
 
 #ifdef _MSC_VER
 #pragma warning( push )
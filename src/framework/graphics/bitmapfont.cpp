@@ -85,7 +85,7 @@ void BitmapFont::load(const OTMLNodePtr& fontNode)
 
 void BitmapFont::drawText(const std::string_view text, const Point& startPos, const Color color)
 {
-    const Size boxSize = g_painter->getResolution() - startPos.toSize();
+    const Size boxSize = g_graphics.getViewportSize() - startPos.toSize();
     const Rect screenCoords(startPos, boxSize);
     drawText(text, screenCoords, color, Fw::AlignTopLeft);
 }
@@ -67,11 +67,12 @@ void CoordsBuffer::addRepeatedRects(const Rect& dest, const Rect& src)
     }
 }
 
-void CoordsBuffer::cache()
+bool CoordsBuffer::cache()
 {
     if (!m_canCache)
-        return;
+        return false;
 
-    m_vertexArray.cache();
-    m_textureCoordArray.cache();
+    const bool vertices = m_vertexArray.cache();
+    const bool textureCoords = m_textureCoordArray.cache();
+    return vertices || textureCoords;
 }
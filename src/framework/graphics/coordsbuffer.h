@@ -79,13 +79,14 @@ public:
     int getVertexCount() const { return m_vertexArray.vertexCount(); }
     int getTextureCoordCount() const { return m_textureCoordArray.vertexCount(); }
 
-    void cache();
+    // returns whether the coords were (re)uploaded to the hardware buffers
+    bool cache();
 
-    bool isCached() { return m_vertexArray.isCached() || m_textureCoordArray.isCached(); }
+    bool isCached() const { return m_vertexArray.isCached() || m_textureCoordArray.isCached(); }
     void enableCache() { m_canCache = true; }
 
-    HardwareBuffer* getHardwareVertexCache() { return m_vertexArray.getHardwareCache(); }
-    HardwareBuffer* getHardwareTextureCoordCache() { return m_textureCoordArray.getHardwareCache(); }
+    HardwareBuffer* getHardwareVertexCache() const { return m_vertexArray.getHardwareCache(); }
+    HardwareBuffer* getHardwareTextureCoordCache() const { return m_textureCoordArray.getHardwareCache(); }
 
 private:
     VertexArray m_vertexArray;
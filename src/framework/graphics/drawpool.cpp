@@ -21,6 +21,7 @@
  */
 
 #include "drawpool.h"
+#include "drawpoolmanager.h"
 #include <framework/graphics/framebuffermanager.h>
 
 static constexpr int REFRESH_TIME = 1000 / 20; // 20 FPS (50ms)
@@ -33,7 +34,10 @@ DrawPool* DrawPool::create(const DrawPoolType type)
 
         pool = new DrawPoolFramed{ frameBuffer };
 
-        if (type == DrawPoolType::MAP) frameBuffer->disableBlend();
+        if (type == DrawPoolType::MAP) {
+            frameBuffer->disableBlend();
+            pool->m_reorderDrawings = true;
+        }
         else if (type == DrawPoolType::LIGHT) {
             pool->m_alwaysGroupDrawings = true;
             frameBuffer->setCompositionMode(CompositionMode::LIGHT);
@@ -44,15 +48,16 @@ DrawPool* DrawPool::create(const DrawPoolType type)
     }
 
     pool->m_type = type;
+    pool->resetFrame();
     return pool;
 }
 
 void DrawPool::add(const Color& color, const TexturePtr& texture, const DrawMethod& method, const DrawMode drawMode, const DrawBufferPtr& drawBuffer, const CoordsBufferPtr& coordsBuffer)
 {
-    const auto& state = PoolState{
-       g_painter->m_transformMatrix, color, m_state.opacity,
+    const PoolState state{
+       g_drawPool.getTransformMatrix(), color, m_state.opacity,
        m_state.compositionMode, m_state.blendEquation,
-       m_state.clipRect, texture, m_state.shaderProgram
+       m_state.clipRect, texture.get(), m_state.shaderProgram
     };
 
     size_t stateHash = 0, methodHash = 0;
@@ -60,38 +65,45 @@ void DrawPool::add(const Color& color, const TexturePtr& texture, const DrawMeth
 
     if (m_type != DrawPoolType::FOREGROUND && (m_alwaysGroupDrawings || drawBuffer && drawBuffer->m_agroup)) {
         if (auto it = m_objectsByhash.find(stateHash); it != m_objectsByhash.end()) {
-            const auto& buffer = it->second.buffer;
+            const auto& buffer = m_frame.buffers[it->second];
 
             if (!buffer->isTemporary() && buffer->isValid()) {
                 auto& hashList = buffer->m_hashs;
                 if (++buffer->m_i != hashList.size()) {
                     // checks if the vertex to be added is in the same position,
                     // otherwise the buffer will be invalidated to recreate the cache.
-                    if (hashList[buffer->m_i] != methodHash)
+                    if (hashList[buffer->m_i] != methodHash) {
                         buffer->invalidate();
-                    else return;
+                        ++m_stats.cacheInvalidations;
+                    } else {
+                        ++m_stats.cacheHits;
+                        return;
+                    }
                 }
                 hashList.push_back(methodHash);
             }
 
+            ++m_stats.merges;
+
             if (coordsBuffer)
                 buffer->getCoords()->append(coordsBuffer.get());
             else
-                addCoords(method, *buffer->m_coords.get(), DrawMode::TRIANGLES);
+                addCoords(method, *buffer->getCoords(), DrawMode::TRIANGLES);
 
             return;
         }
 
-        const DrawBufferPtr& buffer = drawBuffer ? drawBuffer : DrawBuffer::createTemporaryBuffer(DrawPool::DrawOrder::FIRST);
+        const DrawBufferPtr buffer = drawBuffer ? drawBuffer : acquireTemporaryBuffer();
         bool addCoord = buffer->isTemporary();
         if (!addCoord) { // is not temp buffer
             if (buffer->m_stateHash != stateHash || !buffer->isValid()) {
-                buffer->getCoords()->clear();
+                buffer->clearCoords();
                 buffer->m_stateHash = stateHash;
                 buffer->m_hashs.clear();
                 buffer->m_hashs.push_back(methodHash);
                 addCoord = true;
-            }
+                ++m_stats.cacheInvalidations;
+            } else ++m_stats.cacheHits;
             buffer->m_i = 0; // reset identifier to say it is valid.
         }
 
@@ -103,79 +115,155 @@ void DrawPool::add(const Color& color, const TexturePtr& texture, const DrawMeth
                 addCoords(method, *coords, DrawMode::TRIANGLES);
         }
 
-        m_objectsByhash.emplace(stateHash,
-              m_objects[m_currentFloor][m_currentOrder = static_cast<uint8_t>(buffer->m_order)]
-                       .emplace_back(state, buffer));
+        const uint32_t bufferIndex = addBuffer(buffer);
+        m_frame.buckets[m_currentFloor][m_currentOrder = static_cast<uint8_t>(buffer->m_order)].objects.push_back({
+            .state = internState(state, texture, stateHash),
+            .buffer = bufferIndex
+        });
+        m_objectsByhash.emplace(stateHash, bufferIndex);
 
+        ++m_stats.objects;
         return;
     }
 
     m_currentOrder = static_cast<uint8_t>(m_type == DrawPoolType::FOREGROUND ? DrawPool::DrawOrder::FIRST :
                                           drawBuffer ? drawBuffer->m_order : DrawPool::DrawOrder::THIRD);
 
-    auto& list = m_objects[m_currentFloor][m_currentOrder];
+    auto& bucket = m_frame.buckets[m_currentFloor][m_currentOrder];
 
-    if (!list.empty()) {
-        auto& prevObj = list.back();
+    if (!bucket.objects.empty()) {
+        auto& prevObj = bucket.objects.back();
+        const PoolState* prevState = prevObj.state != NO_INDEX ? &getState(prevObj) : nullptr;
 
-        const bool sameState = prevObj.state == state;
-        if (method.dest.has_value() && prevObj.methods.has_value()) {
+        const bool sameState = prevState && *prevState == state;
+        if (!method.originalDest.isNull() && prevObj.grouped) {
             // Look for identical or opaque textures that are greater than or
             // equal to the size of the previous texture, if so, remove it from the list so they don't get drawn.
-            auto& drawMethods = *prevObj.methods;
-            for (auto itm = drawMethods.begin(); itm != drawMethods.end(); ++itm) {
-                auto& prevMtd = *itm;
-                if (prevMtd.dest == method.dest &&
-                   ((sameState && prevMtd.rects->second == method.rects->second) || (state.texture->isOpaque() && prevObj.state->texture->canSuperimposed()))) {
-                    drawMethods.erase(itm);
+            // the methods of the last object are the last ones of the bucket.
+            const auto begin = bucket.methods.begin() + prevObj.methodsBegin;
+            for (auto itm = begin; itm != begin + prevObj.methodsCount; ++itm) {
+                const auto& prevMtd = *itm;
+                if (prevMtd.originalDest == method.originalDest &&
+                   ((sameState && prevMtd.src == method.src) || (state.texture->isOpaque() && prevState->texture->canSuperimposed()))) {
+                    bucket.methods.erase(itm);
+                    --prevObj.methodsCount;
                     break;
                 }
             }
         }
 
         if (sameState) {
-            if (!prevObj.buffer) {
-                prevObj.addMethod(method);
+            if (prevObj.buffer == NO_INDEX) {
+                bucket.methods.push_back(method);
+                ++prevObj.methodsCount;
+                prevObj.drawMode = DrawMode::TRIANGLES;
+                prevObj.grouped = true;
+                ++m_stats.merges;
                 return;
             }
 
-            if (prevObj.buffer->isTemporary()) {
+            const auto& prevBuffer = m_frame.buffers[prevObj.buffer];
+            if (prevBuffer->isTemporary()) {
                 if (coordsBuffer) {
-                    prevObj.buffer->getCoords()->append(coordsBuffer.get());
+                    prevBuffer->getCoords()->append(coordsBuffer.get());
                 } else {
-                    addCoords(method, *prevObj.buffer->getCoords(), DrawMode::TRIANGLES);
+                    addCoords(method, *prevBuffer->getCoords(), DrawMode::TRIANGLES);
                 }
             }
         }
     }
 
+    const uint32_t stateIndex = internState(state, texture, stateHash);
     if (coordsBuffer) {
-        const DrawBufferPtr& buffer = DrawBuffer::createTemporaryBuffer(DrawPool::DrawOrder::FIRST);
+        const auto& buffer = acquireTemporaryBuffer();
         buffer->getCoords()->append(coordsBuffer.get());
-        list.emplace_back(state, buffer);
-    } else
-        list.emplace_back(drawMode, state, method);
+        bucket.objects.push_back({ .state = stateIndex, .buffer = addBuffer(buffer) });
+    } else {
+        bucket.objects.push_back({
+            .drawMode = drawMode,
+            .state = stateIndex,
+            .methodsBegin = static_cast<uint32_t>(bucket.methods.size()),
+            .methodsCount = 1
+        });
+        bucket.methods.push_back(method);
+    }
+
+    ++m_stats.objects;
+}
+
+void DrawPool::addAction(std::function<void()> action)
+{
+    m_frame.actions.emplace_back(std::move(action));
+    m_frame.buckets[0][static_cast<uint8_t>(DrawOrder::FIRST)].objects.push_back({
+        .action = static_cast<uint32_t>(m_frame.actions.size() - 1)
+    });
+}
+
+uint32_t DrawPool::internState(const PoolState& state, const TexturePtr& texture, const size_t stateHash)
+{
+    auto& cached = m_stateCache[stateHash % STATE_CACHE_SIZE];
+    if (cached != NO_INDEX) {
+        const auto& other = m_frame.states[cached];
+        if (other == state && other.action == state.action)
+            return cached;
+    }
+
+    m_frame.states.push_back(state);
+    if (texture)
+        m_frame.textures.push_back(texture);
+
+    cached = m_frame.states.size() - 1;
+    return cached;
+}
+
+uint32_t DrawPool::addBuffer(const DrawBufferPtr& buffer)
+{
+    m_frame.buffers.push_back(buffer);
+    return m_frame.buffers.size() - 1;
+}
+
+DrawBufferPtr DrawPool::acquireTemporaryBuffer()
+{
+    // temporary buffers belong to the frame, they are reused once it was drawn
+    auto& buffers = m_frame.temporaryBuffers;
+    if (m_frame.usedTemporaryBuffers == buffers.size())
+        buffers.emplace_back(std::make_shared<DrawBuffer>(DrawPool::DrawOrder::FIRST));
+
+    const auto& buffer = buffers[m_frame.usedTemporaryBuffers++];
+    buffer->m_i = -2; // identifier to say it is a temporary buffer.
+    buffer->clearCoords();
+    return buffer;
+}
+
+DrawPool::PoolState& DrawPool::getLastState()
+{
+    auto& obj = getLastDrawObject();
+    assert(obj.state != NO_INDEX);
+
+    const PoolState state = getState(obj);
+    m_frame.states.push_back(state);
+    obj.state = m_frame.states.size() - 1;
+    return m_frame.states.back();
 }
 
 void DrawPool::addCoords(const DrawMethod& method, CoordsBuffer& buffer, DrawMode drawMode)
 {
     if (method.type == DrawMethodType::BOUNDING_RECT) {
-        buffer.addBoudingRect(method.rects->first, method.intValue);
+        buffer.addBoudingRect(method.dest, method.intValue);
     } else if (method.type == DrawMethodType::RECT) {
         if (drawMode == DrawMode::TRIANGLES)
-            buffer.addRect(method.rects->first, method.rects->second);
+            buffer.addRect(method.dest, method.src);
         else
-            buffer.addQuad(method.rects->first, method.rects->second);
+            buffer.addQuad(method.dest, method.src);
     } else if (method.type == DrawMethodType::TRIANGLE) {
-        const auto& points = *method.points;
-        buffer.addTriangle(std::get<0>(points), std::get<1>(points), std::get<2>(points));
+        buffer.addTriangle(method.a, method.b, method.c);
     } else if (method.type == DrawMethodType::UPSIDEDOWN_RECT) {
         if (drawMode == DrawMode::TRIANGLES)
-            buffer.addUpsideDownRect(method.rects->first, method.rects->second);
+            buffer.addUpsideDownRect(method.dest, method.src);
         else
-            buffer.addUpsideDownQuad(method.rects->first, method.rects->second);
+            buffer.addUpsideDownQuad(method.dest, method.src);
     } else if (method.type == DrawMethodType::REPEATED_RECT) {
-        buffer.addRepeatedRects(method.rects->first, method.rects->second);
+        buffer.addRepeatedRects(method.dest, method.src);
     }
 }
 
@@ -213,21 +301,12 @@ void DrawPool::updateHash(const PoolState& state, const DrawMethod& method,
     }
 
     { // Method Hash
-        if (method.rects.has_value()) {
-            if (method.rects->first.isValid()) stdext::hash_union(methodhash, method.rects->first.hash());
-            if (method.rects->second.isValid()) stdext::hash_union(methodhash, method.rects->second.hash());
-        }
-
-        if (method.points.has_value()) {
-            const auto& points = *method.points;
-            const auto& a = std::get<0>(points),
-                & b = std::get<1>(points),
-                & c = std::get<2>(points);
+        if (method.dest.isValid()) stdext::hash_union(methodhash, method.dest.hash());
+        if (method.src.isValid()) stdext::hash_union(methodhash, method.src.hash());
 
-            if (!a.isNull()) stdext::hash_union(methodhash, a.hash());
-            if (!b.isNull()) stdext::hash_union(methodhash, b.hash());
-            if (!c.isNull()) stdext::hash_union(methodhash, c.hash());
-        }
+        if (!method.a.isNull()) stdext::hash_union(methodhash, method.a.hash());
+        if (!method.b.isNull()) stdext::hash_union(methodhash, method.b.hash());
+        if (!method.c.isNull()) stdext::hash_union(methodhash, method.c.hash());
 
         if (method.intValue) stdext::hash_combine(methodhash, method.intValue);
 
@@ -242,7 +321,7 @@ void DrawPool::setCompositionMode(const CompositionMode mode, bool onLastDrawing
         return;
     }
 
-    getLastDrawObject().state->compositionMode = mode;
+    getLastState().compositionMode = mode;
     stdext::hash_combine(m_status.second, mode);
 }
 
@@ -253,7 +332,7 @@ void DrawPool::setBlendEquation(BlendEquation equation, bool onLastDrawing)
         return;
     }
 
-    getLastDrawObject().state->blendEquation = equation;
+    getLastState().blendEquation = equation;
     stdext::hash_combine(m_status.second, equation);
 }
 
@@ -264,7 +343,7 @@ void DrawPool::setClipRect(const Rect& clipRect, bool onLastDrawing)
         return;
     }
 
-    getLastDrawObject().state->clipRect = clipRect;
+    getLastState().clipRect = clipRect;
     stdext::hash_union(m_status.second, clipRect.hash());
 }
 
@@ -275,7 +354,7 @@ void DrawPool::setOpacity(const float opacity, bool onLastDrawing)
         return;
     }
 
-    getLastDrawObject().state->opacity = opacity;
+    getLastState().opacity = opacity;
     stdext::hash_combine(m_status.second, opacity);
 }
 
@@ -293,9 +372,13 @@ void DrawPool::setShaderProgram(const PainterShaderProgramPtr& shaderProgram, bo
         m_refreshTimeMS = REFRESH_TIME;
     }
 
-    auto& o = getLastDrawObject();
-    o.state->shaderProgram = shader;
-    o.state->action = action;
+    auto& state = getLastState();
+    state.shaderProgram = shader;
+    if (action) {
+        m_frame.actions.push_back(action);
+        state.action = m_frame.actions.size() - 1;
+    } else
+        state.action = NO_INDEX;
 }
 
 void DrawPool::resetState()
@@ -324,13 +407,194 @@ bool DrawPool::canRepaint(const bool autoUpdateStatus)
     return canRepaint;
 }
 
-void DrawPool::clear()
+void DrawPool::reorderFrame()
 {
-    // clean only processed floors
+    for (int_fast8_t z = -1; ++z <= m_drawingFloor;) {
+        for (auto& bucket : m_drawingFrame.buckets[z])
+            reorderBucket(bucket);
+    }
+}
+
+void DrawPool::reorderBucket(DrawBucket& bucket)
+{
+    auto& objects = bucket.objects;
+    if (objects.size() < 3)
+        return;
+
+    auto& r = m_reorder;
+    if (r.base > UINT32_MAX - 2 * objects.size()) {
+        r.grid.fill(0);
+        r.base = 0;
+    }
+
+    r.groups.clear();
+    r.next.assign(objects.size(), NO_INDEX);
+    r.lastGroupOfState.clear();
+
+    // a drawing joins the last group of its state unless something drawn after that group overlaps it;
+    // drawings that can't be moved are fences nothing is moved across
+    uint32_t fence = 0, merges = 0;
+    for (uint32_t i = 0; i < objects.size(); ++i) {
+        Rect bounds;
+        if (!getReorderBounds(bucket, objects[i], bounds)) {
+            r.groups.push_back({ i, i, 1 });
+            fence = r.groups.size();
+            continue;
+        }
+
+        const uint32_t state = objects[i].state;
+        if (const auto it = r.lastGroupOfState.find(state); it != r.lastGroupOfState.end() && it->second >= fence) {
+            const uint32_t group = it->second;
+            if (!reorderOverlaps(bounds, group)) {
+                auto& g = r.groups[group];
+                r.next[g.last] = i;
+                g.last = i;
+                ++g.count;
+                reorderStamp(bounds, group);
+                ++merges;
+                continue;
+            }
+        }
+
+        const uint32_t group = r.groups.size();
+        r.groups.push_back({ i, i, 1 });
+        r.lastGroupOfState[state] = group;
+        reorderStamp(bounds, group);
+    }
+
+    r.base += r.groups.size() + 1;
+
+    if (merges == 0)
+        return;
+
+    r.objects.clear();
+    r.methods.clear();
+    for (const auto& group : r.groups) {
+        auto obj = objects[group.first];
+        if (group.count > 1) {
+            obj.drawMode = DrawMode::TRIANGLES;
+            obj.grouped = true;
+        }
+
+        obj.methodsBegin = r.methods.size();
+        obj.methodsCount = 0;
+        for (uint32_t i = group.first; i != NO_INDEX; i = r.next[i]) {
+            const auto& member = objects[i];
+            const auto begin = bucket.methods.begin() + member.methodsBegin;
+            r.methods.insert(r.methods.end(), begin, begin + member.methodsCount);
+            obj.methodsCount += member.methodsCount;
+        }
+
+        r.objects.push_back(obj);
+    }
+
+    // the scratch takes the old lists, so both keep their capacity
+    objects.swap(r.objects);
+    bucket.methods.swap(r.methods);
+
+    m_drawingStats.reorderMerges += merges;
+}
+
+bool DrawPool::getReorderBounds(const DrawBucket& bucket, const DrawObject& obj, Rect& bounds) const
+{
+    // actions, buffers and transformed drawings have no known screen rect
+    if (obj.state == NO_INDEX || obj.buffer != NO_INDEX || obj.methodsCount == 0)
+        return false;
+
+    const auto& state = m_drawingFrame.states[obj.state];
+    if (state.action != NO_INDEX || !state.transformMatrix.isIdentity())
+        return false;
+
+    const auto begin = bucket.methods.begin() + obj.methodsBegin;
+    for (auto it = begin; it != begin + obj.methodsCount; ++it) {
+        const auto& method = *it;
+        Rect rect;
+        if (method.type == DrawMethodType::TRIANGLE) {
+            rect = Rect(Point(std::min<int>({ method.a.x, method.b.x, method.c.x }), std::min<int>({ method.a.y, method.b.y, method.c.y })),
+                        Point(std::max<int>({ method.a.x, method.b.x, method.c.x }), std::max<int>({ method.a.y, method.b.y, method.c.y })));
+        } else rect = method.dest;
+
+        bounds = it == begin ? rect : bounds.united(rect);
+    }
+
+    return bounds.isValid();
+}
+
+bool DrawPool::reorderOverlaps(const Rect& bounds, const uint32_t group) const
+{
+    constexpr auto shift = Reorder::GRID_CELL_SHIFT;
+    constexpr int size = Reorder::GRID_SIZE, mask = Reorder::GRID_SIZE - 1;
+
+    const int x1 = bounds.left() >> shift, y1 = bounds.top() >> shift;
+    const int w = std::min<int>((bounds.right() >> shift) - x1 + 1, size),
+        h = std::min<int>((bounds.bottom() >> shift) - y1 + 1, size);
+
+    const uint32_t stamp = m_reorder.base + group + 1;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            if (m_reorder.grid[((y1 + y) & mask) * size + ((x1 + x) & mask)] > stamp)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+void DrawPool::reorderStamp(const Rect& bounds, const uint32_t group)
+{
+    constexpr auto shift = Reorder::GRID_CELL_SHIFT;
+    constexpr int size = Reorder::GRID_SIZE, mask = Reorder::GRID_SIZE - 1;
+
+    const int x1 = bounds.left() >> shift, y1 = bounds.top() >> shift;
+    const int w = std::min<int>((bounds.right() >> shift) - x1 + 1, size),
+        h = std::min<int>((bounds.bottom() >> shift) - y1 + 1, size);
+
+    const uint32_t stamp = m_reorder.base + group + 1;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            auto& cell = m_reorder.grid[((y1 + y) & mask) * size + ((x1 + x) & mask)];
+            cell = std::max<uint32_t>(cell, stamp);
+        }
+    }
+}
+
+size_t DrawPool::getObjectsCount() const
+{
+    size_t count = 0;
     for (int_fast8_t z = -1; ++z <= m_currentFloor;) {
-        for (auto& order : m_objects[z])
-            order.clear();
+        for (const auto& bucket : m_frame.buckets[z])
+            count += bucket.objects.size();
     }
+    return count;
+}
+
+void DrawPool::clear()
+{
+    m_frame.clear(m_currentFloor);
+    resetFrame();
+}
+
+void DrawPool::resetFrame()
+{
     m_objectsByhash.clear();
+    m_stateCache.fill(NO_INDEX);
     m_currentFloor = 0;
 }
+
+void DrawPool::Frame::clear(const uint8_t lastFloor)
+{
+    // clean only processed floors
+    for (int_fast8_t z = -1; ++z <= lastFloor;) {
+        for (auto& bucket : buckets[z]) {
+            bucket.objects.clear();
+            bucket.methods.clear();
+        }
+    }
+
+    states.clear();
+    textures.clear();
+    actions.clear();
+    buffers.clear();
+    coords.clear();
+    usedTemporaryBuffers = 0;
+}
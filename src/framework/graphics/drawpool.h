@@ -60,10 +60,39 @@ public:
     bool isEnabled() const { return m_enabled; }
     DrawPoolType getType() const { return m_type; }
 
+    // before drawing, moves drawings of a floor and DrawOrder next to earlier ones with the same
+    // state when nothing drawn in between overlaps them, so they are submitted as one draw call
+    void setReorderDrawings(const bool v) { m_reorderDrawings = v; }
+    bool isReorderingDrawings() const { return m_reorderDrawings; }
+
     bool canRepaint() { return canRepaint(false); }
     void repaint() { m_status.first = 1; }
 
+    size_t getObjectsCount() const;
+
+    // counters of the last drawn frame, see DrawPoolManager::draw
+    struct Stats
+    {
+        uint32_t objects{ 0 },
+            merges{ 0 },
+            cacheHits{ 0 },
+            cacheInvalidations{ 0 },
+            stateChanges{ 0 },
+            drawCalls{ 0 },
+            verticesUploaded{ 0 }, // vertices written for the gpu, cached buffers only when (re)built
+            reorderMerges{ 0 }, // draw calls saved by setReorderDrawings
+            instances{ 0 }, // rects drawn by instancing, see DrawPoolManager::setInstancing
+            bytesStreamed{ 0 }; // see Painter::setStreamingVertices
+    };
+
+    const Stats& getStats() const { return m_lastStats; }
+
 protected:
+    static constexpr uint8_t ARR_MAX_Z = MAX_Z + 1;
+    static constexpr uint32_t NO_INDEX = UINT32_MAX;
+
+    // state of the recorded drawings, interned per frame and referenced by index;
+    // the texture and the action are kept alive by the frame
     struct PoolState
     {
         Matrix3 transformMatrix;
@@ -72,9 +101,9 @@ protected:
         CompositionMode compositionMode{ CompositionMode::NORMAL };
         BlendEquation blendEquation{ BlendEquation::ADD };
         Rect clipRect;
-        TexturePtr texture;
+        Texture* texture{ nullptr };
         PainterShaderProgram* shaderProgram{ nullptr };
-        std::function<void()> action{ nullptr };
+        uint32_t action{ NO_INDEX }; // in Frame::actions
 
         bool operator==(const PoolState& s2) const
         {
@@ -102,38 +131,51 @@ protected:
     struct DrawMethod
     {
         DrawMethodType type;
-        std::optional<std::pair<Rect, Rect>> rects;
-        std::optional<std::tuple<Point, Point, Point>> points;
-        std::optional<Point> dest;
+        Rect dest, src;
+        Point a, b, c; // TRIANGLE
+        Point originalDest; // null when the drawing does not come from a tile
         uint16_t intValue{ 0 };
     };
 
+    // a record of the command stream, its methods are in the bucket and everything else in the frame
     struct DrawObject
     {
-        DrawObject(std::function<void()> action) : action(std::move(action)) {}
-        DrawObject(const PoolState& state, const DrawBufferPtr& buffer) : state(state), buffer(buffer) {}
-        DrawObject(const DrawMode drawMode, const PoolState& state, const DrawMethod& method) :
-            drawMode(drawMode), state(state), method(method)
-        {}
+        DrawMode drawMode{ DrawMode::TRIANGLES };
+        bool grouped{ false }; // more than one method was merged into it
+        uint32_t state{ NO_INDEX },
+            buffer{ NO_INDEX },
+            action{ NO_INDEX },
+            methodsBegin{ 0 },
+            methodsCount{ 0 };
+    };
 
-        void addMethod(const DrawMethod& method)
-        {
-            if (!methods.has_value()) {
-                methods = std::vector<DrawMethod>();
-                methods->emplace_back(*this->method);
-            }
-            drawMode = DrawMode::TRIANGLES;
-            methods->emplace_back(method);
-        }
+    // recording must not allocate or touch refcounts per drawing
+    static_assert(std::is_trivially_copyable_v<PoolState> && std::is_trivially_copyable_v<DrawMethod> && std::is_trivially_copyable_v<DrawObject>);
 
-        DrawMode drawMode{ DrawMode::TRIANGLES };
-        DrawBufferPtr buffer;
-        std::optional<PoolState> state;
-        std::optional<DrawMethod> method;
-        std::optional<std::vector<DrawMethod>> methods;
-        std::function<void()> action{ nullptr };
+    // the drawings of a floor and DrawOrder
+    struct DrawBucket
+    {
+        std::vector<DrawObject> objects;
+        std::vector<DrawMethod> methods;
     };
 
+    // everything a frame references; the vectors keep their capacity from frame to frame,
+    // so once warm, recording only bumps into memory that is already there
+    struct Frame
+    {
+        DrawBucket buckets[ARR_MAX_Z][static_cast<uint8_t>(DrawOrder::LAST)];
+        std::vector<PoolState> states;
+        std::vector<TexturePtr> textures; // pins the textures of the states
+        std::vector<std::function<void()>> actions;
+        std::vector<DrawBufferPtr> buffers;
+        std::vector<std::shared_ptr<const CoordsBuffer>> coords; // coords of the buffers pinned for drawing, immutable, see DrawPoolManager::swap
+        std::vector<DrawBufferPtr> temporaryBuffers;
+        uint32_t usedTemporaryBuffers{ 0 };
+
+        void clear(uint8_t lastFloor);
+    };
+
+    // what the next drawings are recorded with
     struct DrawObjectState
     {
         CompositionMode compositionMode{ CompositionMode::NORMAL };
@@ -145,24 +187,32 @@ protected:
     };
 
 private:
-    static constexpr uint8_t ARR_MAX_Z = MAX_Z + 1;
+    static constexpr uint16_t STATE_CACHE_SIZE = 256;
     static DrawPool* create(const DrawPoolType type);
 
     DrawObject& getLastDrawObject()
     {
-        auto& list = m_objects[m_currentFloor][m_currentOrder];
-        return list[list.size() - 1];
+        return m_frame.buckets[m_currentFloor][m_currentOrder].objects.back();
     }
 
+    // the state of the last drawing, copied first since states are shared
+    PoolState& getLastState();
+    const PoolState& getState(const DrawObject& obj) const { return m_frame.states[obj.state]; }
+
     void add(const Color& color, const TexturePtr& texture, const DrawPool::DrawMethod& method,
              DrawMode drawMode = DrawMode::TRIANGLES, const DrawBufferPtr& drawBuffer = nullptr,
              const CoordsBufferPtr& coordsBuffer = nullptr);
+    void addAction(std::function<void()> action);
+
+    uint32_t internState(const PoolState& state, const TexturePtr& texture, size_t stateHash);
+    uint32_t addBuffer(const DrawBufferPtr& buffer);
+    DrawBufferPtr acquireTemporaryBuffer();
 
-    void addCoords(const DrawPool::DrawMethod& method, CoordsBuffer& buffer, DrawMode drawMode);
+    static void addCoords(const DrawPool::DrawMethod& method, CoordsBuffer& buffer, DrawMode drawMode);
     void updateHash(const PoolState& state, const DrawPool::DrawMethod& method, size_t& stateHash, size_t& methodHash);
 
-    float getOpacity(bool lastDrawing = false) { return !lastDrawing ? m_state.opacity : getLastDrawObject().state->opacity; }
-    Rect getClipRect(bool lastDrawing = false) { return !lastDrawing ? m_state.clipRect : getLastDrawObject().state->clipRect; }
+    float getOpacity(bool lastDrawing = false) { return !lastDrawing ? m_state.opacity : getState(getLastDrawObject()).opacity; }
+    Rect getClipRect(bool lastDrawing = false) { return !lastDrawing ? m_state.clipRect : getState(getLastDrawObject()).clipRect; }
 
     void setCompositionMode(CompositionMode mode, bool onLastDrawing = false);
     void setBlendEquation(BlendEquation equation, bool onLastDrawing = false);
@@ -178,6 +228,8 @@ private:
     void resetBlendEquation() { m_state.blendEquation = BlendEquation::ADD; }
 
     void clear();
+    // starts recording a new frame, the previous one was handed to m_drawingFrame
+    void resetFrame();
     void flush()
     {
         m_objectsByhash.clear();
@@ -190,15 +242,24 @@ private:
 
     bool canRepaint(bool autoUpdateStatus);
 
+    // see setReorderDrawings, runs on m_drawingFrame from DrawPoolManager::swap
+    void reorderFrame();
+    void reorderBucket(DrawBucket& bucket);
+    bool getReorderBounds(const DrawBucket& bucket, const DrawObject& obj, Rect& bounds) const;
+    bool reorderOverlaps(const Rect& bounds, uint32_t group) const;
+    void reorderStamp(const Rect& bounds, uint32_t group);
+
     bool m_enabled{ true },
         m_alwaysGroupDrawings{ false },
+        m_reorderDrawings{ false },
         m_autoUpdate{ false };
 
     uint8_t m_currentOrder{ 0 }, m_currentFloor{ 0 };
 
     uint16_t m_refreshTimeMS{ 0 };
 
-    PoolState m_state;
+    DrawObjectState m_state;
+    Stats m_stats, m_lastStats;
 
     DrawPoolType m_type{ DrawPoolType::UNKNOW };
 
@@ -206,8 +267,37 @@ private:
 
     std::pair<size_t, size_t> m_status{ 1, 0 };
 
-    std::vector<DrawObject> m_objects[ARR_MAX_Z][static_cast<uint8_t>(DrawOrder::LAST)];
-    stdext::map<size_t, DrawObject> m_objectsByhash;
+    Frame m_frame;
+    stdext::map<size_t, uint32_t> m_objectsByhash; // state hash -> grouping buffer in the frame buffers
+    std::array<uint32_t, STATE_CACHE_SIZE> m_stateCache; // state hash -> interned state, collisions only duplicate states
+
+    // the frame handed off by DrawPoolManager::swap, read only by DrawPoolManager::drawFrame
+    Frame m_drawingFrame;
+
+    // scratch of reorderBucket, kept to not allocate every frame
+    struct ReorderGroup
+    {
+        uint32_t first, last, count;
+    };
+
+    struct Reorder
+    {
+        static constexpr uint8_t GRID_CELL_SHIFT = 5; // 32x32 px
+        static constexpr uint8_t GRID_SIZE = 64; // cells per axis, coordinates wrap around
+
+        std::vector<ReorderGroup> groups;
+        std::vector<uint32_t> next; // next object of the same group
+        std::vector<DrawObject> objects;
+        std::vector<DrawMethod> methods;
+        stdext::map<uint32_t, uint32_t> lastGroupOfState;
+        // last group drawn on each cell, offset by base so the grid is never cleared
+        std::array<uint32_t, GRID_SIZE * GRID_SIZE> grid{};
+        uint32_t base{ 0 };
+    } m_reorder;
+    uint8_t m_drawingFloor{ 0 };
+    bool m_drawingEnabled{ false },
+        m_drawingRepaint{ false };
+    Stats m_drawingStats;
 
     friend DrawPoolManager;
 };
@@ -215,7 +305,10 @@ private:
 class DrawPoolFramed : public DrawPool
 {
 public:
-    void onBeforeDraw(std::function<void()> f) { m_beforeDraw = std::move(f); }
+    // called on the main thread by DrawPoolManager::swap, returns what is done right before the
+    // framebuffer is drawn, which may run on the render thread and so must only hold copies
+    void onBeforeDraw(std::function<std::function<void()>()> f) { m_beforeDraw = std::move(f); }
+    // run right after the framebuffer is drawn, possibly on the render thread, gl state only
     void onAfterDraw(std::function<void()> f) { m_afterDraw = std::move(f); }
     void setSmooth(bool enabled) { m_framebuffer->setSmooth(enabled); }
     void resize(const Size& size) { m_framebuffer->resize(size); }
@@ -233,7 +326,9 @@ private:
 
     FrameBufferPtr m_framebuffer;
 
-    std::function<void()> m_beforeDraw, m_afterDraw;
+    std::function<std::function<void()>()> m_beforeDraw;
+    std::function<void()> m_afterDraw,
+        m_drawingBeforeDraw; // returned by m_beforeDraw for the frame handed off
 };
 
 extern DrawPoolManager g_drawPool;
@@ -246,13 +341,6 @@ public:
     void setOrder(DrawPool::DrawOrder order) { m_order = order; }
 
 private:
-    static DrawBufferPtr createTemporaryBuffer(DrawPool::DrawOrder order)
-    {
-        auto buffer = std::make_shared<DrawBuffer>(order);
-        buffer->m_i = -2; // identifier to say it is a temporary buffer.
-        return buffer;
-    }
-
     void invalidate() { m_i = -1; }
 
     inline bool isValid() { return m_i != -1; }
@@ -264,7 +352,28 @@ private:
         return isValid();
     }
 
-    inline CoordsBuffer* getCoords() { return (m_coords ? m_coords : m_coords = std::make_shared<CoordsBuffer>()).get(); }
+    inline CoordsBuffer* getCoords()
+    {
+        if (!m_coords)
+            m_coords = std::make_shared<CoordsBuffer>();
+        else if (m_coords.use_count() > 1) {
+            // the frame being drawn still holds these coords, the recording continues on a copy
+            const auto coords = std::make_shared<CoordsBuffer>();
+            coords->append(m_coords.get());
+            m_coords = coords;
+        }
+
+        return m_coords.get();
+    }
+
+    // like getCoords()->clear(), without copying pinned coords first
+    inline void clearCoords()
+    {
+        if (m_coords && m_coords.use_count() == 1)
+            m_coords->clear();
+        else
+            m_coords = std::make_shared<CoordsBuffer>();
+    }
 
     int m_i{ -1 };
     bool m_agroup{ true };
@@ -23,6 +23,9 @@
 #include "drawpoolmanager.h"
 #include "declarations.h"
 #include "painter.h"
+#include "fontmanager.h"
+#include "textureatlas.h"
+#include "texturemanager.h"
 #include <utility>
 
 DrawPoolManager g_drawPool;
@@ -45,35 +48,109 @@ void DrawPoolManager::terminate()
 }
 
 void DrawPoolManager::draw()
+{
+    swap();
+    drawFrame();
+    release();
+}
+
+void DrawPoolManager::swap()
+{
+    release();
+    g_textures.resetUploads();
+    g_atlas.nextFrame();
+    g_painter->getStreamBuffer().nextFrame();
+
+    for (const auto& pool : m_pools) {
+        pool->m_drawingEnabled = pool->isEnabled();
+        pool->m_drawingRepaint = pool->m_drawingEnabled && pool->hasFrameBuffer() && pool->canRepaint(true);
+
+        std::swap(pool->m_frame, pool->m_drawingFrame);
+        pool->m_drawingFloor = pool->m_currentFloor;
+        pool->m_drawingStats = pool->m_stats;
+        pool->m_stats = {};
+
+        // the frame swapped in was emptied by release()
+        pool->resetFrame();
+
+        if (pool->hasFrameBuffer()) {
+            auto* pf = pool->toPoolFramed();
+            pf->m_framebuffer->commit();
+            if (pool->m_drawingEnabled && pf->m_beforeDraw)
+                pf->m_drawingBeforeDraw = pf->m_beforeDraw();
+        }
+
+        if (!pool->m_drawingEnabled || pool->hasFrameBuffer() && !pool->m_drawingRepaint)
+            continue;
+
+        // pending texture uploads are done here, while the context is still on this thread, and the
+        // coords of the buffers are cached and pinned. From here on they are immutable, drawFrame
+        // only reads them and recording the next frame copies them instead of writing to them.
+        auto& frame = pool->m_drawingFrame;
+        frame.coords.resize(frame.buffers.size());
+        for (size_t i = 0; i < frame.buffers.size(); ++i) {
+            auto& coords = frame.buffers[i]->m_coords;
+            if (!coords)
+                coords = std::make_shared<CoordsBuffer>();
+
+            // a buffer drawn again as it was is not written, only the ones (re)built here count
+            if (coords->cache())
+                pool->m_drawingStats.verticesUploaded += coords->getVertexCount();
+            frame.coords[i] = coords;
+        }
+
+        bool uploadPending = false;
+        for (const auto& state : frame.states) {
+            if (!state.texture)
+                continue;
+
+            state.texture->create();
+            uploadPending |= state.texture->isUploadPending();
+        }
+
+        // the drawings of a deferred texture are skipped this frame and the next one hashes the same,
+        // a framed pool would keep the hole until something else changed
+        if (uploadPending)
+            pool->repaint();
+
+        if (pool->m_reorderDrawings)
+            pool->reorderFrame();
+    }
+
+    m_hasFrame = true;
+}
+
+void DrawPoolManager::drawFrame()
 {
     if (m_size != g_painter->getResolution()) {
         m_size = g_painter->getResolution();
-        m_transformMatrix = g_painter->getTransformMatrix(m_size);
+        m_projectionMatrix = g_painter->getTransformMatrix(m_size);
     }
 
+    prepareFrame();
+
     // Pre Draw
     for (const auto& pool : m_pools) {
-        if (!pool->isEnabled() || !pool->hasFrameBuffer()) continue;
+        if (!pool->m_drawingRepaint) continue;
 
         const auto& pf = pool->toPoolFramed();
 
-        if (pool->canRepaint(true)) {
-            pf->m_framebuffer->bind();
-            for (int_fast8_t z = -1; ++z <= pool->m_currentFloor;) {
-                for (auto& order : pool->m_objects[z])
-                    for (auto& obj : order)
-                        drawObject(obj);
-            }
-
-            pf->m_framebuffer->release();
+        pf->m_framebuffer->bind();
+        m_lastState = nullptr;
+        for (int_fast8_t z = -1; ++z <= pool->m_drawingFloor;) {
+            for (const auto& bucket : pool->m_drawingFrame.buckets[z])
+                for (const auto& obj : bucket.objects)
+                    drawObject(pool->m_drawingFrame, obj, pool->m_drawingStats);
         }
+
+        pf->m_framebuffer->release();
     }
 
-    g_painter->setResolution(m_size, m_transformMatrix);
+    g_painter->setResolution(m_size, m_projectionMatrix);
 
     // Draw
     for (const auto& pool : m_pools) {
-        if (!pool->isEnabled()) continue;
+        if (!pool->m_drawingEnabled) continue;
 
         if (pool->hasFrameBuffer()) {
             // Reset before events as there may be paint controls such as shaders.
@@ -81,57 +158,294 @@ void DrawPoolManager::draw()
 
             const auto* const pf = pool->toPoolFramed();
             {
-                if (pf->m_beforeDraw) pf->m_beforeDraw();
+                if (pf->m_drawingBeforeDraw) pf->m_drawingBeforeDraw();
                 pf->m_framebuffer->draw();
                 if (pf->m_afterDraw) pf->m_afterDraw();
             }
-        } else for (auto& obj : pool->m_objects[0][static_cast<int>(DrawPool::DrawOrder::FIRST)]) {
-            drawObject(obj);
+        } else {
+            m_lastState = nullptr;
+            const auto& bucket = pool->m_drawingFrame.buckets[0][static_cast<int>(DrawPool::DrawOrder::FIRST)];
+            for (const auto& obj : bucket.objects)
+                drawObject(pool->m_drawingFrame, obj, pool->m_drawingStats);
         }
-
-        pool->clear();
     }
+
+    assert(m_nextBatch == m_batches.size());
+    g_painter->getStreamBuffer().endFrame();
+
+    m_lastState = nullptr;
 }
 
-void DrawPoolManager::drawObject(const DrawPool::DrawObject& obj)
+void DrawPoolManager::prepareFrame()
 {
-    if (obj.action) {
-        obj.action();
+    m_frameGeometry.clear();
+    m_batches.clear();
+    m_nextBatch = 0;
+
+    g_painter->getStreamBuffer().beginFrame();
+
+    // the objects are visited in the order drawFrame draws them, each one takes the next batch
+    std::array<size_t, static_cast<uint8_t>(DrawPoolType::UNKNOW) + 1> poolGeometry{};
+    for (int_fast8_t i = -1; ++i <= static_cast<uint8_t>(DrawPoolType::UNKNOW);) {
+        const auto* const pool = m_pools[i];
+        if (!pool->m_drawingRepaint) continue;
+
+        const size_t begin = m_frameGeometry.size();
+        for (int_fast8_t z = -1; ++z <= pool->m_drawingFloor;) {
+            for (const auto& bucket : pool->m_drawingFrame.buckets[z])
+                for (const auto& obj : bucket.objects)
+                    prepareObject(pool->m_drawingFrame, bucket, obj);
+        }
+        poolGeometry[i] = m_frameGeometry.size() - begin;
+    }
+
+    for (int_fast8_t i = -1; ++i <= static_cast<uint8_t>(DrawPoolType::UNKNOW);) {
+        const auto* const pool = m_pools[i];
+        if (!pool->m_drawingEnabled || pool->hasFrameBuffer()) continue;
+
+        const size_t begin = m_frameGeometry.size();
+        const auto& bucket = pool->m_drawingFrame.buckets[0][static_cast<int>(DrawPool::DrawOrder::FIRST)];
+        for (const auto& obj : bucket.objects)
+            prepareObject(pool->m_drawingFrame, bucket, obj);
+        poolGeometry[i] = m_frameGeometry.size() - begin;
+    }
+
+    if (m_frameGeometry.empty())
         return;
+
+    // a single upload for the whole frame, the draws only point into it
+    const auto geometry = g_painter->streamVertices(m_frameGeometry.data(), m_frameGeometry.size() * sizeof(float));
+    const auto place = [&geometry](const int offset) -> Painter::VertexRange {
+        // geometry.data is an offset into the buffer when it has one
+        return { geometry.buffer, reinterpret_cast<const float*>(reinterpret_cast<intptr_t>(geometry.data) + offset * sizeof(float)) };
+    };
+
+    for (auto& batch : m_batches) {
+        if (batch.vertexOffset != -1)
+            batch.vertices = place(batch.vertexOffset);
+        if (batch.texCoordOffset != -1)
+            batch.texCoords = place(batch.texCoordOffset);
+    }
+
+    if (geometry.buffer) {
+        for (int_fast8_t i = -1; ++i <= static_cast<uint8_t>(DrawPoolType::UNKNOW);)
+            m_pools[i]->m_drawingStats.bytesStreamed += poolGeometry[i] * sizeof(float);
     }
+}
+
+void DrawPoolManager::prepareObject(const DrawPool::Frame& frame, const DrawPool::DrawBucket& bucket, const DrawPool::DrawObject& obj)
+{
+    // actions draw by themselves
+    if (obj.state == DrawPool::NO_INDEX)
+        return;
 
-    const bool useGlobalCoord = !obj.buffer;
-    auto& buffer = useGlobalCoord ? m_coordsBuffer : *obj.buffer->m_coords;
+    auto& batch = m_batches.emplace_back();
+    const auto& state = frame.states[obj.state];
+    const bool useGlobalCoord = obj.buffer == DrawPool::NO_INDEX;
+
+    const auto begin = bucket.methods.begin() + obj.methodsBegin;
+    if (useGlobalCoord && canDrawInstanced(bucket, obj, state)) {
+        batch.instanced = true;
+        batch.count = obj.methodsCount;
+        batch.vertexOffset = m_frameGeometry.size();
+
+        for (auto it = begin; it != begin + obj.methodsCount; ++it) {
+            const auto& dest = it->dest;
+            const auto& src = it->src;
+            const Painter::RectInstance instance{
+                { static_cast<float>(dest.left()), static_cast<float>(dest.top()), static_cast<float>(dest.width()), static_cast<float>(dest.height()) },
+                { static_cast<float>(src.left()), static_cast<float>(src.top()), static_cast<float>(src.width()), static_cast<float>(src.height()) }
+            };
+            addGeometry(reinterpret_cast<const float*>(&instance), sizeof(instance) / sizeof(float));
+        }
+        return;
+    }
 
     if (useGlobalCoord) {
         m_coordsBuffer.clear();
 
-        if (!obj.methods.has_value()) {
-            m_currentPool->addCoords(*obj.method, buffer, obj.drawMode);
-        } else for (const auto& method : *obj.methods) {
-            m_currentPool->addCoords(method, buffer, obj.drawMode);
-        }
+        for (auto it = begin; it != begin + obj.methodsCount; ++it)
+            DrawPool::addCoords(*it, m_coordsBuffer, obj.drawMode);
+    }
+
+    const CoordsBuffer& buffer = useGlobalCoord ? m_coordsBuffer : *frame.coords[obj.buffer];
+    batch.count = buffer.getVertexCount();
+    batch.cached = buffer.isCached();
+    if (batch.count == 0)
+        return;
+
+    // the same choice Painter::drawCoords makes, cached arrays stay in their own buffer
+    if (auto* hardwareBuffer = buffer.getHardwareVertexCache())
+        batch.vertices.buffer = hardwareBuffer;
+    else
+        batch.vertexOffset = addGeometry(buffer.getVertexArray(), batch.count * 2);
+
+    if (buffer.getTextureCoordCount() > 0) {
+        if (auto* hardwareBuffer = buffer.getHardwareTextureCoordCache())
+            batch.texCoords.buffer = hardwareBuffer;
+        else
+            batch.texCoordOffset = addGeometry(buffer.getTextureCoordArray(), batch.count * 2);
+    }
+}
+
+int DrawPoolManager::addGeometry(const float* data, const int floats)
+{
+    const int offset = m_frameGeometry.size();
+    m_frameGeometry.insert(m_frameGeometry.end(), data, data + floats);
+    return offset;
+}
+
+void DrawPoolManager::release()
+{
+    if (!m_hasFrame)
+        return;
+
+    for (const auto& pool : m_pools) {
+        pool->m_drawingFrame.clear(pool->m_drawingFloor);
+        pool->m_drawingFloor = 0;
+
+        pool->m_lastStats = pool->m_drawingStats;
+        pool->m_drawingStats = {};
+
+        if (pool->hasFrameBuffer())
+            pool->toPoolFramed()->m_drawingBeforeDraw = nullptr;
+    }
+
+    m_hasFrame = false;
+}
+
+void DrawPoolManager::drawObject(const DrawPool::Frame& frame, const DrawPool::DrawObject& obj, DrawPool::Stats& stats)
+{
+    if (obj.state == DrawPool::NO_INDEX) {
+        frame.actions[obj.action]();
+        return;
     }
 
+    assert(m_nextBatch < m_batches.size());
+    const auto& batch = m_batches[m_nextBatch++];
+    const auto& state = frame.states[obj.state];
+
     { // Set DrawState
-        const auto& state = obj.state;
 
-        if (state->texture) {
-            state->texture->create();
-            g_painter->setTexture(state->texture.get());
-        }
+        if (state.texture)
+            g_painter->setTexture(state.texture);
+
+        g_painter->setColor(state.color);
+        g_painter->setOpacity(state.opacity);
+        g_painter->setCompositionMode(state.compositionMode);
+        g_painter->setBlendEquation(state.blendEquation);
+        g_painter->setClipRect(state.clipRect);
+        g_painter->setShaderProgram(state.shaderProgram);
+        g_painter->setTransformMatrix(state.transformMatrix);
+        if (state.action != DrawPool::NO_INDEX) frame.actions[state.action]();
+
+        if (!m_lastState || !(*m_lastState == state))
+            ++stats.stateChanges;
+        m_lastState = &state;
+    }
 
-        g_painter->setColor(state->color);
-        g_painter->setOpacity(state->opacity);
-        g_painter->setCompositionMode(state->compositionMode);
-        g_painter->setBlendEquation(state->blendEquation);
-        g_painter->setClipRect(state->clipRect);
-        g_painter->setShaderProgram(state->shaderProgram);
-        g_painter->setTransformMatrix(state->transformMatrix);
-        if (state->action) state->action();
+    if (batch.instanced) {
+        ++stats.drawCalls;
+        stats.instances += batch.count;
+        g_painter->drawInstancedRects(batch.vertices, batch.count);
+        return;
     }
 
-    g_painter->drawCoords(buffer, obj.drawMode);
+    if (batch.count == 0)
+        return;
+
+    ++stats.drawCalls;
+
+    // cached buffers are counted by swap, when they are (re)built
+    if (!batch.cached)
+        stats.verticesUploaded += batch.count;
+
+    g_painter->drawCoords(batch.vertices, batch.texCoords, batch.count, obj.drawMode);
+}
+
+void DrawPoolManager::setReorderDrawings(const DrawPoolType type, const bool enable)
+{
+    if (auto* pool = get<DrawPool>(type))
+        pool->setReorderDrawings(enable);
+}
+
+bool DrawPoolManager::isReorderingDrawings(const DrawPoolType type)
+{
+    const auto* const pool = get<DrawPool>(type);
+    return pool && pool->isReorderingDrawings();
+}
+
+bool DrawPoolManager::canDrawInstanced(const DrawPool::DrawBucket& bucket, const DrawPool::DrawObject& obj, const DrawPool::PoolState& state) const
+{
+    // custom shaders have their own vertex stage
+    if (!m_instancing || !state.texture || state.shaderProgram || state.action != DrawPool::NO_INDEX || !g_painter->canDrawInstanced())
+        return false;
+
+    const auto begin = bucket.methods.begin() + obj.methodsBegin;
+    return std::all_of(begin, begin + obj.methodsCount, [](const DrawPool::DrawMethod& method) {
+        return method.type == DrawPool::DrawMethodType::RECT;
+    });
+}
+
+std::map<std::string, int> DrawPoolManager::getStats(const DrawPoolType type)
+{
+    const auto* const pool = get<DrawPool>(type);
+    if (!pool)
+        return {};
+
+    const auto& stats = pool->getStats();
+    return {
+        { "objects", stats.objects },
+        { "merges", stats.merges },
+        { "cacheHits", stats.cacheHits },
+        { "cacheInvalidations", stats.cacheInvalidations },
+        { "stateChanges", stats.stateChanges },
+        { "drawCalls", stats.drawCalls },
+        { "verticesUploaded", stats.verticesUploaded },
+        { "reorderMerges", stats.reorderMerges },
+        { "instances", stats.instances },
+        { "bytesStreamed", stats.bytesStreamed }
+    };
+}
+
+void DrawPoolManager::addStatsOverlay()
+{
+    if (!m_statsOverlay)
+        return;
+
+    static constexpr std::array<std::string_view, static_cast<uint8_t>(DrawPoolType::UNKNOW)> names{
+        "MAP", "CREATURE_INFORMATION", "LIGHT", "TEXT", "FOREGROUND"
+    };
+
+    std::string text;
+    for (int_fast8_t i = -1; ++i < static_cast<uint8_t>(DrawPoolType::UNKNOW);) {
+        const auto& stats = m_pools[i]->getStats();
+        text += stdext::format("%s: objects %d, merges %d, cache hits %d, invalidations %d, state changes %d, draw calls %d (-%d reordered), vertices %d, instances %d, streamed %d bytes\n",
+                               names[i], stats.objects, stats.merges, stats.cacheHits, stats.cacheInvalidations,
+                               stats.stateChanges, stats.drawCalls, stats.reorderMerges, stats.verticesUploaded, stats.instances, stats.bytesStreamed);
+    }
+
+    auto& streamBuffer = g_painter->getStreamBuffer();
+    const auto& streamed = streamBuffer.getStats();
+    text += stdext::format("VERTICES: writes %d, bytes %d, wraps %d, stall %d us (%s)\n",
+                           streamed.writes, streamed.bytes, streamed.wraps, streamed.stallMicros,
+                           !g_painter->isStreamingVertices() ? "client memory" : streamBuffer.isPersistent() ? "persistent" : "orphaning");
+
+    const auto& uploads = g_textures.getUploader().getStats();
+    auto atlas = g_atlas.getStats();
+    text += stdext::format("TEXTURES: uploads %d, bytes %d, orphans %d, stall %d us%s, atlas pages %d/%d, regions %d, evictions %d",
+                           uploads.uploads, uploads.bytes, uploads.orphans, uploads.stallMicros, g_textures.isStreamingUploads() ? " (streaming)" : "",
+                           atlas["pages"], atlas["maxPages"], atlas["regions"], atlas["evictions"]);
+
+    // the text pool is drawn every frame and is not cleared by select
+    select(DrawPoolType::TEXT);
+    resetOpacity();
+    resetClipRect();
+
+    const auto& font = g_fonts.getDefaultFont();
+    const Rect rect(Point(8, 8), font->calculateTextRectSize(text));
+    addFilledRect(rect.expanded(4), Color(0, 0, 0, 160));
+    font->drawText(text, rect, Color::white, Fw::AlignTopLeft);
 }
 
 void DrawPoolManager::addTexturedCoordsBuffer(const TexturePtr& texture, const CoordsBufferPtr& coords, const Color& color)
@@ -151,8 +465,9 @@ void DrawPoolManager::addTexturedRect(const Rect& dest, const TexturePtr& textur
 
     const DrawPool::DrawMethod method{
         .type = DrawPool::DrawMethodType::RECT,
-        .rects = std::make_pair(dest, src),
-        .dest = originalDest.isNull() ? std::optional<Point>{} : originalDest
+        .dest = dest,
+        .src = src,
+        .originalDest = originalDest
     };
 
     if (buffer)
@@ -166,7 +481,7 @@ void DrawPoolManager::addUpsideDownTexturedRect(const Rect& dest, const TextureP
     if (dest.isEmpty() || src.isEmpty())
         return;
 
-    const DrawPool::DrawMethod method{ DrawPool::DrawMethodType::UPSIDEDOWN_RECT, std::make_pair(dest, src) };
+    const DrawPool::DrawMethod method{ .type = DrawPool::DrawMethodType::UPSIDEDOWN_RECT, .dest = dest, .src = src };
 
     m_currentPool->add(color, texture, method, DrawMode::TRIANGLE_STRIP);
 }
@@ -176,7 +491,7 @@ void DrawPoolManager::addTexturedRepeatedRect(const Rect& dest, const TexturePtr
     if (dest.isEmpty() || src.isEmpty())
         return;
 
-    const DrawPool::DrawMethod method{ DrawPool::DrawMethodType::REPEATED_RECT, std::make_pair(dest, src) };
+    const DrawPool::DrawMethod method{ .type = DrawPool::DrawMethodType::REPEATED_RECT, .dest = dest, .src = src };
 
     m_currentPool->add(color, texture, method);
 }
@@ -186,7 +501,7 @@ void DrawPoolManager::addFilledRect(const Rect& dest, const Color& color, const
     if (dest.isEmpty())
         return;
 
-    const DrawPool::DrawMethod method{ DrawPool::DrawMethodType::RECT, std::make_pair(dest, Rect()) };
+    const DrawPool::DrawMethod method{ .type = DrawPool::DrawMethodType::RECT, .dest = dest };
 
     m_currentPool->add(color, nullptr, method, DrawMode::TRIANGLES, buffer);
 }
@@ -196,7 +511,7 @@ void DrawPoolManager::addFilledTriangle(const Point& a, const Point& b, const Po
     if (a == b || a == c || b == c)
         return;
 
-    const DrawPool::DrawMethod method{ .type = DrawPool::DrawMethodType::TRIANGLE, .points = std::make_tuple(a, b, c) };
+    const DrawPool::DrawMethod method{ .type = DrawPool::DrawMethodType::TRIANGLE, .a = a, .b = b, .c = c };
 
     m_currentPool->add(color, nullptr, method);
 }
@@ -208,7 +523,7 @@ void DrawPoolManager::addBoundingRect(const Rect& dest, const Color& color, int
 
     const DrawPool::DrawMethod method{
         .type = DrawPool::DrawMethodType::BOUNDING_RECT,
-        .rects = std::make_pair(dest, Rect()),
+        .dest = dest,
         .intValue = static_cast<uint16_t>(innerLineWidth)
     };
 
@@ -217,7 +532,49 @@ void DrawPoolManager::addBoundingRect(const Rect& dest, const Color& color, int
 
 void DrawPoolManager::addAction(std::function<void()> action)
 {
-    m_currentPool->m_objects[0][static_cast<uint8_t>(DrawPool::DrawOrder::FIRST)].emplace_back(action);
+    m_currentPool->addAction(std::move(action));
+}
+
+void DrawPoolManager::pushTransformMatrix()
+{
+    m_transformMatrixStack.push_back(m_transformMatrix);
+    assert(m_transformMatrixStack.size() < 100);
+}
+
+void DrawPoolManager::popTransformMatrix()
+{
+    assert(!m_transformMatrixStack.empty());
+    m_transformMatrix = m_transformMatrixStack.back();
+    m_transformMatrixStack.pop_back();
+}
+
+void DrawPoolManager::translate(float x, float y)
+{
+    const Matrix3 translateMatrix = {
+            1.0f,  0.0f,     x,
+            0.0f,  1.0f,     y,
+            0.0f,  0.0f,  1.0f
+    };
+
+    m_transformMatrix = m_transformMatrix * translateMatrix.transposed();
+}
+
+void DrawPoolManager::rotate(float angle)
+{
+    const Matrix3 rotationMatrix = {
+            std::cos(angle), -std::sin(angle),  0.0f,
+            std::sin(angle),  std::cos(angle),  0.0f,
+                       0.0f,             0.0f,  1.0f
+    };
+
+    m_transformMatrix = m_transformMatrix * rotationMatrix.transposed();
+}
+
+void DrawPoolManager::rotate(const Point& p, float angle)
+{
+    translate(-p.x, -p.y);
+    rotate(angle);
+    translate(p.x, p.y);
 }
 
 void DrawPoolManager::use(const DrawPoolType type) { use(type, {}, {}); }
@@ -64,19 +64,87 @@ public:
     void resetCompositionMode() { m_currentPool->resetCompositionMode(); }
 
     void flush() { if (m_currentPool) m_currentPool->flush(); }
-private:
+
+    // transform applied to the recorded drawings, replaces the painter one while recording
+    void pushTransformMatrix();
+    void popTransformMatrix();
+    void translate(float x, float y);
+    void translate(const Point& p) { translate(p.x, p.y); }
+    void rotate(float angle);
+    void rotate(const Point& p, float angle);
+    const Matrix3& getTransformMatrix() const { return m_transformMatrix; }
+
+    // submits every pool to the painter and clears them, called once per frame.
+    // it is swap(), drawFrame() and release() in a row, see GraphicalApplication::setRenderThread
+    // for the case where drawFrame() runs on another thread.
     void draw();
+
+    // hands the recorded pools to the drawing side and starts recording the next frame,
+    // runs on the main thread while no frame is being drawn.
+    void swap();
+    // submits the frame handed off by swap(), only gl work, on the thread owning the context.
+    void drawFrame();
+    // publishes the stats of the drawn frame and frees it, on the main thread.
+    void release();
+
+    // counters of the last drawn frame of a pool, keyed by name
+    std::map<std::string, int> getStats(DrawPoolType type);
+
+    void setReorderDrawings(DrawPoolType type, bool enable);
+    bool isReorderingDrawings(DrawPoolType type);
+
+    // textured rects drawn with the default program are expanded from a unit quad by the gpu,
+    // see Painter::drawInstancedRects, the vertex path stays for everything else
+    void setInstancing(bool enable) { m_instancing = enable; }
+    bool isInstancing() { return m_instancing; }
+
+    // the dynamic vertices of a frame are copied into one ring buffer at once instead of read
+    // from client memory, see StreamBuffer
+    void setStreamingVertices(bool enable) { g_painter->setStreamingVertices(enable); }
+    bool isStreamingVertices() { return g_painter->isStreamingVertices(); }
+
+    void setStatsOverlay(bool enable) { m_statsOverlay = enable; }
+    bool isStatsOverlayEnabled() { return m_statsOverlay; }
+    void addStatsOverlay();
+
+private:
+    // where the geometry of an object drawn by drawFrame is read from, in drawing order
+    struct Batch
+    {
+        Painter::VertexRange vertices, texCoords;
+        int vertexOffset{ -1 }, // in floats into m_frameGeometry until the upload places it, -1 when elsewhere
+            texCoordOffset{ -1 },
+            count{ 0 }; // vertices, or rects when instanced
+        bool instanced{ false },
+            cached{ false };
+    };
+
     void init();
     void terminate();
-    void drawObject(const DrawPool::DrawObject& obj);
+    void prepareFrame();
+    void prepareObject(const DrawPool::Frame& frame, const DrawPool::DrawBucket& bucket, const DrawPool::DrawObject& obj);
+    int addGeometry(const float* data, int floats);
+    void drawObject(const DrawPool::Frame& frame, const DrawPool::DrawObject& obj, DrawPool::Stats& stats);
+    bool canDrawInstanced(const DrawPool::DrawBucket& bucket, const DrawPool::DrawObject& obj, const DrawPool::PoolState& state) const;
 
     CoordsBuffer m_coordsBuffer;
+    std::vector<float> m_frameGeometry;
+    std::vector<Batch> m_batches;
+    size_t m_nextBatch{ 0 };
     std::array<DrawPool*, static_cast<uint8_t>(DrawPoolType::UNKNOW) + 1> m_pools{};
 
     DrawPool* m_currentPool{ nullptr };
+    const DrawPool::PoolState* m_lastState{ nullptr };
+
+    bool m_statsOverlay{ false },
+        m_hasFrame{ false },
+        m_instancing{ true };
 
     Size m_size;
+    Matrix3 m_projectionMatrix;
+
     Matrix3 m_transformMatrix;
+    std::vector<Matrix3> m_transformMatrixStack;
 
     friend class GraphicalApplication;
 };
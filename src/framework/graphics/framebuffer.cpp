@@ -40,6 +40,11 @@ void FrameBuffer::internalCreate()
 {
     m_prevBoundFbo = 0;
     m_fbo = 0;
+
+    // the null graphics backend has no context, nothing is bound or drawn into
+    if (g_graphics.isNullBackend())
+        return;
+
     glGenFramebuffers(1, &m_fbo);
     if (!m_fbo)
         g_logger.fatal("Unable to create framebuffer object");
@@ -51,42 +56,73 @@ FrameBuffer::~FrameBuffer()
     assert(!g_app.isTerminated());
 #endif
     if (g_graphics.ok() && m_fbo != 0)
-        glDeleteFramebuffers(1, &m_fbo);
+        g_graphics.runWhenCurrent([fbo = m_fbo] { glDeleteFramebuffers(1, &fbo); });
 }
 
 void FrameBuffer::resize(const Size& size)
 {
     assert(size.isValid());
 
-    if (m_texture && m_texture->getSize() == size)
+    // the texture is (re)created by update(), on the thread that draws
+    m_state.size = size;
+}
+
+void FrameBuffer::update()
+{
+    const Size& size = m_drawState.size;
+    if (!size.isValid())
         return;
 
-    m_texture = TexturePtr(new Texture(size));
-    m_texture->setSmooth(m_smooth);
-    m_texture->setUpsideDown(true);
-    m_textureMatrix = g_painter->getTransformMatrix(size);
+    if (!m_texture || m_texture->getSize() != size) {
+        m_texture = TexturePtr(new Texture(size));
+        m_texture->setSmooth(m_drawState.smooth);
+        m_texture->setUpsideDown(true);
+        m_textureMatrix = g_painter->getTransformMatrix(size);
 
-    internalBind();
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture->getId(), 0);
+        if (m_fbo != 0) {
+            internalBind();
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture->getId(), 0);
 
-    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-    if (status != GL_FRAMEBUFFER_COMPLETE)
-        g_logger.fatal("Unable to setup framebuffer object");
+            const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+            if (status != GL_FRAMEBUFFER_COMPLETE)
+                g_logger.fatal("Unable to setup framebuffer object");
 
-    internalRelease();
+            internalRelease();
+        }
+
+        // forces the coords to be rebuilt for the new size
+        m_dest = {};
+    } else
+        m_texture->setSmooth(m_drawState.smooth);
+
+    Rect dest(0, 0, size), src = dest;
+    if (m_drawState.dest.isValid()) dest = m_drawState.dest;
+    if (m_drawState.src.isValid()) src = m_drawState.src;
+
+    if (src != m_src || dest != m_dest) {
+        m_src = src;
+        m_dest = dest;
+
+        m_coordsBuffer.clear();
+        m_coordsBuffer.addQuad(m_dest, m_src);
+
+        m_screenCoordsBuffer.clear();
+        m_screenCoordsBuffer.addRect(Rect{ 0, 0, size });
+    }
 }
 
 void FrameBuffer::bind()
 {
+    update();
     internalBind();
 
     g_painter->resetState();
-    g_painter->setResolution(getSize(), m_textureMatrix);
+    g_painter->setResolution(m_drawState.size, m_textureMatrix);
     g_painter->setAlphaWriting(m_useAlphaWriting);
 
-    if (m_colorClear != Color::alpha) {
+    if (m_drawState.colorClear != Color::alpha) {
         g_painter->setTexture(nullptr);
-        g_painter->setColor(m_colorClear);
+        g_painter->setColor(m_drawState.colorClear);
         g_painter->drawCoords(m_screenCoordsBuffer, DrawMode::TRIANGLE_STRIP);
     }
 }
@@ -98,16 +134,24 @@ void FrameBuffer::release()
 
 void FrameBuffer::draw()
 {
-    if (m_disableBlend) glDisable(GL_BLEND);
+    update();
+    if (!m_texture)
+        return;
+
+    const bool disableBlend = m_disableBlend && m_fbo != 0;
+    if (disableBlend) glDisable(GL_BLEND);
     g_painter->setCompositionMode(m_compositeMode);
     g_painter->setTexture(m_texture.get());
     g_painter->drawCoords(m_coordsBuffer, DrawMode::TRIANGLE_STRIP);
     g_painter->resetCompositionMode();
-    if (m_disableBlend) glEnable(GL_BLEND);
+    if (disableBlend) glEnable(GL_BLEND);
 }
 
 void FrameBuffer::internalBind()
 {
+    if (m_fbo == 0)
+        return;
+
     assert(boundFbo != m_fbo);
     glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
     m_prevBoundFbo = boundFbo;
@@ -116,6 +160,9 @@ void FrameBuffer::internalBind()
 
 void FrameBuffer::internalRelease()
 {
+    if (m_fbo == 0)
+        return;
+
     assert(boundFbo == m_fbo);
     glBindFramebuffer(GL_FRAMEBUFFER, m_prevBoundFbo);
     boundFbo = m_prevBoundFbo;
@@ -123,19 +170,7 @@ void FrameBuffer::internalRelease()
 
 void FrameBuffer::prepare(const Rect& dest, const Rect& src, const Color& colorClear)
 {
-    m_colorClear = colorClear;
-    Rect _dest(0, 0, getSize()), _src = _dest;
-    if (dest.isValid()) _dest = dest;
-    if (src.isValid()) _src = src;
-
-    if (_src != m_src || _dest != m_dest) {
-        m_src = _src;
-        m_dest = _dest;
-
-        m_coordsBuffer.clear();
-        m_coordsBuffer.addQuad(m_dest, m_src);
-
-        m_screenCoordsBuffer.clear();
-        m_screenCoordsBuffer.addRect(Rect{ 0, 0, getSize() });
-    }
+    m_state.colorClear = colorClear;
+    m_state.dest = dest;
+    m_state.src = src;
 }
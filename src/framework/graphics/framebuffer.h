@@ -36,14 +36,14 @@ public:
     void bind();
     void draw();
 
-    void setSmooth(bool enabled) { m_smooth = enabled; m_texture = nullptr; }
+    void setSmooth(bool enabled) { m_state.smooth = enabled; }
     void setBackuping(bool enabled) { m_backuping = enabled; }
 
     TexturePtr getTexture() { return m_texture; }
-    Size getSize() { return m_texture->getSize(); }
+    Size getSize() { return m_state.size; }
 
     bool isBackuping() { return m_backuping; }
-    bool isSmooth() { return m_smooth; }
+    bool isSmooth() { return m_state.smooth; }
 
     void setCompositionMode(const CompositionMode mode) { m_compositeMode = mode; }
     void disableBlend() { m_disableBlend = true; }
@@ -51,17 +51,29 @@ public:
 protected:
     FrameBuffer(bool useAlphaWriting);
 
-    Color m_colorClear{ Color::alpha };
-
     friend class FrameBufferManager;
     friend class DrawPoolManager;
 
 private:
+    // size and coords requested while recording, read by bind() and draw() once committed
+    struct State
+    {
+        Size size;
+        Rect dest, src;
+        Color colorClear{ Color::alpha };
+        bool smooth{ true };
+    };
+
     void internalCreate();
     void internalBind();
     void internalRelease();
     void prepare(const Rect& dest, const Rect& src, const Color& colorClear = Color::alpha);
 
+    // hands the recorded state to the drawing side, see DrawPoolManager::swap
+    void commit() { m_drawState = m_state; }
+    // applies the committed state, creating the texture and coords when they changed
+    void update();
+
     static uint32_t boundFbo;
 
     Matrix3 m_textureMatrix;
@@ -72,10 +84,11 @@ private:
     CompositionMode m_compositeMode{ CompositionMode::NORMAL };
 
     bool m_backuping{ true },
-        m_smooth{ true },
         m_useAlphaWriting{ false },
         m_disableBlend{ false };
 
+    State m_state, m_drawState;
+
     Rect m_dest, m_src;
     CoordsBuffer m_coordsBuffer, m_screenCoordsBuffer;
 };
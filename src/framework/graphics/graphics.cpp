@@ -23,6 +23,9 @@
 #include "fontmanager.h"
 
 #include "framebuffermanager.h"
+#include "image.h"
+#include "nullpainter.h"
+#include "textureatlas.h"
 #include "texturemanager.h"
 #include <framework/graphics/graphics.h>
 #include <framework/platform/platformwindow.h>
@@ -31,12 +34,38 @@ Graphics g_graphics;
 
 void Graphics::init()
 {
+    if (m_nullBackend) {
+        g_logger.info("Null graphics backend, nothing is drawn");
+
+        // nothing is uploaded, any size the pages and framebuffers ask for is fine
+        if (m_maxTextureSize == -1)
+            m_maxTextureSize = 4096;
+
+        m_ok = true;
+        g_painter = new NullPainter;
+    } else
+        initContext();
+
+    g_textures.init();
+    g_atlas.init();
+    g_framebuffers.init();
+}
+
+void Graphics::initContext()
+{
+    m_contextThread = std::this_thread::get_id();
+
     g_logger.info(stdext::format("GPU %s", glGetString(GL_RENDERER)));
     g_logger.info(stdext::format("OpenGL %s", glGetString(GL_VERSION)));
 
     // init GL extensions
     const GLenum err = glewInit();
+#ifdef FRAMEWORK_OFFSCREEN
+    // the offscreen context is not created through GLX, glew still loads every GL entry point
+    if (err != GLEW_OK && err != GLEW_ERROR_NO_GLX_DISPLAY)
+#else
     if (err != GLEW_OK)
+#endif
         g_logger.fatal(stdext::format("Unable to init GLEW: %s", glewGetErrorString(err)));
 
     // overwrite framebuffer API if needed
@@ -65,15 +94,61 @@ void Graphics::init()
 
     g_painter = new Painter;
     g_painter->bind();
+}
 
-    g_textures.init();
-    g_framebuffers.init();
+ImagePtr Graphics::readScreen()
+{
+    const ImagePtr image(new Image(m_viewportSize));
+    const int rowSize = m_viewportSize.width() * 4;
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_viewportSize.width(), m_viewportSize.height(), GL_RGBA, GL_UNSIGNED_BYTE, image->getPixelData());
+
+    // gl rows start at the bottom
+    uint8_t* pixels = image->getPixelData();
+    for (int top = 0, bottom = m_viewportSize.height() - 1; top < bottom; ++top, --bottom)
+        std::swap_ranges(pixels + top * rowSize, pixels + (top + 1) * rowSize, pixels + bottom * rowSize);
+
+    return image;
+}
+
+void Graphics::makeCurrent()
+{
+    g_window.makeContextCurrent(true);
+    m_contextThread = std::this_thread::get_id();
+
+    std::vector<std::function<void()>> tasks;
+    {
+        std::scoped_lock lock(m_pendingMutex);
+        tasks.swap(m_pendingTasks);
+    }
+
+    for (const auto& task : tasks)
+        task();
+}
+
+void Graphics::releaseCurrent()
+{
+    m_contextThread = std::thread::id();
+    g_window.makeContextCurrent(false);
+}
+
+void Graphics::runWhenCurrent(std::function<void()> task)
+{
+    if (isCurrent()) {
+        task();
+        return;
+    }
+
+    std::scoped_lock lock(m_pendingMutex);
+    m_pendingTasks.emplace_back(std::move(task));
 }
 
 void Graphics::terminate()
 {
     g_fonts.terminate();
     g_framebuffers.terminate();
+    g_atlas.terminate();
     g_textures.terminate();
 
     delete g_painter;
@@ -25,6 +25,10 @@
 #include "declarations.h"
 #include <GL/glew.h>
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
  // @bindsingleton g_graphics
 class Graphics
 {
@@ -34,11 +38,20 @@ public:
     // @dontbind
     void terminate();
 
+    // before init, there is no window or context and the painter only records, see NullPainter;
+    // meant for benchmarks driving the draw pools themselves, the application loop needs a window
+    // @dontbind
+    void setNullBackend(bool enable) { m_nullBackend = enable; }
+    bool isNullBackend() { return m_nullBackend; }
+
     void resize(const Size& size);
 
     int getMaxTextureSize() { return m_maxTextureSize; }
     const Size& getViewportSize() { return m_viewportSize; }
 
+    // reads back the pixels of the bound framebuffer, top row first
+    ImagePtr readScreen();
+
     std::string getVendor() { return (const char*)glGetString(GL_VENDOR); }
     std::string getRenderer() { return (const char*)glGetString(GL_RENDERER); }
     std::string getVersion() { return (const char*)glGetString(GL_VERSION); }
@@ -46,8 +59,27 @@ public:
 
     bool ok() { return m_ok; }
 
+    // the context is current on the main thread, unless it was handed to the render thread
+    // @dontbind
+    void makeCurrent();
+    // @dontbind
+    void releaseCurrent();
+    bool isCurrent() const { return m_contextThread.load() == std::this_thread::get_id(); }
+
+    // runs gl work right away when the context is current on the calling thread,
+    // otherwise it is deferred to the next makeCurrent (e.g. objects released while recording)
+    // @dontbind
+    void runWhenCurrent(std::function<void()> task);
+
 private:
-    bool m_ok{ false };
+    void initContext();
+
+    bool m_ok{ false },
+        m_nullBackend{ false };
+
+    std::atomic<std::thread::id> m_contextThread;
+    std::mutex m_pendingMutex;
+    std::vector<std::function<void()>> m_pendingTasks;
 
     int m_maxTextureSize{ -1 },
         m_alphaBits{ 0 };
@@ -28,6 +28,10 @@
 
 HardwareBuffer::HardwareBuffer(Type type) :m_type(type)
 {
+    // the null graphics backend has no context, binds and writes are ignored
+    if (g_graphics.isNullBackend())
+        return;
+
     glGenBuffers(1, &m_id);
     if (!m_id)
         g_logger.fatal("Unable to create hardware buffer.");
@@ -38,6 +42,175 @@ HardwareBuffer::~HardwareBuffer()
 #ifndef NDEBUG
     assert(!g_app.isTerminated());
 #endif
-    if (g_graphics.ok())
-        glDeleteBuffers(1, &m_id);
+    if (g_graphics.ok() && m_id != 0)
+        g_graphics.runWhenCurrent([id = m_id] { glDeleteBuffers(1, &id); });
+}
+
+void StreamBuffer::init(const int size)
+{
+    m_size = size - size % (SEGMENTS * ALIGNMENT);
+    m_buffer = std::make_unique<HardwareBuffer>(HardwareBuffer::Type::VERTEX_BUFFER);
+    m_buffer->bind();
+
+#ifndef OPENGL_ES
+    if ((GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) && (GLEW_VERSION_3_2 || GLEW_ARB_sync)) {
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, m_size, nullptr, flags);
+        m_mapped = static_cast<uint8_t*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, m_size, flags));
+
+        // immutable storage can not be orphaned, start over with a plain buffer
+        if (!m_mapped) {
+            m_buffer = std::make_unique<HardwareBuffer>(HardwareBuffer::Type::VERTEX_BUFFER);
+            m_buffer->bind();
+        }
+    }
+#endif
+
+    if (!m_mapped)
+        m_buffer->write(nullptr, m_size, HardwareBuffer::UsagePattern::STREAM_DRAW);
+
+    HardwareBuffer::unbind(HardwareBuffer::Type::VERTEX_BUFFER);
+}
+
+void StreamBuffer::terminate()
+{
+    if (!m_buffer)
+        return;
+
+#ifndef OPENGL_ES
+    for (auto& fence : m_fences) {
+        if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if (m_mapped) {
+        m_buffer->bind();
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        HardwareBuffer::unbind(HardwareBuffer::Type::VERTEX_BUFFER);
+    }
+#endif
+
+    m_mapped = nullptr;
+    m_buffer = nullptr;
+    m_head = m_segment = m_written = 0;
+}
+
+bool StreamBuffer::write(const void* data, const int bytes, intptr_t& offset)
+{
+    const int size = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (!m_buffer || size > m_size / SEGMENTS)
+        return false;
+
+    const int head = m_head + size > m_size ? 0 : m_head;
+
+    // the draws of this frame may read anywhere in the storage, see beginFrame
+    if (!m_mapped && head != m_head)
+        return false;
+
+#ifndef OPENGL_ES
+    if (m_mapped && !enterSegments(head, head + size))
+        return false;
+#endif
+
+    m_buffer->bind();
+
+    if (head != m_head)
+        ++m_stats.wraps;
+
+    if (m_mapped)
+        std::memcpy(m_mapped + head, data, bytes);
+    else
+        glBufferSubData(GL_ARRAY_BUFFER, head, bytes, data);
+
+    offset = head;
+    m_head = head + size;
+
+    ++m_stats.writes;
+    m_stats.bytes += bytes;
+    return true;
+}
+
+void StreamBuffer::beginFrame()
+{
+    // the persistent ring is guarded by its fences instead
+    if (!m_buffer || m_mapped || m_size - m_head >= m_size / SEGMENTS)
+        return;
+
+    // room for the largest write, the storage still read by the last frames is left to the driver
+    m_buffer->bind();
+    m_buffer->write(nullptr, m_size, HardwareBuffer::UsagePattern::STREAM_DRAW);
+    m_head = 0;
+
+    ++m_stats.wraps;
+}
+
+void StreamBuffer::endFrame()
+{
+#ifndef OPENGL_ES
+    if (!m_mapped)
+        return;
+
+    for (int segment = -1; ++segment < SEGMENTS;) {
+        if (!(m_written & 1 << segment))
+            continue;
+
+        auto& fence = m_fences[segment];
+        if (fence)
+            glDeleteSync(fence);
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+#endif
+
+    m_written = 0;
+}
+
+#ifndef OPENGL_ES
+bool StreamBuffer::enterSegments(const int begin, const int end)
+{
+    const int segmentSize = m_size / SEGMENTS;
+    const int first = begin / segmentSize;
+    const int last = (end - 1) / segmentSize;
+
+    // the draws reading a segment written since the last fence may not be issued yet, nothing guards it
+    for (int segment = first; segment <= last; ++segment) {
+        if (segment != m_segment && m_written & 1 << segment)
+            return false;
+    }
+
+    for (int segment = first; segment <= last; ++segment) {
+        m_written |= 1 << segment;
+        if (segment == m_segment)
+            continue;
+
+        // the data of the last lap is still read by the draws before this fence
+        m_segment = segment;
+        waitFence(m_fences[segment]);
+    }
+
+    return true;
+}
+
+void StreamBuffer::waitFence(GLsync& fence)
+{
+    if (!fence)
+        return;
+
+    const ticks_t start = stdext::micros();
+
+    GLenum status;
+    do {
+        status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    } while (status == GL_TIMEOUT_EXPIRED);
+
+    // the fence state is unknown, wait for everything so the segment is surely free
+    if (status == GL_WAIT_FAILED)
+        glFinish();
+
+    glDeleteSync(fence);
+    fence = nullptr;
+
+    m_stats.stallMicros += stdext::micros() - start;
 }
+#endif
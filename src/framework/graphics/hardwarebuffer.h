@@ -30,7 +30,10 @@ public:
     enum class Type
     {
         VERTEX_BUFFER = GL_ARRAY_BUFFER,
-        INDEX_BUFFER = GL_ELEMENT_ARRAY_BUFFER
+        INDEX_BUFFER = GL_ELEMENT_ARRAY_BUFFER,
+#ifndef OPENGL_ES
+        PIXEL_UNPACK_BUFFER = GL_PIXEL_UNPACK_BUFFER
+#endif
     };
 
     enum class UsagePattern
@@ -43,11 +46,80 @@ public:
     HardwareBuffer(Type type);
     ~HardwareBuffer();
 
-    void bind() { glBindBuffer(static_cast<GLenum>(m_type), m_id); }
+    void bind() { if (m_id != 0) glBindBuffer(static_cast<GLenum>(m_type), m_id); }
     static void unbind(Type type) { glBindBuffer(static_cast<GLenum>(type), 0); }
-    void write(void* data, int count, UsagePattern usage) { glBufferData(static_cast<GLenum>(m_type), count, data, static_cast<GLenum>(usage)); }
+    void write(void* data, int count, UsagePattern usage) { if (m_id != 0) glBufferData(static_cast<GLenum>(m_type), count, data, static_cast<GLenum>(usage)); }
 
 private:
     Type m_type;
-    uint32_t m_id;
+    uint32_t m_id{ 0 };
+};
+
+/**
+ * A large vertex buffer written as a ring, each write is placed after the previous one.
+ *
+ * The draw pool writes the dynamic geometry of a whole frame at once, see DrawPoolManager::drawFrame.
+ * With buffer storage the ring is mapped once for its whole life and the data is copied straight
+ * into it. The ring is split in segments, the end of a frame puts a fence on the segments it
+ * wrote and entering a segment again waits for it, that wait counts as stall time. Without
+ * it the data goes through glBufferSubData and a ring too full for a frame orphans its storage
+ * when the frame begins, the driver keeps the old one alive until the draws reading it finish.
+ * Draws of the frame may still point into the storage, so it is never orphaned mid-frame, data
+ * that does not fit until the next frame is left for client memory. OpenGL ES always takes this path.
+ */
+class StreamBuffer
+{
+public:
+    struct Stats
+    {
+        int writes{ 0 },
+            bytes{ 0 },
+            wraps{ 0 },
+            stallMicros{ 0 };
+    };
+
+    ~StreamBuffer() { terminate(); }
+
+    void init(int size);
+    void terminate();
+
+    bool isSupported() { return m_buffer != nullptr; }
+    bool isPersistent() { return m_mapped != nullptr; }
+    HardwareBuffer* getBuffer() { return m_buffer.get(); }
+
+    // copies the data into the ring and binds it, the offset of the copy is returned in offset.
+    // fails on data larger than a segment or when the ring is full of data not fenced yet,
+    // or not drawn yet without buffer storage, that data is left for client memory
+    bool write(const void* data, int bytes, intptr_t& offset);
+
+    // called before the frame geometry is written, see DrawPoolManager::prepareFrame
+    void beginFrame();
+
+    // fences the segments written since the last call, after the draws reading them were issued
+    void endFrame();
+
+    // called once per frame, see DrawPoolManager::swap
+    void nextFrame() { m_lastStats = m_stats; m_stats = {}; }
+    const Stats& getStats() { return m_lastStats; }
+
+private:
+    enum { SEGMENTS = 4, ALIGNMENT = 16 };
+
+#ifndef OPENGL_ES
+    bool enterSegments(int begin, int end);
+    void waitFence(GLsync& fence);
+
+    std::array<GLsync, SEGMENTS> m_fences{};
+#endif
+
+    std::unique_ptr<HardwareBuffer> m_buffer;
+    uint8_t* m_mapped{ nullptr };
+
+    int m_size{ 0 },
+        m_head{ 0 },
+        m_segment{ 0 };
+
+    uint8_t m_written{ 0 }; // segments written since the last fence, one bit each
+
+    Stats m_stats, m_lastStats;
 };
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "nullpainter.h"
+
+NullPainter::NullPainter() : Painter(StateOnly{})
+{
+    m_instancingSupported = true;
+}
+
+void NullPainter::drawCoords(const VertexRange& /*vertices*/, const VertexRange& texCoords, const int vertexCount, DrawMode /*drawMode*/)
+{
+    if (vertexCount == 0)
+        return;
+
+    recordTexture(!texCoords.isNull() && m_texture);
+
+    ++m_stats.drawCalls;
+    m_stats.vertices += vertexCount;
+}
+
+void NullPainter::drawInstancedRects(const VertexRange& /*instances*/, const int count)
+{
+    if (count == 0 || !m_texture)
+        return;
+
+    recordTexture(true);
+
+    ++m_stats.drawCalls;
+    m_stats.vertices += 4;
+    m_stats.instances += count;
+}
+
+void NullPainter::recordTexture(const bool textured)
+{
+    // the texture a gl draw would bind, untextured draws keep the last one bound
+    if (!textured || m_texture == m_drawnTexture)
+        return;
+
+    m_drawnTexture = m_texture;
+    ++m_stats.textureChanges;
+}
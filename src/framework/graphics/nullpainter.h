@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "painter.h"
+
+/**
+ * Painter of the null graphics backend, see Graphics::setNullBackend.
+ *
+ * There is no context: draws and state changes are recorded instead of reaching gl, so the
+ * draw pools can be recorded and submitted headless, e.g. by the map benchmark in CI. Textures,
+ * framebuffers and buffers exist without gl objects and shaders are never created, a draw goes
+ * through even when its texture is empty. Instancing is reported as supported, so the same
+ * batches are built as with a desktop GL 3.3 context.
+ */
+class NullPainter : public Painter
+{
+public:
+    struct Stats
+    {
+        int drawCalls{ 0 },
+            vertices{ 0 },
+            instances{ 0 },
+            textureChanges{ 0 },
+            clears{ 0 };
+    };
+
+    NullPainter();
+
+    void bind() override {}
+    void unbind() override {}
+
+    void clear(const Color& /*color*/) override { ++m_stats.clears; }
+    void clearRect(const Color& /*color*/, const Rect& /*rect*/) override { ++m_stats.clears; }
+
+    void drawCoords(const VertexRange& vertices, const VertexRange& texCoords, int vertexCount, DrawMode drawMode) override;
+    void drawInstancedRects(const VertexRange& instances, int count) override;
+
+    // what was drawn since the last reset
+    const Stats& getStats() { return m_stats; }
+    void resetStats() { m_stats = {}; }
+
+protected:
+    bool canDrawTexture(Texture* /*texture*/) override { return true; }
+    void updateGlTexture() override {}
+    void updateGlCompositionMode() override {}
+    void updateGlBlendEquation() override {}
+    void updateGlClipRect() override {}
+    void updateGlAlphaWriting() override {}
+    void updateGlViewport() override {}
+
+private:
+    void recordTexture(bool textured);
+
+    const Texture* m_drawnTexture{ nullptr };
+    Stats m_stats;
+};
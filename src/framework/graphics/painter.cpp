@@ -50,9 +50,39 @@ Painter::Painter()
     m_drawSolidColorProgram->addShaderFromSourceCode(ShaderType::FRAGMENT, std::string{ glslMainFragmentShader } + glslSolidColorFragmentShader.data());
     m_drawSolidColorProgram->link();
 
+#ifndef OPENGL_ES
+    m_instancingArb = !GLEW_VERSION_3_3 && GLEW_ARB_instanced_arrays && GLEW_ARB_draw_instanced;
+    m_instancingSupported = GLEW_VERSION_3_3 || m_instancingArb;
+
+    if (m_instancingSupported) {
+        m_drawInstancedProgram = PainterShaderProgramPtr(new PainterShaderProgram);
+        m_drawInstancedProgram->addShaderFromSourceCode(ShaderType::VERTEX, std::string{ glslInstancedRectVertexShader });
+        m_drawInstancedProgram->addShaderFromSourceCode(ShaderType::FRAGMENT, std::string{ glslMainFragmentShader } + glslTextureSrcFragmentShader.data());
+        m_instancingSupported = m_drawInstancedProgram->link();
+    }
+
+    if (m_instancingSupported) {
+        static float quad[] = { 0.f, 0.f, 1.f, 0.f, 0.f, 1.f, 1.f, 1.f };
+
+        m_quadBuffer = std::make_unique<HardwareBuffer>(HardwareBuffer::Type::VERTEX_BUFFER);
+        m_quadBuffer->bind();
+        m_quadBuffer->write(quad, sizeof(quad), HardwareBuffer::UsagePattern::STATIC_DRAW);
+        HardwareBuffer::unbind(HardwareBuffer::Type::VERTEX_BUFFER);
+    }
+#endif
+
+    // a segment holds the dynamic geometry of a whole frame, see DrawPoolManager::drawFrame
+    m_streamBuffer.init(16 * 1024 * 1024);
+
     PainterShaderProgram::release();
 }
 
+Painter::Painter(StateOnly)
+{
+    m_resolution = g_window.getSize();
+    m_projectionMatrix = getTransformMatrix(m_resolution);
+}
+
 void Painter::bind()
 {
     refreshState();
@@ -70,7 +100,21 @@ void Painter::unbind()
     PainterShaderProgram::release();
 }
 
+bool Painter::canDrawTexture(Texture* texture)
+{
+    return !texture->isEmpty();
+}
+
 void Painter::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
+{
+    if (coordsBuffer.getVertexCount() == 0)
+        return;
+
+    coordsBuffer.cache(); // Try to cache
+    drawCoords(static_cast<const CoordsBuffer&>(coordsBuffer), drawMode);
+}
+
+void Painter::drawCoords(const CoordsBuffer& coordsBuffer, DrawMode drawMode)
 {
     const int vertexCount = coordsBuffer.getVertexCount();
     if (vertexCount == 0)
@@ -79,7 +123,34 @@ void Painter::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
     const bool textured = coordsBuffer.getTextureCoordCount() > 0 && m_texture;
 
     // skip drawing of empty textures
-    if (textured && m_texture->isEmpty())
+    if (textured && !canDrawTexture(m_texture))
+        return;
+
+    const int bytes = vertexCount * 2 * sizeof(float);
+
+    VertexRange vertices, texCoords;
+    if (auto* hardwareBuffer = coordsBuffer.getHardwareVertexCache())
+        vertices.buffer = hardwareBuffer;
+    else
+        vertices = streamVertices(coordsBuffer.getVertexArray(), bytes);
+
+    // only set texture coords arrays when needed
+    if (textured) {
+        if (auto* hardwareBuffer = coordsBuffer.getHardwareTextureCoordCache())
+            texCoords.buffer = hardwareBuffer;
+        else
+            texCoords = streamVertices(coordsBuffer.getTextureCoordArray(), bytes);
+    }
+
+    drawCoords(vertices, texCoords, vertexCount, drawMode);
+}
+
+void Painter::drawCoords(const VertexRange& vertices, const VertexRange& texCoords, const int vertexCount, DrawMode drawMode)
+{
+    const bool textured = !texCoords.isNull() && m_texture;
+
+    // skip drawing of empty textures
+    if (textured && !canDrawTexture(m_texture))
         return;
 
     m_drawProgram = m_shaderProgram ? m_shaderProgram : textured ? m_drawTexturedProgram.get() : m_drawSolidColorProgram.get();
@@ -97,31 +168,23 @@ void Painter::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
     m_drawProgram->setResolution(m_resolution);
     m_drawProgram->updateTime();
 
-    coordsBuffer.cache(); // Try to cache
-
-    // only set texture coords arrays when needed
-    {
-        if (textured) {
-            auto* hardwareBuffer = coordsBuffer.getHardwareTextureCoordCache();
-            if (hardwareBuffer)
-                hardwareBuffer->bind();
-
-            m_drawProgram->setAttributeArray(PainterShaderProgram::TEXCOORD_ATTR, hardwareBuffer ? nullptr : coordsBuffer.getTextureCoordArray(), 2);
-        } else
-            PainterShaderProgram::disableAttributeArray(PainterShaderProgram::TEXCOORD_ATTR);
-    }
+    // with a buffer bound the pointer is an offset into it
+    const auto setArray = [this](const int attr, const VertexRange& range) {
+        if (range.buffer)
+            range.buffer->bind();
+        else
+            HardwareBuffer::unbind(HardwareBuffer::Type::VERTEX_BUFFER);
 
-    // set vertex array
-    {
-        auto* hardwareBuffer = coordsBuffer.getHardwareVertexCache();
-        if (hardwareBuffer)
-            hardwareBuffer->bind();
+        m_drawProgram->setAttributeArray(attr, range.data, 2);
+    };
 
-        m_drawProgram->setAttributeArray(PainterShaderProgram::VERTEX_ATTR, hardwareBuffer ? nullptr : coordsBuffer.getVertexArray(), 2);
-    }
+    if (textured)
+        setArray(PainterShaderProgram::TEXCOORD_ATTR, texCoords);
+    else
+        PainterShaderProgram::disableAttributeArray(PainterShaderProgram::TEXCOORD_ATTR);
 
-    if (coordsBuffer.isCached())
-        HardwareBuffer::unbind(HardwareBuffer::Type::VERTEX_BUFFER);
+    setArray(PainterShaderProgram::VERTEX_ATTR, vertices);
+    HardwareBuffer::unbind(HardwareBuffer::Type::VERTEX_BUFFER);
 
     // draw the element in coords buffers
     glDrawArrays(static_cast<GLenum>(drawMode), 0, vertexCount);
@@ -130,6 +193,65 @@ void Painter::drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode)
         PainterShaderProgram::enableAttributeArray(PainterShaderProgram::TEXCOORD_ATTR);
 }
 
+Painter::VertexRange Painter::streamVertices(const void* data, const int bytes)
+{
+    intptr_t offset;
+    if (!isStreamingVertices() || !m_streamBuffer.write(data, bytes, offset))
+        return { nullptr, static_cast<const float*>(data) };
+
+    return { m_streamBuffer.getBuffer(), reinterpret_cast<const float*>(offset) };
+}
+
+void Painter::drawInstancedRects(const VertexRange& instances, const int count)
+{
+#ifndef OPENGL_ES
+    if (count == 0 || !m_texture || !canDrawTexture(m_texture))
+        return;
+
+    m_drawProgram = m_drawInstancedProgram.get();
+
+    m_drawProgram->bind();
+    m_drawProgram->setTransformMatrix(m_transformMatrix);
+    m_drawProgram->setProjectionMatrix(m_projectionMatrix);
+    m_drawProgram->setTextureMatrix(m_textureMatrix);
+    m_drawProgram->setOpacity(m_opacity);
+    m_drawProgram->setColor(m_color);
+    m_drawProgram->setResolution(m_resolution);
+
+    m_quadBuffer->bind();
+    m_drawProgram->setAttributeArray(PainterShaderProgram::VERTEX_ATTR, nullptr, 2);
+    PainterShaderProgram::disableAttributeArray(PainterShaderProgram::TEXCOORD_ATTR);
+
+    // with a buffer bound the pointer is an offset into it
+    if (instances.buffer)
+        instances.buffer->bind();
+    else
+        HardwareBuffer::unbind(HardwareBuffer::Type::VERTEX_BUFFER);
+
+    const auto* const base = reinterpret_cast<const uint8_t*>(instances.data);
+    constexpr int stride = sizeof(RectInstance);
+    for (const int attr : { PainterShaderProgram::INSTANCE_DEST_ATTR, PainterShaderProgram::INSTANCE_SRC_ATTR }) {
+        PainterShaderProgram::enableAttributeArray(attr);
+        if (m_instancingArb) glVertexAttribDivisorARB(attr, 1);
+        else glVertexAttribDivisor(attr, 1);
+    }
+    m_drawProgram->setAttributeArray(PainterShaderProgram::INSTANCE_DEST_ATTR, reinterpret_cast<const float*>(base + offsetof(RectInstance, dest)), 4, stride);
+    m_drawProgram->setAttributeArray(PainterShaderProgram::INSTANCE_SRC_ATTR, reinterpret_cast<const float*>(base + offsetof(RectInstance, src)), 4, stride);
+
+    if (m_instancingArb) glDrawArraysInstancedARB(GL_TRIANGLE_STRIP, 0, 4, count);
+    else glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+
+    for (const int attr : { PainterShaderProgram::INSTANCE_DEST_ATTR, PainterShaderProgram::INSTANCE_SRC_ATTR }) {
+        if (m_instancingArb) glVertexAttribDivisorARB(attr, 0);
+        else glVertexAttribDivisor(attr, 0);
+        PainterShaderProgram::disableAttributeArray(attr);
+    }
+
+    HardwareBuffer::unbind(HardwareBuffer::Type::VERTEX_BUFFER);
+    PainterShaderProgram::enableAttributeArray(PainterShaderProgram::TEXCOORD_ATTR);
+#endif
+}
+
 void Painter::resetState()
 {
     resetColor();
@@ -24,6 +24,7 @@
 
 #include <framework/graphics/coordsbuffer.h>
 #include <framework/graphics/declarations.h>
+#include <framework/graphics/hardwarebuffer.h>
 #include <framework/graphics/paintershaderprogram.h>
 
 enum class BlendEquation
@@ -57,15 +58,51 @@ class Painter
 public:
     Painter();
 
-    ~Painter() = default;
+    virtual ~Painter() = default;
 
-    void bind();
-    void unbind();
+    virtual void bind();
+    virtual void unbind();
 
-    void clear(const Color& color);
-    void clearRect(const Color& color, const Rect& rect);
+    virtual void clear(const Color& color);
+    virtual void clearRect(const Color& color, const Rect& rect);
 
     void drawCoords(CoordsBuffer& coordsBuffer, DrawMode drawMode = DrawMode::TRIANGLES);
+    // draws the coords as they are, without trying to cache them first
+    void drawCoords(const CoordsBuffer& coordsBuffer, DrawMode drawMode = DrawMode::TRIANGLES);
+
+    // where the attribute of a draw is read from, an offset into the buffer or a client array without one
+    struct VertexRange
+    {
+        HardwareBuffer* buffer{ nullptr };
+        const float* data{ nullptr };
+
+        bool isNull() const { return !buffer && !data; }
+    };
+
+    // draws vertices already placed, texCoords is null for untextured draws
+    virtual void drawCoords(const VertexRange& vertices, const VertexRange& texCoords, int vertexCount, DrawMode drawMode);
+
+    // coords without a hardware cache are copied into the stream buffer before drawing,
+    // when disabled or unsupported they are read from client memory as before
+    void setStreamingVertices(bool enable) { m_streamingVertices = enable; }
+    bool isStreamingVertices() { return m_streamingVertices && m_streamBuffer.isSupported(); }
+    StreamBuffer& getStreamBuffer() { return m_streamBuffer; }
+
+    // copies the data into the stream buffer, the range points to the data itself when it is not streamed
+    VertexRange streamVertices(const void* data, int bytes);
+
+    // a textured rect that the gpu expands from a static unit quad
+    struct RectInstance
+    {
+        float dest[4]; // x, y, width, height
+        float src[4];
+    };
+
+    // draws count rects placed in instances with the current texture and state in a single call,
+    // with the default textured program only; when unsupported the rects go through drawCoords
+    // instead, which is always the case with OpenGL ES
+    virtual void drawInstancedRects(const VertexRange& instances, int count);
+    bool canDrawInstanced() { return m_instancingSupported; }
 
     void scale(float x, float y);
     void scale(float factor) { scale(factor, factor); }
@@ -121,13 +158,18 @@ public:
     void resetShaderProgram() { setShaderProgram(nullptr); }
 
 protected:
+    // only the state, nothing is created in gl, see NullPainter
+    struct StateOnly {};
+    explicit Painter(StateOnly);
+
     void refreshState();
-    void updateGlTexture();
-    void updateGlCompositionMode();
-    void updateGlBlendEquation();
-    void updateGlClipRect();
-    void updateGlAlphaWriting();
-    void updateGlViewport();
+    virtual bool canDrawTexture(Texture* texture);
+    virtual void updateGlTexture();
+    virtual void updateGlCompositionMode();
+    virtual void updateGlBlendEquation();
+    virtual void updateGlClipRect();
+    virtual void updateGlAlphaWriting();
+    virtual void updateGlViewport();
 
     std::vector<Matrix3> m_transformMatrixStack;
 
@@ -155,6 +197,15 @@ protected:
     PainterShaderProgram* m_drawProgram{ nullptr };
     PainterShaderProgramPtr m_drawTexturedProgram;
     PainterShaderProgramPtr m_drawSolidColorProgram;
+    PainterShaderProgramPtr m_drawInstancedProgram;
+
+    std::unique_ptr<HardwareBuffer> m_quadBuffer;
+
+    StreamBuffer m_streamBuffer;
+
+    bool m_instancingSupported{ false },
+        m_instancingArb{ false }, // only the ARB extensions, not GL 3.3
+        m_streamingVertices{ true };
 };
 
 extern Painter* g_painter;
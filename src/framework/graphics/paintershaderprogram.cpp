@@ -63,6 +63,8 @@ bool PainterShaderProgram::link()
     m_startTime = g_clock.seconds();
     bindAttributeLocation(VERTEX_ATTR, "a_Vertex");
     bindAttributeLocation(TEXCOORD_ATTR, "a_TexCoord");
+    bindAttributeLocation(INSTANCE_DEST_ATTR, "a_InstanceDest");
+    bindAttributeLocation(INSTANCE_SRC_ATTR, "a_InstanceSrc");
     if (ShaderProgram::link()) {
         bind();
         setupUniforms();
@@ -32,6 +32,8 @@ protected:
     {
         VERTEX_ATTR = 0,
         TEXCOORD_ATTR = 1,
+        INSTANCE_DEST_ATTR = 2,
+        INSTANCE_SRC_ATTR = 3,
         PROJECTION_MATRIX_UNIFORM = 0,
         TEXTURE_MATRIX_UNIFORM = 1,
         COLOR_UNIFORM = 2,
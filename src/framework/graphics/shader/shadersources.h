@@ -64,6 +64,22 @@ static constexpr std::string_view glslMainVertexShader = "\n\
         return texture2D(u_Tex0, v_TexCoord) * u_Color;\n\
     }\n",
 
+    // a unit quad corner in a_Vertex, stretched over the destination and source rects of the instance
+    glslInstancedRectVertexShader = "\n\
+    attribute highp vec2 a_Vertex;\n\
+    attribute highp vec4 a_InstanceDest;\n\
+    attribute highp vec4 a_InstanceSrc;\n\
+    uniform highp mat3 u_TransformMatrix;\n\
+    uniform highp mat3 u_ProjectionMatrix;\n\
+    uniform highp mat3 u_TextureMatrix;\n\
+    varying highp vec2 v_TexCoord;\n\
+    void main()\n\
+    {\n\
+        highp vec2 position = a_InstanceDest.xy + a_Vertex * a_InstanceDest.zw;\n\
+        gl_Position = vec4(u_ProjectionMatrix * u_TransformMatrix * vec3(position, 1.0), 1.0);\n\
+        v_TexCoord = (u_TextureMatrix * vec3(a_InstanceSrc.xy + a_Vertex * a_InstanceSrc.zw, 1.0)).xy;\n\
+    }\n",
+
     glslSolidColorFragmentShader = "\n\
     uniform lowp vec4 u_Color;\n\
     lowp vec4 calculatePixel() {\n\
@@ -24,6 +24,7 @@
 #include "framebuffer.h"
 #include "graphics.h"
 #include "image.h"
+#include "texturemanager.h"
 #include <atomic>
 
 #include <framework/core/application.h>
@@ -40,7 +41,7 @@ Texture::Texture(const Size& size) : m_uniqueId(++UID)
     m_id = 0;
     m_time = 0;
 
-    if (!setupSize(size))
+    if (!setupSize(size) || g_graphics.isNullBackend())
         return;
 
     createTexture();
@@ -57,11 +58,15 @@ Texture::Texture(const ImagePtr& image, bool buildMipmaps, bool compress, bool c
     m_canSuperimposed = canSuperimposed;
     m_compress = compress;
     m_buildMipmaps = buildMipmaps;
-    if (load) {
+    if (load && g_graphics.isCurrent()) {
         createTexture();
         uploadPixels(image, m_buildMipmaps, m_compress);
     } else {
+        // without the context (while the render thread owns it) the upload waits for create()
+        if (load)
+            setupSize(image->getSize());
         m_image = image;
+        stageImage();
     }
 }
 
@@ -70,17 +75,120 @@ Texture::~Texture()
 #ifndef NDEBUG
     assert(!g_app.isTerminated());
 #endif
+    g_textures.getUploader().release(m_staged);
+
     // free texture from gl memory
     if (g_graphics.ok() && m_id != 0)
-        glDeleteTextures(1, &m_id);
+        g_graphics.runWhenCurrent([id = m_id] { glDeleteTextures(1, &id); });
+
+    if (m_memoryCategory != MemoryTracker::LAST_CATEGORY)
+        g_memory.remove(m_memoryCategory, m_trackedBytes);
+}
+
+void Texture::setMemoryCategory(MemoryTracker::Category category)
+{
+    if (m_memoryCategory != MemoryTracker::LAST_CATEGORY)
+        g_memory.remove(m_memoryCategory, m_trackedBytes);
+
+    // textures that are not loaded yet still hold their image
+    const Size& size = m_image ? m_image->getSize() : m_size;
+    m_trackedBytes = static_cast<int64_t>(size.area()) * 4;
+    m_memoryCategory = category;
+
+    g_memory.add(m_memoryCategory, m_trackedBytes);
+}
+
+void Texture::setImage(const ImagePtr& image)
+{
+    if (!setupSize(image->getSize()))
+        return;
+
+    g_textures.getUploader().release(m_staged);
+    m_image = image;
+    if (m_memoryCategory != MemoryTracker::LAST_CATEGORY)
+        setMemoryCategory(m_memoryCategory);
+
+    stageImage();
+}
+
+void Texture::updateImage(const ImagePtr& image)
+{
+    // the caller keeps changing the image until the upload, it is not staged
+    g_textures.getUploader().release(m_staged);
+    m_image = image;
+}
+
+void Texture::stageImage()
+{
+    // compressed images and other formats take the usual upload
+    if (m_compress || m_image->getBpp() != 4 || !setupSize(m_image->getSize()))
+        return;
+
+    int bytes = 0;
+    uint8_t levels = 0;
+    for (Size size = m_glSize;; size = Size(std::max<int>(size.width() / 2, 1), std::max<int>(size.height() / 2, 1))) {
+        bytes += size.area() * 4;
+        ++levels;
+        if (!m_buildMipmaps || size == Size(1, 1))
+            break;
+    }
+
+    uint8_t* data = g_textures.getUploader().stage(bytes, m_staged);
+    if (!data)
+        return;
+
+    // the mipmaps are built on a copy, like uploadPixels the image is padded to the gl size
+    ImagePtr glImage = m_image;
+    if (m_size != m_glSize || m_buildMipmaps) {
+        glImage = ImagePtr(new Image(m_glSize, 4));
+        glImage->paste(m_image);
+    }
+
+    do {
+        const int levelBytes = glImage->getPixelCount() * 4;
+        std::memcpy(data, glImage->getPixelData(), levelBytes);
+        data += levelBytes;
+    } while (m_buildMipmaps && glImage->nextMipmap());
+
+    m_staged.levels = levels;
+    m_opaque = !m_image->hasTransparentPixel();
+    m_image = nullptr;
 }
 
 void Texture::create()
 {
-    if (m_image) {
+    // the null graphics backend has no context, the pixels are dropped as if uploaded
+    if (g_graphics.isNullBackend()) {
+        g_textures.getUploader().release(m_staged);
+        m_image = nullptr;
+        m_paramsChanged = false;
+        return;
+    }
+
+    if (m_image || m_staged.offset != -1) {
+        // the rest waits for the next frames once the frame budget is spent
+        if (!g_textures.canUpload())
+            return;
+
+        const ticks_t start = stdext::micros();
         createTexture();
-        uploadPixels(m_image, m_buildMipmaps, m_compress);
+        if (m_staged.offset != -1) {
+            bind();
+            m_hasMipmaps = m_buildMipmaps;
+            g_textures.getUploader().uploadStaged(m_staged, m_glSize);
+            setupWrap();
+            setupFilters();
+        } else
+            uploadPixels(m_image, m_buildMipmaps, m_compress);
+        g_textures.addUpload(m_glSize.area() * 4, stdext::micros() - start);
+
         m_image = nullptr;
+        m_paramsChanged = false;
+    } else if (m_paramsChanged && m_id != 0) {
+        bind();
+        setupWrap();
+        setupFilters();
+        m_paramsChanged = false;
     }
 }
 
@@ -145,6 +253,11 @@ void Texture::setSmooth(bool smooth)
         return;
 
     m_smooth = smooth;
+    if (!g_graphics.isCurrent() || m_id == 0) {
+        m_paramsChanged = true;
+        return;
+    }
+
     bind();
     setupFilters();
 }
@@ -155,6 +268,11 @@ void Texture::setRepeat(bool repeat)
         return;
 
     m_repeat = repeat;
+    if (!g_graphics.isCurrent() || m_id == 0) {
+        m_paramsChanged = true;
+        return;
+    }
+
     bind();
     setupWrap();
 }
@@ -260,5 +378,11 @@ void Texture::setupPixels(int level, const Size& size, uint8_t* pixels, int chan
         internalFormat = GL_COMPRESSED_RGBA;
 #endif
 
-    glTexImage2D(GL_TEXTURE_2D, level, internalFormat, size.width(), size.height(), 0, format, GL_UNSIGNED_BYTE, pixels);
+    // storage only allocations and compressed images skip the streaming path
+    if (!pixels || internalFormat != GL_RGBA) {
+        glTexImage2D(GL_TEXTURE_2D, level, internalFormat, size.width(), size.height(), 0, format, GL_UNSIGNED_BYTE, pixels);
+        return;
+    }
+
+    g_textures.getUploader().upload(level, internalFormat, size, format, pixels, size.area() * channels);
 }
@@ -23,6 +23,8 @@
 #pragma once
 
 #include "declarations.h"
+#include "textureuploader.h"
+#include <framework/core/memorytracker.h>
 
 class Texture : public stdext::shared_object
 {
@@ -33,7 +35,9 @@ public:
     ~Texture() override;
 
     void uploadPixels(const ImagePtr& image, bool buildMipmaps = false, bool compress = false);
-    void updateImage(const ImagePtr& image) { m_image = image; }
+    void updateImage(const ImagePtr& image);
+    // resizes to the image, which is uploaded by the next create()
+    void setImage(const ImagePtr& image);
     void bind();
     void copyFromScreen(const Rect& screenRect);
     virtual bool buildHardwareMipmaps();
@@ -43,6 +47,9 @@ public:
     void setUpsideDown(bool upsideDown);
     void setTime(ticks_t time) { m_time = time; }
 
+    // accounts the texture pixels in the memory tracker until the texture is destroyed
+    void setMemoryCategory(MemoryTracker::Category category);
+
     uint32_t getId() { return m_id; }
     uint32_t getUniqueId() const { return m_uniqueId; }
     ticks_t getTime() { return m_time; }
@@ -58,7 +65,10 @@ public:
     bool isOpaque() const { return m_opaque; }
     bool canSuperimposed() const { return m_canSuperimposed; }
 
-    void create();
+    // uploads the pending image and parameters, see DrawPoolManager::swap
+    virtual void create();
+    // the image is still waiting for create(), it was deferred by the upload budget
+    virtual bool isUploadPending() { return m_image || m_staged.offset != -1; }
 
 protected:
     void createTexture();
@@ -67,6 +77,8 @@ protected:
     void setupFilters();
     void setupTranformMatrix();
     void setupPixels(int level, const Size& size, uint8_t* pixels, int channels = 4, bool compress = false);
+    // copies the pending image ahead into the staging buffer of the uploader, see TextureUploader::stage
+    void stageImage();
 
     const uint32_t m_uniqueId;
 
@@ -77,6 +89,10 @@ protected:
     Matrix3 m_transformMatrix;
 
     ImagePtr m_image;
+    TextureUploader::Staged m_staged; // the pending image once it was staged
+
+    int64_t m_trackedBytes{ 0 };
+    MemoryTracker::Category m_memoryCategory{ MemoryTracker::LAST_CATEGORY };
 
     bool m_hasMipmaps{ false },
         m_smooth{ false },
@@ -85,5 +101,6 @@ protected:
         m_opaque{ false },
         m_canSuperimposed{ false },
         m_compress{ false },
-        m_buildMipmaps{ false };
+        m_buildMipmaps{ false },
+        m_paramsChanged{ false };
 };
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "textureatlas.h"
+#include "graphics.h"
+#include "image.h"
+#include "texturemanager.h"
+
+TextureAtlas g_atlas;
+
+namespace
+{
+    // texels of clamped border around every image, filtering and shaders sampling just past the
+    // edge of an image read its own edge instead of the neighbour's, as with a texture of its own
+    constexpr int PADDING = 1;
+
+    ImagePtr padImage(const ImagePtr& image)
+    {
+        const Size& size = image->getSize();
+        const ImagePtr padded(new Image(size + Size(PADDING * 2), 4));
+
+        const int rowBytes = size.width() * 4;
+        for (int y = -PADDING; y < size.height() + PADDING; ++y) {
+            const int srcY = std::clamp<int>(y, 0, size.height() - 1);
+            uint8_t* row = padded->getPixel(PADDING, y + PADDING);
+            std::memcpy(row, image->getPixel(0, srcY), rowBytes);
+
+            for (int x = 0; x < PADDING; ++x) {
+                std::memcpy(row - (x + 1) * 4, row, 4);
+                std::memcpy(row + rowBytes + x * 4, row + rowBytes - 4, 4);
+            }
+        }
+
+        padded->setTransparentPixel(image->hasTransparentPixel());
+        return padded;
+    }
+}
+
+// the pixels of a page are blitted when the frame using it is swapped, on the thread owning the context
+class TextureAtlas::Page : public Texture
+{
+public:
+    Page(const Size& size)
+    {
+        setupSize(size);
+        setMemoryCategory(MemoryTracker::THING_TEXTURES);
+    }
+
+    void blit(const Point& pos, const ImagePtr& image) { m_blits.emplace_back(pos, image); }
+    void clearBlits() { m_blits.clear(); }
+
+    void create() override
+    {
+        if (g_graphics.isNullBackend()) {
+            m_blits.clear();
+            return;
+        }
+
+        if (m_id == 0) {
+            createTexture();
+            bind();
+            setupPixels(0, m_glSize, nullptr, 4);
+            setupWrap();
+            setupFilters();
+        }
+
+        if (m_blits.empty())
+            return;
+
+        // the drawings of this frame need every blit, so the upload budget is only accounted
+        const ticks_t start = stdext::micros();
+        int bytes = 0;
+
+        bind();
+        for (const auto& [pos, image] : m_blits) {
+            const int size = image->getPixelCount() * 4;
+            g_textures.getUploader().uploadRegion(pos, image->getSize(), GL_RGBA, image->getPixelData(), size);
+            bytes += size;
+        }
+        m_blits.clear();
+
+        g_textures.addUpload(bytes, stdext::micros() - start);
+    }
+
+private:
+    std::vector<std::pair<Point, ImagePtr>> m_blits;
+};
+
+void TextureAtlas::init()
+{
+    m_pageSize = std::min<int>(2048, g_graphics.getMaxTextureSize());
+}
+
+void TextureAtlas::terminate()
+{
+    m_pages.clear();
+}
+
+TexturePtr TextureAtlas::add(const ImagePtr& image, Region& region)
+{
+    const Size size = image->getSize() + Size(PADDING * 2);
+    if (!m_enabled || image->getBpp() != 4 || image->getPixelCount() == 0 || size.width() > m_pageSize / 2 || size.height() > m_pageSize / 2)
+        return nullptr;
+
+    int index = -1;
+    Point origin;
+    for (size_t i = 0; i < m_pages.size(); ++i) {
+        if (pack(m_pages[i], size, origin)) {
+            index = i;
+            break;
+        }
+    }
+
+    if (index == -1 && m_pages.size() < static_cast<size_t>(m_maxPages)) {
+        auto& page = m_pages.emplace_back();
+        page.texture = PagePtr(new Page(Size(m_pageSize)));
+        page.generation = ++m_generation;
+        if (pack(page, size, origin))
+            index = m_pages.size() - 1;
+    }
+
+    if (index == -1) {
+        // the pages used by the frame being recorded must keep their pixels
+        PageInfo* lru = nullptr;
+        for (auto& page : m_pages) {
+            if (page.lastUsed < m_frame && (!lru || page.lastUsed < lru->lastUsed))
+                lru = &page;
+        }
+
+        if (lru) {
+            reset(*lru);
+            ++m_evictions;
+            if (pack(*lru, size, origin))
+                index = lru - m_pages.data();
+        }
+    }
+
+    if (index == -1) {
+        ++m_misses;
+        return nullptr;
+    }
+
+    auto& page = m_pages[index];
+    page.texture->blit(origin, padImage(image));
+    page.lastUsed = m_frame;
+    ++page.regions;
+
+    region = { static_cast<int16_t>(index), page.generation, origin + Point(PADDING) };
+    return page.texture;
+}
+
+bool TextureAtlas::touch(const Region& region)
+{
+    if (region.page < 0 || static_cast<size_t>(region.page) >= m_pages.size())
+        return false;
+
+    auto& page = m_pages[region.page];
+    if (page.generation != region.generation)
+        return false;
+
+    page.lastUsed = m_frame;
+    return true;
+}
+
+void TextureAtlas::clear()
+{
+    m_pages.clear();
+}
+
+bool TextureAtlas::pack(PageInfo& page, const Size& size, Point& origin)
+{
+    Shelf* best = nullptr;
+    for (auto& shelf : page.shelves) {
+        if (shelf.height < size.height() || m_pageSize - shelf.x < size.width())
+            continue;
+
+        if (!best || shelf.height < best->height)
+            best = &shelf;
+    }
+
+    // a shelf twice as tall wastes more than opening a new one, while there is room for it
+    if (best && best->height >= size.height() * 2 && page.top + size.height() <= m_pageSize)
+        best = nullptr;
+
+    if (!best) {
+        if (page.top + size.height() > m_pageSize)
+            return false;
+
+        best = &page.shelves.emplace_back(Shelf{ page.top, size.height(), 0 });
+        page.top += size.height();
+    }
+
+    origin = Point(best->x, best->y);
+    best->x += size.width();
+    return true;
+}
+
+void TextureAtlas::reset(PageInfo& page)
+{
+    page.generation = ++m_generation;
+    page.shelves.clear();
+    page.top = 0;
+    page.regions = 0;
+    page.texture->clearBlits();
+}
+
+std::map<std::string, int> TextureAtlas::getStats()
+{
+    int regions = 0;
+    for (const auto& page : m_pages)
+        regions += page.regions;
+
+    return {
+        { "pages", static_cast<int>(m_pages.size()) },
+        { "maxPages", m_maxPages },
+        { "pageSize", m_pageSize },
+        { "regions", regions },
+        { "evictions", m_evictions },
+        { "misses", m_misses }
+    };
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "texture.h"
+
+/**
+ * Packs small images into a few large textures, so drawings of different images on the same
+ * page share the texture state and can be batched by the DrawPool.
+ *
+ * Pages are filled with shelves: an image goes on the shelf where it wastes the least height,
+ * or opens a new one below. When every page is full the least recently used page, one that is
+ * not referenced by the frame being recorded, is emptied and its owners pack their images again
+ * the next time they are drawn. Regions hold the generation of their page, so the owners find
+ * out about the eviction through touch().
+ *
+ * Every image is packed with a border of a texel repeating its edge, so sampling just outside
+ * of it gives the same result as its own clamped texture would.
+ *
+ * Pixels are kept by the page until the frame using it is swapped, see DrawPoolManager::swap.
+ */
+class TextureAtlas
+{
+public:
+    struct Region
+    {
+        int16_t page{ -1 };
+        uint32_t generation{ 0 };
+        Point origin; // top left of the image in the page
+
+        bool isNull() const { return page == -1; }
+    };
+
+    void init();
+    void terminate();
+
+    // only decides where the next images go, clear() drops the ones already packed
+    void setEnabled(bool enable) { m_enabled = enable; }
+    bool isEnabled() { return m_enabled; }
+
+    // pages are created on demand up to this count, see getPageSize
+    void setMaxPages(int pages) { m_maxPages = std::max<int>(pages, 1); }
+    int getMaxPages() { return m_maxPages; }
+    int getPageSize() { return m_pageSize; }
+
+    // places the image and returns its page, nothing when it is too big or every page is in use
+    TexturePtr add(const ImagePtr& image, Region& region);
+
+    // whether the region still holds its image, also marks its page as used by this frame
+    bool touch(const Region& region);
+
+    // called once per frame, see DrawPoolManager::swap
+    void nextFrame() { ++m_frame; }
+
+    // drops every page, the owners pack their images again
+    void clear();
+
+    std::map<std::string, int> getStats();
+
+private:
+    class Page;
+    using PagePtr = stdext::shared_object_ptr<Page>;
+
+    struct Shelf
+    {
+        int y, height, x;
+    };
+
+    struct PageInfo
+    {
+        PagePtr texture;
+        std::vector<Shelf> shelves;
+        int top{ 0 }, regions{ 0 };
+        uint32_t generation{ 0 };
+        uint64_t lastUsed{ 0 };
+    };
+
+    bool pack(PageInfo& page, const Size& size, Point& origin);
+    void reset(PageInfo& page);
+
+    std::vector<PageInfo> m_pages;
+
+    int m_pageSize{ 2048 },
+        m_maxPages{ 4 },
+        m_evictions{ 0 },
+        m_misses{ 0 };
+
+    uint32_t m_generation{ 0 };
+    uint64_t m_frame{ 1 };
+    bool m_enabled{ true };
+};
+
+extern TextureAtlas g_atlas;
@@ -25,6 +25,7 @@
 #include "graphics.h"
 #include "image.h"
 
+#include <framework/core/asyncdispatcher.h>
 #include <framework/core/clock.h>
 #include <framework/core/eventdispatcher.h>
 #include <framework/core/resourcemanager.h>
@@ -32,9 +33,23 @@
 
 TextureManager g_textures;
 
+struct TextureManager::DecodedTexture
+{
+    ~DecodedTexture()
+    {
+        if (loaded)
+            free_apng(&apng);
+    }
+
+    apng_data apng{};
+    bool loaded{ false };
+    std::string error;
+};
+
 void TextureManager::init()
 {
     m_emptyTexture = TexturePtr(new Texture);
+    m_uploader.init();
 }
 
 void TextureManager::terminate()
@@ -43,13 +58,36 @@ void TextureManager::terminate()
         m_liveReloadEvent->cancel();
         m_liveReloadEvent = nullptr;
     }
+    m_prefetches.clear();
     m_textures.clear();
     m_animatedTextures.clear();
     m_emptyTexture = nullptr;
+    m_uploader.terminate();
+}
+
+std::map<std::string, int> TextureManager::getUploadStats()
+{
+    const auto& stats = m_uploader.getStats();
+    return {
+        { "uploads", stats.uploads },
+        { "bytes", stats.bytes },
+        { "orphans", stats.orphans },
+        { "stallMicros", stats.stallMicros }
+    };
 }
 
 void TextureManager::poll()
 {
+    for (auto it = m_prefetches.begin(); it != m_prefetches.end();) {
+        if (it->decoded.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+
+        finishPrefetch(*it);
+        it = m_prefetches.erase(it);
+    }
+
     // update only every 16msec, this allows upto 60 fps for animated textures
     static ticks_t lastUpdate = 0;
     const ticks_t now = g_clock.millis();
@@ -63,6 +101,7 @@ void TextureManager::poll()
 
 void TextureManager::clearCache()
 {
+    m_prefetches.clear();
     m_animatedTextures.clear();
     m_textures.clear();
 }
@@ -94,6 +133,10 @@ TexturePtr TextureManager::getTexture(const std::string& fileName)
     // before must resolve filename to full path
     const auto& filePath = g_resources.resolvePath(fileName);
 
+    // a texture being prefetched is only handed out once decoded
+    if (!m_prefetches.empty())
+        waitPrefetch(filePath);
+
     // check if the texture is already loaded
     const auto it = m_textures.find(filePath);
     if (it != m_textures.end()) {
@@ -103,12 +146,7 @@ TexturePtr TextureManager::getTexture(const std::string& fileName)
     // texture not found, load it
     if (!texture) {
         try {
-            const auto& filePathEx = g_resources.guessFilePath(filePath, "png");
-
-            // load texture file data
-            std::stringstream fin;
-            g_resources.readFileStream(filePathEx, fin);
-            texture = loadTexture(fin);
+            texture = loadTexture(decodeTexture(filePath));
         } catch (stdext::exception& e) {
             g_logger.error(stdext::format("Unable to load texture '%s': %s", fileName, e.what()));
             texture = g_textures.getEmptyTexture();
@@ -117,6 +155,7 @@ TexturePtr TextureManager::getTexture(const std::string& fileName)
         if (texture) {
             texture->setTime(stdext::time());
             texture->setSmooth(true);
+            texture->setMemoryCategory(MemoryTracker::TEXTURES);
             m_textures[filePath] = texture;
         }
     }
@@ -124,12 +163,103 @@ TexturePtr TextureManager::getTexture(const std::string& fileName)
     return texture;
 }
 
-TexturePtr TextureManager::loadTexture(std::stringstream& file)
+TexturePtr TextureManager::getTextureAsync(const std::string& fileName)
+{
+    const auto& filePath = g_resources.resolvePath(fileName);
+
+    const auto it = m_textures.find(filePath);
+    if (it != m_textures.end())
+        return it->second;
+
+    if (g_asyncDispatcher.getWorkerCount() == 0)
+        return getTexture(fileName);
+
+    // placeholder, finishPrefetch gives it the decoded image
+    const TexturePtr texture(new Texture);
+    texture->setTime(stdext::time());
+    texture->setSmooth(true);
+    texture->setMemoryCategory(MemoryTracker::TEXTURES);
+    m_textures[filePath] = texture;
+
+    m_prefetches.push_back({ filePath, texture, g_asyncDispatcher.schedule([filePath]() -> DecodedTexturePtr {
+        try {
+            return decodeTexture(filePath);
+        } catch (const std::exception& e) {
+            const auto decoded = std::make_shared<DecodedTexture>();
+            decoded->error = e.what();
+            return decoded;
+        }
+    }) });
+
+    return texture;
+}
+
+void TextureManager::waitPrefetch(const std::string& filePath)
+{
+    const auto it = std::find_if(m_prefetches.begin(), m_prefetches.end(), [&filePath](const Prefetch& prefetch) { return prefetch.filePath == filePath; });
+    if (it == m_prefetches.end())
+        return;
+
+    it->decoded.wait();
+
+    const Prefetch prefetch = std::move(*it);
+    m_prefetches.erase(it);
+    finishPrefetch(prefetch);
+}
+
+void TextureManager::finishPrefetch(const Prefetch& prefetch)
+{
+    DecodedTexturePtr decoded;
+    try {
+        decoded = prefetch.decoded.get();
+    } catch (const std::future_error&) {
+        // the workers stopped before running it
+        return;
+    }
+
+    if (!decoded->error.empty()) {
+        g_logger.error(stdext::format("Unable to load texture '%s': %s", prefetch.filePath, decoded->error));
+        return;
+    }
+
+    // like getTexture, files that fail to decode are not cached
+    if (!decoded->loaded) {
+        m_textures.erase(prefetch.filePath);
+        return;
+    }
+
+    const apng_data& apng = decoded->apng;
+    const Size imageSize(apng.width, apng.height);
+    uint8_t* firstFrame = apng.pdata + apng.first_frame * imageSize.area() * apng.bpp;
+    prefetch.texture->setImage(ImagePtr(new Image(imageSize, apng.bpp, firstFrame)));
+
+    // the cache gets the animated texture, the placeholder keeps the first frame
+    if (apng.num_frames > 1) {
+        const TexturePtr texture = loadTexture(decoded);
+        texture->setTime(stdext::time());
+        texture->setSmooth(true);
+        texture->setMemoryCategory(MemoryTracker::TEXTURES);
+        m_textures[prefetch.filePath] = texture;
+    }
+}
+
+TextureManager::DecodedTexturePtr TextureManager::decodeTexture(const std::string& filePath)
+{
+    // takes resolved paths only, so it can run on the workers
+    std::stringstream fin;
+    g_resources.readFileStream(g_resources.guessFilePath(filePath, "png"), fin);
+
+    const auto decoded = std::make_shared<DecodedTexture>();
+    decoded->loaded = load_apng(fin, &decoded->apng) == 0;
+    return decoded;
+}
+
+TexturePtr TextureManager::loadTexture(const DecodedTexturePtr& decoded)
 {
     TexturePtr texture;
 
-    apng_data apng;
-    if (load_apng(file, &apng) == 0) {
+    if (decoded->loaded) {
+        const apng_data& apng = decoded->apng;
         const Size imageSize(apng.width, apng.height);
         if (apng.num_frames > 1) { // animated texture
             std::vector<ImagePtr> frames;
@@ -148,7 +278,6 @@ TexturePtr TextureManager::loadTexture(std::stringstream& file)
             const auto image = ImagePtr(new Image(imageSize, apng.bpp, apng.pdata));
             texture = TexturePtr(new Texture(image));
         }
-        free_apng(&apng);
     }
 
     return texture;
@@ -23,8 +23,11 @@
 #pragma once
 
 #include "texture.h"
+#include "textureuploader.h"
 #include <framework/core/declarations.h>
 
+#include <future>
+
 class TextureManager
 {
 public:
@@ -39,13 +42,54 @@ public:
     TexturePtr getTexture(const std::string& fileName);
     const TexturePtr& getEmptyTexture() { return m_emptyTexture; }
 
+    // reads and decodes the file on a worker and returns a texture that stays empty until the
+    // image is uploaded, getTexture on the same file waits for the decoding instead of redoing it
+    TexturePtr getTextureAsync(const std::string& fileName);
+    void prefetch(const std::string& fileName) { getTextureAsync(fileName); }
+    int getPendingPrefetchCount() { return m_prefetches.size(); }
+
+    // limits the uploads Texture::create does in a frame, the first one of a frame always goes
+    void setUploadBudget(int bytes, int micros) { m_uploadBudget = { bytes, micros }; }
+    bool canUpload() { return m_frameUploads.bytes == 0 || (m_frameUploads.bytes < m_uploadBudget.bytes && m_frameUploads.micros < m_uploadBudget.micros); }
+    void addUpload(int bytes, int micros) { m_frameUploads.bytes += bytes; m_frameUploads.micros += micros; }
+    void resetUploads() { m_frameUploads = {}; m_uploader.nextFrame(); }
+
+    TextureUploader& getUploader() { return m_uploader; }
+    void setStreamingUploads(bool enable) { m_uploader.setStreaming(enable); }
+    bool isStreamingUploads() { return m_uploader.isStreaming(); }
+    std::map<std::string, int> getUploadStats();
+
 private:
-    TexturePtr loadTexture(std::stringstream& file);
+    struct DecodedTexture;
+    using DecodedTexturePtr = std::shared_ptr<DecodedTexture>;
+
+    struct Prefetch
+    {
+        std::string filePath;
+        TexturePtr texture;
+        std::shared_future<DecodedTexturePtr> decoded;
+    };
+
+    struct Uploads
+    {
+        int bytes{ 0 };
+        int micros{ 0 };
+    };
+
+    static DecodedTexturePtr decodeTexture(const std::string& filePath);
+    TexturePtr loadTexture(const DecodedTexturePtr& decoded);
+    void finishPrefetch(const Prefetch& prefetch);
+    void waitPrefetch(const std::string& filePath);
 
     stdext::map<std::string, TexturePtr> m_textures;
     std::vector<AnimatedTexturePtr> m_animatedTextures;
     TexturePtr m_emptyTexture;
     ScheduledEventPtr m_liveReloadEvent;
+
+    std::vector<Prefetch> m_prefetches;
+    Uploads m_uploadBudget{ 8 * 1024 * 1024, 4000 };
+    Uploads m_frameUploads;
+    TextureUploader m_uploader;
 };
 
 extern TextureManager g_textures;
@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "textureuploader.h"
+#include "graphics.h"
+
+void TextureUploader::init()
+{
+#ifndef OPENGL_ES
+    m_supported = (GLEW_VERSION_2_1 || GLEW_ARB_pixel_buffer_object) && (GLEW_VERSION_3_2 || GLEW_ARB_sync);
+    if (!m_supported)
+        return;
+
+    for (auto& slot : m_slots)
+        slot.buffer = std::make_unique<HardwareBuffer>(HardwareBuffer::Type::PIXEL_UNPACK_BUFFER);
+
+    if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) {
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        m_staging = std::make_unique<HardwareBuffer>(HardwareBuffer::Type::PIXEL_UNPACK_BUFFER);
+        m_staging->bind();
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, STAGING_SIZE, nullptr, flags);
+        m_stagingData = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, STAGING_SIZE, flags));
+        HardwareBuffer::unbind(HardwareBuffer::Type::PIXEL_UNPACK_BUFFER);
+
+        if (!m_stagingData)
+            m_staging = nullptr;
+    }
+#endif
+}
+
+void TextureUploader::terminate()
+{
+#ifndef OPENGL_ES
+    for (auto& slot : m_slots) {
+        if (slot.fence) {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+        slot.buffer = nullptr;
+        slot.capacity = 0;
+    }
+
+    for (auto& region : m_stagingRegions) {
+        if (region.fence)
+            glDeleteSync(region.fence);
+    }
+    m_stagingRegions.clear();
+    m_stagingHead = 0;
+
+    if (m_stagingData) {
+        m_staging->bind();
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        HardwareBuffer::unbind(HardwareBuffer::Type::PIXEL_UNPACK_BUFFER);
+        m_stagingData = nullptr;
+    }
+    m_staging = nullptr;
+#endif
+
+    m_supported = false;
+}
+
+void TextureUploader::upload(int level, GLenum internalFormat, const Size& size, GLenum format, const uint8_t* pixels, int bytes)
+{
+    ++m_stats.uploads;
+    m_stats.bytes += bytes;
+
+    if (!isStreaming()) {
+        // the driver copies the pixels before returning
+        const ticks_t start = stdext::micros();
+        glTexImage2D(GL_TEXTURE_2D, level, internalFormat, size.width(), size.height(), 0, format, GL_UNSIGNED_BYTE, pixels);
+        m_stats.stallMicros += stdext::micros() - start;
+        return;
+    }
+
+#ifndef OPENGL_ES
+    // allocates the level, the pixels come from the buffer
+    glTexImage2D(GL_TEXTURE_2D, level, internalFormat, size.width(), size.height(), 0, format, GL_UNSIGNED_BYTE, nullptr);
+    stream(level, {}, size, format, pixels, bytes);
+#endif
+}
+
+void TextureUploader::uploadRegion(const Point& offset, const Size& size, GLenum format, const uint8_t* pixels, int bytes)
+{
+    ++m_stats.uploads;
+    m_stats.bytes += bytes;
+
+    if (!isStreaming()) {
+        const ticks_t start = stdext::micros();
+        glTexSubImage2D(GL_TEXTURE_2D, 0, offset.x, offset.y, size.width(), size.height(), format, GL_UNSIGNED_BYTE, pixels);
+        m_stats.stallMicros += stdext::micros() - start;
+        return;
+    }
+
+#ifndef OPENGL_ES
+    stream(0, offset, size, format, pixels, bytes);
+#endif
+}
+
+uint8_t* TextureUploader::stage(const int bytes, Staged& staged)
+{
+#ifndef OPENGL_ES
+    if (!m_stagingData || !isStreaming())
+        return nullptr;
+
+    const int size = (bytes + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+
+    if (size > STAGING_SIZE)
+        return nullptr;
+
+    // the free room is after the head and, once it wrapped, before the oldest region;
+    // the head never catches up with that region, so they are only equal when all is free
+    int begin = 0;
+    if (!m_stagingRegions.empty()) {
+        const int tail = m_stagingRegions.front().begin;
+        begin = m_stagingHead;
+
+        bool wrapped = begin < tail;
+        if (!wrapped && begin + size > STAGING_SIZE) {
+            begin = 0;
+            wrapped = true;
+        }
+
+        if (wrapped && begin + size >= tail)
+            return nullptr;
+    }
+
+    m_stagingRegions.push_back({ begin, begin + size });
+    m_stagingHead = begin + size;
+
+    staged.offset = begin;
+    return m_stagingData + begin;
+#else
+    return nullptr;
+#endif
+}
+
+void TextureUploader::uploadStaged(Staged& staged, const Size& size)
+{
+#ifndef OPENGL_ES
+    m_staging->bind();
+
+    // with the buffer bound the pointer is an offset into it
+    Size levelSize = size;
+    intptr_t offset = staged.offset;
+    for (int level = -1; ++level < staged.levels;) {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, levelSize.width(), levelSize.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(offset));
+
+        ++m_stats.uploads;
+        m_stats.bytes += levelSize.area() * 4;
+
+        offset += levelSize.area() * 4;
+        levelSize = Size(std::max<int>(levelSize.width() / 2, 1), std::max<int>(levelSize.height() / 2, 1));
+    }
+
+    HardwareBuffer::unbind(HardwareBuffer::Type::PIXEL_UNPACK_BUFFER);
+
+    for (auto& region : m_stagingRegions) {
+        if (region.begin == staged.offset) {
+            region.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            break;
+        }
+    }
+
+    release(staged);
+#endif
+}
+
+void TextureUploader::release(Staged& staged)
+{
+#ifndef OPENGL_ES
+    if (staged.offset == -1)
+        return;
+
+    for (auto& region : m_stagingRegions) {
+        if (region.begin == staged.offset) {
+            region.released = true;
+            break;
+        }
+    }
+#endif
+
+    staged = {};
+}
+
+void TextureUploader::nextFrame()
+{
+    m_lastStats = m_stats;
+    m_stats = {};
+
+#ifndef OPENGL_ES
+    // frees the regions in order, up to the first one still staged or read by the driver
+    while (!m_stagingRegions.empty()) {
+        auto& region = m_stagingRegions.front();
+        if (!region.released)
+            break;
+
+        if (region.fence) {
+            const GLenum status = glClientWaitSync(region.fence, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED)
+                break;
+
+            glDeleteSync(region.fence);
+        }
+
+        m_stagingRegions.pop_front();
+    }
+#endif
+}
+
+#ifndef OPENGL_ES
+void TextureUploader::stream(int level, const Point& offset, const Size& size, GLenum format, const uint8_t* pixels, int bytes)
+{
+    Slot& slot = m_slots[m_nextSlot];
+    m_nextSlot = (m_nextSlot + 1) % RING_SIZE;
+
+    slot.buffer->bind();
+
+    // the driver may still read the old storage, it is orphaned and the pixels go to a new one
+    const bool busy = !isSlotFree(slot);
+    if (busy || slot.capacity < bytes) {
+        slot.capacity = std::max<int>(bytes, slot.capacity);
+        slot.buffer->write(nullptr, slot.capacity, HardwareBuffer::UsagePattern::STREAM_DRAW);
+        if (busy)
+            ++m_stats.orphans;
+    }
+    glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, bytes, pixels);
+
+    // with the buffer bound the pointer is an offset into it
+    glTexSubImage2D(GL_TEXTURE_2D, level, offset.x, offset.y, size.width(), size.height(), format, GL_UNSIGNED_BYTE, nullptr);
+
+    if (slot.fence)
+        glDeleteSync(slot.fence);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    HardwareBuffer::unbind(HardwareBuffer::Type::PIXEL_UNPACK_BUFFER);
+}
+
+bool TextureUploader::isSlotFree(Slot& slot)
+{
+    if (!slot.fence)
+        return true;
+
+    // only polled, a slot still in use is orphaned instead of waited for
+    const GLenum status = glClientWaitSync(slot.fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        return false;
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    return true;
+}
+#endif
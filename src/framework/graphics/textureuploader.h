@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "declarations.h"
+#include "hardwarebuffer.h"
+
+/**
+ * Streams texture pixels through a ring of pixel unpack buffers.
+ *
+ * The pixels are copied into the next buffer of the ring and glTexSubImage2D sources them
+ * from there, so the call returns before the driver read them. A fence tells when that
+ * transfer ended; it is only polled, a buffer still read is orphaned and the copy goes to
+ * fresh storage instead of waiting. Contexts without pixel buffer objects or sync objects
+ * use a plain glTexImage2D.
+ *
+ * That copy still happens at upload time. With buffer storage, textures whose image is
+ * produced before they are drawn (thing types, prefetched files) copy it ahead into a
+ * persistently mapped staging buffer instead, see stage(). That needs no gl call, so it
+ * also runs while the render thread owns the context, and the upload at the handoff only
+ * issues glTexImage2D from the buffer. A fence frees the space once the driver read it.
+ */
+class TextureUploader
+{
+public:
+    struct Stats
+    {
+        int uploads{ 0 },
+            bytes{ 0 },
+            orphans{ 0 },
+            stallMicros{ 0 };
+    };
+
+    void init();
+    void terminate();
+
+    void setStreaming(bool enable) { m_streaming = enable; }
+    bool isStreaming() { return m_streaming && m_supported; }
+
+    // fills the given level of the bound texture, like glTexImage2D
+    void upload(int level, GLenum internalFormat, const Size& size, GLenum format, const uint8_t* pixels, int bytes);
+    // fills a part of the first level of the bound texture, like glTexSubImage2D
+    void uploadRegion(const Point& offset, const Size& size, GLenum format, const uint8_t* pixels, int bytes);
+
+    // the levels of a texture copied ahead of its upload, offset is -1 when nothing is staged
+    struct Staged
+    {
+        int offset{ -1 };
+        uint8_t levels{ 0 };
+    };
+
+    // reserves room for the given bytes in the staging buffer and returns where to write them,
+    // null without buffer storage or when the buffer is full, the pixels are then uploaded as usual.
+    // main thread only, it does not need the context.
+    uint8_t* stage(int bytes, Staged& staged);
+    // fills the levels of the bound texture, which has the given size, from the staged rgba pixels
+    void uploadStaged(Staged& staged, const Size& size);
+    // gives the room back, once uploadStaged was read by the driver when it ran
+    void release(Staged& staged);
+
+    // called once per frame with the context, see DrawPoolManager::swap
+    void nextFrame();
+    const Stats& getStats() { return m_lastStats; }
+
+private:
+#ifndef OPENGL_ES
+    enum { RING_SIZE = 4, STAGING_SIZE = 32 * 1024 * 1024, STAGING_ALIGNMENT = 16 };
+
+    // a reservation of the staging buffer, they are freed in order
+    struct StagingRegion
+    {
+        int begin, end;
+        GLsync fence{ nullptr };
+        bool released{ false };
+    };
+
+    struct Slot
+    {
+        std::unique_ptr<HardwareBuffer> buffer;
+        GLsync fence{ nullptr };
+        int capacity{ 0 };
+    };
+
+    void stream(int level, const Point& offset, const Size& size, GLenum format, const uint8_t* pixels, int bytes);
+    bool isSlotFree(Slot& slot);
+
+    std::array<Slot, RING_SIZE> m_slots;
+    uint8_t m_nextSlot{ 0 };
+
+    std::unique_ptr<HardwareBuffer> m_staging;
+    uint8_t* m_stagingData{ nullptr };
+    std::deque<StagingRegion> m_stagingRegions;
+    int m_stagingHead{ 0 };
+#endif
+
+    bool m_supported{ false },
+        m_streaming{ true };
+
+    Stats m_stats, m_lastStats;
+};
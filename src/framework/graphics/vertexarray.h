@@ -123,10 +123,10 @@ public:
     int vertexCount() const { return m_buffer.size() / 2; }
     int size() const { return m_buffer.size(); }
 
-    // cache
-    void cache()
+    // cache, returns whether the hardware buffer was written
+    bool cache()
     {
-        if (m_cached || m_buffer.size() < CACHE_MIN_VERTICES_COUNT) return;
+        if (m_cached || m_buffer.size() < CACHE_MIN_VERTICES_COUNT) return false;
 
         if (!m_hardwareBuffer)
             m_hardwareBuffer = new HardwareBuffer(HardwareBuffer::Type::VERTEX_BUFFER);
@@ -135,11 +135,12 @@ public:
         m_hardwareBuffer->write(m_buffer.data(), m_buffer.size() * sizeof(float), HardwareBuffer::UsagePattern::DYNAMIC_DRAW);
 
         m_cached = true;
+        return true;
     }
 
-    bool isCached() { return m_cached; }
+    bool isCached() const { return m_cached; }
 
-    HardwareBuffer* getHardwareCache() { return m_hardwareBuffer; }
+    HardwareBuffer* getHardwareCache() const { return m_hardwareBuffer; }
 
 private:
     bool m_cached{ false };
@@ -23,6 +23,8 @@
 #include "luainterface.h"
 #include "luaobject.h"
 
+#include <framework/core/eventdispatcher.h>
+#include <framework/core/memorytracker.h>
 #include <framework/core/resourcemanager.h>
 
 LuaInterface g_lua;
@@ -54,6 +56,9 @@ void LuaInterface::init()
 
 void LuaInterface::terminate()
 {
+    // suspended coroutines are collected with the state
+    m_readyCoroutines.clear();
+
     // close lua state, it will release all objects
     closeLuaState();
     assert(m_totalFuncRefs == 0);
@@ -453,6 +458,18 @@ int LuaInterface::safeCall(int numArgs, int numRets)
     return rets;
 }
 
+int LuaInterface::profiledCall(int numArgs)
+{
+    // the function source tells which module the time is charged to
+    lua_Debug ar;
+    memset(&ar, 0, sizeof(ar));
+    pushValue(-numArgs - 1);
+    lua_getinfo(L, ">S", &ar);
+
+    const LuaProfiler::Scope scope(g_luaProfiler.getModuleStats(ar.source));
+    return safeCall(numArgs);
+}
+
 int LuaInterface::signalCall(int numArgs, int numRets)
 {
     int rets = 0;
@@ -461,7 +478,7 @@ int LuaInterface::signalCall(int numArgs, int numRets)
     try {
         // must be a function
         if (isFunction(funcIndex)) {
-            rets = safeCall(numArgs);
+            rets = g_luaProfiler.isEnabled() ? profiledCall(numArgs) : safeCall(numArgs);
 
             if (numRets != -1) {
                 if (rets != numRets)
@@ -479,7 +496,7 @@ int LuaInterface::signalCall(int numArgs, int numRets)
                     for (int i = 0; i < numArgs; ++i)
                         pushValue(-numArgs - 2);
 
-                    rets = safeCall(numArgs);
+                    rets = g_luaProfiler.isEnabled() ? profiledCall(numArgs) : safeCall(numArgs);
                     if (rets == 1) {
                         done = popBoolean();
                         if (done) {
@@ -534,37 +551,68 @@ int LuaInterface::newSandboxEnv()
 ///////////////////////////////////////////////////////////////////////////////
 // lua C functions
 
-int LuaInterface::luaScriptLoader(lua_State*)
+namespace
+{
+    // keeps isInCppCallback right when the bound function throws
+    class DepthGuard
+    {
+    public:
+        DepthGuard(int& depth) : m_depth(depth) { ++m_depth; }
+        ~DepthGuard() { --m_depth; }
+
+        DepthGuard(const DepthGuard&) = delete;
+        DepthGuard& operator=(const DepthGuard&) = delete;
+
+    private:
+        int& m_depth;
+    };
+}
+
+LuaInterface::StateGuard::StateGuard(lua_State* state) : m_previous(g_lua.setState(state)) {}
+LuaInterface::StateGuard::~StateGuard() { g_lua.setState(m_previous); }
+
+// lua_error does not return and may skip destructors, the functions below raise it only after their guard is gone
+
+int LuaInterface::luaScriptLoader(lua_State* L)
 {
+    const StateGuard guard(L);
+
     // loads the script as a function
     const auto& fileName = g_lua.popString();
 
     try {
         g_lua.loadScript(fileName);
-        return 1;
     } catch (stdext::exception& e) {
         g_lua.pushString("\n\t"s + e.what());
-        return 1;
     }
+
+    return 1;
 }
 
-int LuaInterface::lua_dofile(lua_State*)
+int LuaInterface::lua_dofile(lua_State* L)
 {
-    const auto& file = g_lua.popString();
+    {
+        const StateGuard guard(L);
 
-    try {
-        g_lua.loadScript(file);
-        g_lua.call(0, LUA_MULTRET);
-        return g_lua.stackSize();
-    } catch (stdext::exception& e) {
-        g_lua.pushString(e.what());
-        g_lua.error();
-        return 0;
+        const auto& file = g_lua.popString();
+
+        try {
+            g_lua.loadScript(file);
+            g_lua.call(0, LUA_MULTRET);
+            return lua_gettop(L);
+        } catch (stdext::exception& e) {
+            g_lua.pushString(e.what());
+        }
     }
+
+    lua_error(L);
+    return 0;
 }
 
-int LuaInterface::lua_dofiles(lua_State*)
+int LuaInterface::lua_dofiles(lua_State* L)
 {
+    const StateGuard guard(L);
+
     std::string contains;
     if (g_lua.getTop() > 2) {
         contains = g_lua.popString();
@@ -581,23 +629,30 @@ int LuaInterface::lua_dofiles(lua_State*)
     return 0;
 }
 
-int LuaInterface::lua_loadfile(lua_State*)
+int LuaInterface::lua_loadfile(lua_State* L)
 {
-    const auto& fileName = g_lua.popString();
+    {
+        const StateGuard guard(L);
 
-    try {
-        g_lua.loadScript(fileName);
-        return 1;
-    } catch (stdext::exception& e) {
-        g_lua.pushNil();
-        g_lua.pushString(e.what());
-        g_lua.error();
-        return 2;
+        const auto& fileName = g_lua.popString();
+
+        try {
+            g_lua.loadScript(fileName);
+            return 1;
+        } catch (stdext::exception& e) {
+            g_lua.pushNil();
+            g_lua.pushString(e.what());
+        }
     }
+
+    lua_error(L);
+    return 2;
 }
 
-int LuaInterface::luaErrorHandler(lua_State*)
+int LuaInterface::luaErrorHandler(lua_State* L)
 {
+    const StateGuard guard(L);
+
     // pops the error message
     auto error = g_lua.popString();
 
@@ -607,41 +662,119 @@ int LuaInterface::luaErrorHandler(lua_State*)
 
     // pushes the new error message with traceback information
     g_lua.pushString(error);
+
     return 1;
 }
 
-int LuaInterface::luaCppFunctionCallback(lua_State*)
+int LuaInterface::luaCppFunctionCallback(lua_State* L)
 {
-    // retrieves function pointer from userdata
-    const auto* const funcPtr = static_cast<LuaCppFunctionPtr*>(g_lua.popUpvalueUserdata());
-    assert(funcPtr);
+    {
+        // bound functions may be called from a coroutine, they must use its stack
+        const StateGuard guard(L);
 
-    int numRets = 0;
+        // retrieves function pointer from userdata
+        const auto* const funcPtr = static_cast<LuaCppFunctionPtr*>(g_lua.popUpvalueUserdata());
+        assert(funcPtr);
 
-    // do the call
-    try {
-        ++g_lua.m_cppCallbackDepth;
-        numRets = (*(funcPtr->get()))(&g_lua);
-        --g_lua.m_cppCallbackDepth;
-        assert(numRets == g_lua.stackSize());
-    } catch (stdext::exception& e) {
-        // cleanup stack
-        while (g_lua.stackSize() > 0)
-            g_lua.pop();
-        numRets = 0;
-        g_lua.pushString(stdext::format("C++ call failed: %s", g_lua.traceback(e.what())));
-        g_lua.error();
+        // do the call
+        try {
+            int numRets;
+            {
+                const DepthGuard depth(g_lua.m_cppCallbackDepth);
+                numRets = (*(funcPtr->get()))(&g_lua);
+            }
+            assert(numRets == g_lua.stackSize());
+            return numRets;
+        } catch (stdext::exception& e) {
+            // cleanup stack
+            while (g_lua.stackSize() > 0)
+                g_lua.pop();
+            g_lua.pushString(stdext::format("C++ call failed: %s", g_lua.traceback(e.what())));
+        }
     }
 
-    return numRets;
+    lua_error(L);
+    return 0;
 }
 
-int LuaInterface::luaCollectCppFunction(lua_State*)
+int LuaInterface::luaCollectCppFunction(lua_State* L)
 {
+    const StateGuard guard(L);
+
     auto* const funcPtr = static_cast<LuaCppFunctionPtr*>(g_lua.popUserdata());
     assert(funcPtr);
     funcPtr->reset();
     --g_lua.m_totalFuncRefs;
+
+    return 0;
+}
+
+int LuaInterface::luaAsync(lua_State* L)
+{
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+
+    // moves the function and its arguments to the new coroutine
+    const int numValues = lua_gettop(L);
+    lua_State* const thread = lua_newthread(L);
+    lua_insert(L, 1);
+    lua_xmove(L, thread, numValues);
+
+    // it starts on the next poll, like any woken coroutine
+    const StateGuard guard(L);
+    g_lua.m_readyCoroutines.push_back({ g_lua.ref(), LUA_NOREF, 0 });
+    return 0;
+}
+
+int LuaInterface::luaAwait(lua_State* L)
+{
+    if (lua_pushthread(L))
+        return luaL_error(L, "await must be called from a coroutine");
+
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+
+    // f(..., callback), the callback holds the coroutine and wakes it only once
+    lua_pushboolean(L, false);
+    lua_pushcclosure(L, &LuaInterface::luaWakeCoroutine, 2);
+    lua_call(L, lua_gettop(L) - 1, 0);
+
+    return lua_yield(L, 0);
+}
+
+int LuaInterface::luaYieldFrame(lua_State* L)
+{
+    if (lua_pushthread(L))
+        return luaL_error(L, "yieldFrame must be called from a coroutine");
+
+    {
+        const StateGuard guard(L);
+        g_lua.m_readyCoroutines.push_back({ g_lua.ref(), LUA_NOREF, 0 });
+    }
+
+    return lua_yield(L, 0);
+}
+
+int LuaInterface::luaWakeCoroutine(lua_State* L)
+{
+    if (lua_toboolean(L, lua_upvalueindex(2)))
+        return 0;
+
+    lua_pushboolean(L, true);
+    lua_replace(L, lua_upvalueindex(2));
+
+    const StateGuard guard(L);
+
+    // keeps the arguments until the coroutine is resumed
+    const int numArgs = g_lua.getTop();
+    g_lua.createTable(numArgs, 0);
+    for (int i = 0; ++i <= numArgs;) {
+        g_lua.pushValue(i);
+        g_lua.rawSeti(i);
+    }
+    const int args = g_lua.ref();
+
+    lua_pushvalue(L, lua_upvalueindex(1));
+    g_lua.m_readyCoroutines.push_back({ g_lua.ref(), args, numArgs });
+
     return 0;
 }
 
@@ -720,6 +853,102 @@ int LuaInterface::luaBitRightShift(lua_State* L)
 }
 #endif
 
+void LuaInterface::pollCoroutines()
+{
+    if (m_readyCoroutines.empty() || m_coroutineResumeQueued)
+        return;
+
+    m_coroutineResumeQueued = true;
+    g_dispatcher.addTask([this] {
+        m_coroutineResumeQueued = false;
+        resumeCoroutines();
+    });
+}
+
+void LuaInterface::resumeCoroutines()
+{
+    const int64_t startTime = stdext::micros();
+    int resumed = 0;
+
+    // coroutines woken while these run wait for the next poll, the first one always runs
+    for (size_t count = m_readyCoroutines.size(); count > 0; --count) {
+        if (resumed > 0 && stdext::micros() - startTime >= m_coroutineBudget) {
+            ++m_coroutineStats.budgetOverruns;
+            break;
+        }
+
+        const ReadyCoroutine coroutine = m_readyCoroutines.front();
+        m_readyCoroutines.pop_front();
+        resumeCoroutine(coroutine);
+        ++resumed;
+    }
+
+    m_coroutineStats.resumed = resumed;
+    m_coroutineStats.deferred = m_readyCoroutines.size();
+    m_coroutineStats.time = stdext::micros() - startTime;
+    m_coroutineStats.totalResumed += resumed;
+}
+
+void LuaInterface::resumeCoroutine(const ReadyCoroutine& coroutine)
+{
+    getRef(coroutine.thread);
+    lua_State* const thread = lua_tothread(L, -1);
+    pop();
+
+    // the coroutine may have finished or been resumed by someone else meanwhile
+    const int status = lua_status(thread);
+    const bool started = status == LUA_YIELD;
+    if (!started && (status != 0 || lua_gettop(thread) == 0)) {
+        unref(coroutine.args);
+        unref(coroutine.thread);
+        return;
+    }
+
+    int numArgs = started ? 0 : lua_gettop(thread) - 1;
+    if (coroutine.args != LUA_NOREF) {
+        getRef(coroutine.args);
+        for (int i = 0; ++i <= coroutine.numArgs;)
+            rawGeti(i, -i);
+        remove(-coroutine.numArgs - 1);
+        lua_xmove(L, thread, coroutine.numArgs);
+        numArgs += coroutine.numArgs;
+        unref(coroutine.args);
+    }
+
+#if LUA_VERSION_NUM >= 504
+    int numResults;
+    const int ret = lua_resume(thread, L, numArgs, &numResults);
+#elif LUA_VERSION_NUM >= 502
+    const int ret = lua_resume(thread, L, numArgs);
+#else
+    const int ret = lua_resume(thread, numArgs);
+#endif
+
+    if (ret != 0 && ret != LUA_YIELD) {
+        ++m_coroutineStats.errors;
+        const char* message = lua_tostring(thread, -1);
+        luaL_traceback(L, thread, message ? message : "unknown error", 0);
+        g_logger.error(stdext::format("coroutine failed: %s", popString()));
+    }
+
+    // yielded values are not used, the coroutine is held by whatever wakes it
+    lua_settop(thread, 0);
+    unref(coroutine.thread);
+}
+
+std::map<std::string, int> LuaInterface::getCoroutineStats()
+{
+    return {
+        { "resumed", m_coroutineStats.resumed },
+        { "deferred", m_coroutineStats.deferred },
+        { "time", m_coroutineStats.time },
+        { "totalResumed", m_coroutineStats.totalResumed },
+        { "budgetOverruns", m_coroutineStats.budgetOverruns },
+        { "errors", m_coroutineStats.errors },
+        { "pending", m_readyCoroutines.size() }
+    };
+}
+
 void LuaInterface::createLuaState()
 {
     // creates lua state
@@ -767,6 +996,16 @@ void LuaInterface::createLuaState()
     // replace loadfile
     pushCFunction(&LuaInterface::lua_loadfile);
     setGlobal("loadfile");
+
+    // coroutines
+    pushCFunction(&LuaInterface::luaAsync);
+    setGlobal("async");
+
+    pushCFunction(&LuaInterface::luaAwait);
+    setGlobal("await");
+
+    pushCFunction(&LuaInterface::luaYieldFrame);
+    setGlobal("yieldFrame");
 }
 
 void LuaInterface::closeLuaState()
@@ -794,6 +1033,11 @@ void LuaInterface::collectGarbage()
     }
 }
 
+int64_t LuaInterface::getUsedMemory()
+{
+    return static_cast<int64_t>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 + lua_gc(L, LUA_GCCOUNTB, 0);
+}
+
 void LuaInterface::loadBuffer(const std::string_view buffer, const std::string_view source)
 {
     // loads lua buffer
@@ -825,6 +1069,7 @@ int LuaInterface::ref()
     const int ref = luaL_ref(L, LUA_REGISTRYINDEX);
     assert(ref != LUA_NOREF);
     assert(ref < 2147483647);
+    g_memory.add(MemoryTracker::LUA_REFS, 0);
     return ref;
 }
 
@@ -852,8 +1097,10 @@ int LuaInterface::weakRef()
 
 void LuaInterface::unref(int ref)
 {
-    if (ref >= 0 && L != nullptr)
+    if (ref >= 0 && L != nullptr) {
         luaL_unref(L, LUA_REGISTRYINDEX, ref);
+        g_memory.remove(MemoryTracker::LUA_REFS, 0);
+    }
 }
 
 const char* LuaInterface::typeName(int index)
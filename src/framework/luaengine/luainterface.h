@@ -223,6 +223,17 @@ public:
 
     bool isInCppCallback() { return m_cppCallbackDepth != 0; }
 
+    /// Coroutines started by the lua function 'async' run on the main thread, one slice at a time.
+    /// Inside them 'await(f, ...)' calls f(..., callback) and yields until the callback is called,
+    /// 'yieldFrame()' yields until the next poll. The woken coroutines are resumed from an event
+    /// of the next EventDispatcher::poll, for as long as the per poll budget allows.
+    void pollCoroutines();
+    void resumeCoroutines();
+    void setCoroutineBudget(int micros) { m_coroutineBudget = micros; }
+    int getCoroutineBudget() { return m_coroutineBudget; }
+    int getPendingCoroutines() { return m_readyCoroutines.size(); }
+    std::map<std::string, int> getCoroutineStats();
+
 private:
     /// Load scripts requested by lua 'require'
     static int luaScriptLoader(lua_State* L);
@@ -238,6 +249,55 @@ private:
     static int luaCppFunctionCallback(lua_State* L);
     /// Collect bound cpp function pointers
     static int luaCollectCppFunction(lua_State* L);
+    /// safeCall charging the call to the module of the function, used while the lua profiler is enabled
+    int profiledCall(int numArgs);
+    /// Starts a coroutine with the given function and arguments
+    static int luaAsync(lua_State* L);
+    /// Calls a function with a callback that wakes the running coroutine, then yields it
+    static int luaAwait(lua_State* L);
+    /// Yields the running coroutine until the next poll
+    static int luaYieldFrame(lua_State* L);
+    /// Callback created by await, queues the coroutine with the callback arguments
+    static int luaWakeCoroutine(lua_State* L);
+
+    /// C functions run on the stack of their caller, which may be a coroutine
+    lua_State* setState(lua_State* state) { lua_State* previous = L; L = state; return previous; }
+
+    /// Switches to the given state and restores the previous one at the end of the scope, also when a C++ exception leaves it
+    class StateGuard
+    {
+    public:
+        StateGuard(lua_State* state);
+        ~StateGuard();
+
+        StateGuard(const StateGuard&) = delete;
+        StateGuard& operator=(const StateGuard&) = delete;
+
+    private:
+        lua_State* m_previous;
+    };
+
+    struct ReadyCoroutine
+    {
+        int thread;
+        int args; // table with the arguments to resume with, LUA_NOREF when there are none
+        int numArgs;
+    };
+
+    struct CoroutineStats
+    {
+        // last resume
+        int resumed{ 0 };
+        int deferred{ 0 };
+        int64_t time{ 0 }; // microseconds
+
+        // accumulated
+        uint64_t totalResumed{ 0 };
+        int budgetOverruns{ 0 };
+        int errors{ 0 };
+    };
+
+    void resumeCoroutine(const ReadyCoroutine& coroutine);
 
     // Bit functions
 #ifndef LUAJIT_VERSION
@@ -257,6 +317,7 @@ public:
     void closeLuaState();
 
     void collectGarbage();
+    int64_t getUsedMemory();
 
     void loadBuffer(const std::string_view buffer, const std::string_view source);
 
@@ -379,6 +440,11 @@ private:
         m_totalObjRefs{ 0 },
         m_totalFuncRefs{ 0 },
         m_globalEnv{ 0 };
+
+    std::deque<ReadyCoroutine> m_readyCoroutines;
+    bool m_coroutineResumeQueued{ false };
+    int m_coroutineBudget{ 2000 }; // microseconds
+    CoroutineStats m_coroutineStats;
 };
 
 extern LuaInterface g_lua;
@@ -386,6 +452,7 @@ extern LuaInterface g_lua;
 // must be included after, because they need LuaInterface fully declared
 #include "luabinder.h"
 #include "luaexception.h"
+#include "luaprofiler.h"
 #include "luavaluecasts.h"
 
 template<typename T, typename... Args>
@@ -487,6 +554,10 @@ int LuaInterface::luaCallGlobalField(const std::string_view global, const std::s
     g_lua.getGlobalField(global, field);
     if (!g_lua.isNil()) {
         const int numArgs = g_lua.polymorphicPush(args...);
+        if (g_luaProfiler.isEnabled()) {
+            const LuaProfiler::Scope scope(g_luaProfiler.getGlobalFieldStats(global, field));
+            return g_lua.signalCall(numArgs);
+        }
         return g_lua.signalCall(numArgs);
     }
     g_lua.pop(1);
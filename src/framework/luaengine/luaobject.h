@@ -168,6 +168,10 @@ int LuaObject::luaCallLuaField(const std::string_view field, const T&... args)
         // the first argument is always this object (self)
         g_lua.insert(-2);
         const int numArgs = g_lua.polymorphicPush(args...);
+        if (g_luaProfiler.isEnabled()) {
+            const LuaProfiler::Scope scope(g_luaProfiler.getFieldStats(this, field));
+            return g_lua.signalCall(1 + numArgs);
+        }
         return g_lua.signalCall(1 + numArgs);
     }
     g_lua.pop(2);
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "luaprofiler.h"
+#include "luainterface.h"
+#include "luaobject.h"
+
+#include <framework/core/modulemanager.h>
+
+LuaProfiler g_luaProfiler;
+
+LuaProfiler::Scope::Scope(Stats& stats) : m_stats(stats), m_start(stdext::micros()), m_memory(g_lua.getUsedMemory()) {}
+
+LuaProfiler::Scope::~Scope()
+{
+    const ticks_t elapsed = stdext::micros() - m_start;
+
+    ++m_stats.calls;
+    m_stats.totalTime += elapsed;
+    m_stats.maxTime = std::max<int64_t>(m_stats.maxTime, elapsed);
+    m_stats.allocated += std::max<int64_t>(0, g_lua.getUsedMemory() - m_memory);
+}
+
+void LuaProfiler::reset()
+{
+    // stats are zeroed instead of erased, a running scope may still reference them
+    for (auto& it : m_fields)
+        it.second = {};
+    for (auto& it : m_modules)
+        it.second = {};
+}
+
+LuaProfiler::Stats& LuaProfiler::getFieldStats(LuaObject* object, const std::string_view field)
+{
+    auto it = m_classNames.find(typeid(*object));
+    if (it == m_classNames.end())
+        it = m_classNames.emplace(typeid(*object), object->getClassName()).first;
+
+    return m_fields[it->second + "." + std::string(field)];
+}
+
+LuaProfiler::Stats& LuaProfiler::getGlobalFieldStats(const std::string_view global, const std::string_view field)
+{
+    return m_fields[std::string(global) + "." + std::string(field)];
+}
+
+LuaProfiler::Stats& LuaProfiler::getModuleStats(const char* source)
+{
+    const std::string key = source ? source : "";
+
+    const auto it = m_sources.find(key);
+    if (it != m_sources.end())
+        return *it->second;
+
+    Stats* stats = &m_modules[findModuleName(key)];
+    m_sources.emplace(key, stats);
+    return *stats;
+}
+
+std::string LuaProfiler::findModuleName(const std::string_view source)
+{
+    // scripts coming from files has source beginning with '@'
+    if (source.empty() || source[0] != '@')
+        return "<native>";
+
+    const std::string_view path = source.substr(1);
+
+    // the deepest module directory containing the script wins
+    std::string name;
+    size_t length = 0;
+    for (const ModulePtr& module : g_modules.getModules()) {
+        const std::string& modulePath = module->getPath();
+        if (modulePath.size() <= length || !path.starts_with(modulePath + "/"))
+            continue;
+
+        name = module->getName();
+        length = modulePath.size();
+    }
+
+    if (name.empty())
+        return std::string(path.substr(0, path.find_last_of('/')));
+
+    return name;
+}
+
+namespace
+{
+    std::map<std::string, std::vector<double>> toTable(const std::unordered_map<std::string, LuaProfiler::Stats>& entries)
+    {
+        std::map<std::string, std::vector<double>> table;
+        for (const auto& [name, stats] : entries) {
+            if (stats.calls == 0)
+                continue;
+
+            table[name] = {
+                static_cast<double>(stats.calls),
+                stats.totalTime / 1000.,
+                stats.maxTime / 1000.,
+                stats.allocated / 1024.
+            };
+        }
+        return table;
+    }
+
+    void appendReport(std::string& report, const std::string_view title, const std::unordered_map<std::string, LuaProfiler::Stats>& entries, int limit)
+    {
+        std::vector<std::pair<std::string, LuaProfiler::Stats>> sorted;
+        for (const auto& entry : entries) {
+            if (entry.second.calls > 0)
+                sorted.emplace_back(entry);
+        }
+
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second.totalTime > b.second.totalTime; });
+        if (limit > 0 && sorted.size() > static_cast<size_t>(limit))
+            sorted.resize(limit);
+
+        report += stdext::format("%-48s %10s %12s %10s %10s %12s\n", title, "calls", "total ms", "avg ms", "max ms", "alloc KB");
+        for (const auto& [name, stats] : sorted) {
+            report += stdext::format("%-48s %10s %12.3f %10.4f %10.3f %12.1f\n", name, std::to_string(stats.calls),
+                                     stats.totalTime / 1000., stats.totalTime / 1000. / stats.calls, stats.maxTime / 1000., stats.allocated / 1024.);
+        }
+    }
+}
+
+std::map<std::string, std::vector<double>> LuaProfiler::getFields() { return toTable(m_fields); }
+std::map<std::string, std::vector<double>> LuaProfiler::getModules() { return toTable(m_modules); }
+
+std::string LuaProfiler::getReport(int limit)
+{
+    std::string report;
+    appendReport(report, "field", m_fields, limit);
+    report += "\n";
+    appendReport(report, "module", m_modules, limit);
+    return report;
+}
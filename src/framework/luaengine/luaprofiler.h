@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "declarations.h"
+
+#include <typeindex>
+
+/**
+ * Aggregates the cost of the lua callbacks called from C++, per object field
+ * (Creature.onWalk, g_app.onFps...) and per module owning the called function.
+ *
+ * Times are inclusive: a callback that triggers another callback is charged
+ * for both. The allocated memory is the growth of the lua heap during the call,
+ * it is underestimated when the garbage collector runs in the middle of it.
+ * When disabled the only cost is a boolean check before each call.
+ */
+class LuaProfiler
+{
+public:
+    struct Stats
+    {
+        uint64_t calls{ 0 };
+        int64_t totalTime{ 0 }; // microseconds
+        int64_t maxTime{ 0 };
+        int64_t allocated{ 0 }; // bytes
+    };
+
+    class Scope
+    {
+    public:
+        Scope(Stats& stats);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Stats& m_stats;
+        ticks_t m_start;
+        int64_t m_memory;
+    };
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() { return m_enabled; }
+    void reset();
+
+    Stats& getFieldStats(LuaObject* object, const std::string_view field);
+    Stats& getGlobalFieldStats(const std::string_view global, const std::string_view field);
+    // source is the lua_Debug source of the called function
+    Stats& getModuleStats(const char* source);
+
+    // key -> { calls, total ms, max ms, allocated KB }
+    std::map<std::string, std::vector<double>> getFields();
+    std::map<std::string, std::vector<double>> getModules();
+
+    // human readable table with the most expensive fields and modules by total time
+    std::string getReport(int limit);
+
+private:
+    std::string findModuleName(const std::string_view source);
+
+    bool m_enabled{ false };
+
+    // node based, running scopes keep references to the stats
+    std::unordered_map<std::string, Stats> m_fields;
+    std::unordered_map<std::string, Stats> m_modules;
+
+    stdext::map<std::type_index, std::string> m_classNames;
+    stdext::map<std::string, Stats*> m_sources;
+};
+
+extern LuaProfiler g_luaProfiler;
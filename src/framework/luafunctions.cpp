@@ -24,9 +24,12 @@
 #include <framework/core/config.h>
 #include <framework/core/configmanager.h>
 #include <framework/core/eventdispatcher.h>
+#include <framework/core/memorytracker.h>
 #include <framework/core/module.h>
 #include <framework/core/modulemanager.h>
+#include <framework/core/profiler.h>
 #include <framework/core/resourcemanager.h>
+#include <framework/graphics/textureatlas.h>
 #include <framework/graphics/texturemanager.h>
 #include <framework/luaengine/luainterface.h>
 #include <framework/platform/platform.h>
@@ -36,6 +39,7 @@
 #include "graphics/particleeffect.h"
 
 #include "framework/graphics/fontmanager.h"
+#include "framework/graphics/drawpoolmanager.h"
 #include "framework/graphics/graphics.h"
 #include "framework/graphics/particlemanager.h"
 #include "framework/input/mouse.h"
@@ -51,6 +55,7 @@
 #endif
 
 #ifdef FRAMEWORK_NET
+#include <framework/net/networkthread.h>
 #include <framework/net/protocol.h>
 #include <framework/net/protocolhttp.h>
 #include <framework/net/server.h>
@@ -123,6 +128,8 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_clock", "micros", &Clock::micros, &g_clock);
     g_lua.bindSingletonFunction("g_clock", "millis", &Clock::millis, &g_clock);
     g_lua.bindSingletonFunction("g_clock", "seconds", &Clock::seconds, &g_clock);
+    g_lua.bindSingletonFunction("g_clock", "setFixedTimestep", &Clock::setFixedTimestep, &g_clock);
+    g_lua.bindSingletonFunction("g_clock", "getFixedTimestep", &Clock::getFixedTimestep, &g_clock);
 
     // ConfigManager
     g_lua.registerSingletonClass("g_configs");
@@ -133,6 +140,32 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_configs", "unload", &ConfigManager::unload, &g_configs);
     g_lua.bindSingletonFunction("g_configs", "create", &ConfigManager::create, &g_configs);
 
+    // LuaInterface
+    g_lua.registerSingletonClass("g_lua");
+    g_lua.bindSingletonFunction("g_lua", "setCoroutineBudget", &LuaInterface::setCoroutineBudget, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getCoroutineBudget", &LuaInterface::getCoroutineBudget, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getPendingCoroutines", &LuaInterface::getPendingCoroutines, &g_lua);
+    g_lua.bindSingletonFunction("g_lua", "getCoroutineStats", &LuaInterface::getCoroutineStats, &g_lua);
+
+    // LuaProfiler
+    g_lua.registerSingletonClass("g_luaProfiler");
+    g_lua.bindSingletonFunction("g_luaProfiler", "setEnabled", &LuaProfiler::setEnabled, &g_luaProfiler);
+    g_lua.bindSingletonFunction("g_luaProfiler", "isEnabled", &LuaProfiler::isEnabled, &g_luaProfiler);
+    g_lua.bindSingletonFunction("g_luaProfiler", "reset", &LuaProfiler::reset, &g_luaProfiler);
+    g_lua.bindSingletonFunction("g_luaProfiler", "getFields", &LuaProfiler::getFields, &g_luaProfiler);
+    g_lua.bindSingletonFunction("g_luaProfiler", "getModules", &LuaProfiler::getModules, &g_luaProfiler);
+    g_lua.bindSingletonFunction("g_luaProfiler", "getReport", &LuaProfiler::getReport, &g_luaProfiler);
+
+    // MemoryTracker
+    g_lua.registerSingletonClass("g_memory");
+    g_lua.bindSingletonFunction("g_memory", "getBytes", &MemoryTracker::getBytes, &g_memory);
+    g_lua.bindSingletonFunction("g_memory", "getCount", &MemoryTracker::getCount, &g_memory);
+    g_lua.bindSingletonFunction("g_memory", "getTotalBytes", &MemoryTracker::getTotalBytes, &g_memory);
+    g_lua.bindSingletonFunction("g_memory", "getUsage", &MemoryTracker::getUsage, &g_memory);
+    g_lua.bindSingletonFunction("g_memory", "getSummary", &MemoryTracker::getSummary, &g_memory);
+    g_lua.bindSingletonFunction("g_memory", "setLogInterval", &MemoryTracker::setLogInterval, &g_memory);
+    g_lua.bindSingletonFunction("g_memory", "getLogInterval", &MemoryTracker::getLogInterval, &g_memory);
+
     // Logger
     g_lua.registerSingletonClass("g_logger");
     g_lua.bindSingletonFunction("g_logger", "log", &Logger::log, &g_logger);
@@ -161,6 +194,16 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_dispatcher", "addEvent", &EventDispatcher::addEvent, &g_dispatcher);
     g_lua.bindSingletonFunction("g_dispatcher", "scheduleEvent", &EventDispatcher::scheduleEvent, &g_dispatcher);
     g_lua.bindSingletonFunction("g_dispatcher", "cycleEvent", &EventDispatcher::cycleEvent, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getStats", &EventDispatcher::getStats, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getSourceStats", &EventDispatcher::getSourceStats, &g_dispatcher);
+    g_lua.bindClassStaticFunction("g_dispatcher", "getLatenessBuckets", &EventDispatcher::getLatenessBuckets);
+    g_lua.bindSingletonFunction("g_dispatcher", "getLatenessHistogram", &EventDispatcher::getLatenessHistogram, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getCanceledScheduledEvents", &EventDispatcher::getCanceledScheduledEvents, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getScheduledEventsSize", &EventDispatcher::getScheduledEventsSize, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getEventsSize", &EventDispatcher::getEventsSize, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "setPollBudget", &EventDispatcher::setPollBudget, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "getPollBudget", &EventDispatcher::getPollBudget, &g_dispatcher);
+    g_lua.bindSingletonFunction("g_dispatcher", "resetStats", &EventDispatcher::resetStats, &g_dispatcher);
 
     // ResourceManager
     g_lua.registerSingletonClass("g_resources");
@@ -180,6 +223,7 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_resources", "listDirectoryFiles", &ResourceManager::listDirectoryFiles, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "getDirectoryFiles", &ResourceManager::getDirectoryFiles, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "readFileContents", &ResourceManager::readFileContents, &g_resources);
+    g_lua.bindSingletonFunction("g_resources", "readFileContentsAsync", &ResourceManager::readFileContentsAsync, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "writeFileContents", &ResourceManager::writeFileContents, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "guessFilePath", &ResourceManager::guessFilePath, &g_resources);
     g_lua.bindSingletonFunction("g_resources", "isFileType", &ResourceManager::isFileType, &g_resources);
@@ -217,6 +261,7 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<Module>("getAuthor", &Module::getAuthor);
     g_lua.bindClassMemberFunction<Module>("getWebsite", &Module::getWebsite);
     g_lua.bindClassMemberFunction<Module>("getVersion", &Module::getVersion);
+    g_lua.bindClassMemberFunction<Module>("getPath", &Module::getPath);
     g_lua.bindClassMemberFunction<Module>("getSandbox", &Module::getSandbox);
     g_lua.bindClassMemberFunction<Module>("isAutoLoad", &Module::isAutoLoad);
     g_lua.bindClassMemberFunction<Module>("getAutoLoadPriority", &Module::getAutoLoadPriority);
@@ -227,6 +272,8 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<Event>("execute", &Event::execute);
     g_lua.bindClassMemberFunction<Event>("isCanceled", &Event::isCanceled);
     g_lua.bindClassMemberFunction<Event>("isExecuted", &Event::isExecuted);
+    g_lua.bindClassMemberFunction<Event>("setSource", &Event::setSource);
+    g_lua.bindClassMemberFunction<Event>("getSource", &Event::getSource);
 
     // ScheduledEvent
     g_lua.registerClass<ScheduledEvent, Event>();
@@ -247,6 +294,37 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_app", "getFps", &GraphicalApplication::getFps, &g_app);
     g_lua.bindSingletonFunction("g_app", "getMaxFps", &GraphicalApplication::getMaxFps, &g_app);
     g_lua.bindSingletonFunction("g_app", "setMaxFps", &GraphicalApplication::setMaxFps, &g_app);
+    g_lua.bindSingletonFunction("g_app", "getUnfocusedMaxFps", &GraphicalApplication::getUnfocusedMaxFps, &g_app);
+    g_lua.bindSingletonFunction("g_app", "setUnfocusedMaxFps", &GraphicalApplication::setUnfocusedMaxFps, &g_app);
+    g_lua.bindSingletonFunction("g_app", "getMinimizedMaxFps", &GraphicalApplication::getMinimizedMaxFps, &g_app);
+    g_lua.bindSingletonFunction("g_app", "setMinimizedMaxFps", &GraphicalApplication::setMinimizedMaxFps, &g_app);
+    g_lua.bindSingletonFunction("g_app", "getFrameTime", &GraphicalApplication::getFrameTime, &g_app);
+    g_lua.bindSingletonFunction("g_app", "getMaxFrameTime", &GraphicalApplication::getMaxFrameTime, &g_app);
+    g_lua.bindSingletonFunction("g_app", "getFrameJitter", &GraphicalApplication::getFrameJitter, &g_app);
+    g_lua.bindSingletonFunction("g_app", "captureFrame", &GraphicalApplication::captureFrame, &g_app);
+    g_lua.bindSingletonFunction("g_app", "setRenderThread", &GraphicalApplication::setRenderThread, &g_app);
+    g_lua.bindSingletonFunction("g_app", "isRenderThreadEnabled", &GraphicalApplication::isRenderThreadEnabled, &g_app);
+
+    // Profiler
+    g_lua.bindSingletonFunction("g_app", "setProfilerEnabled", &Profiler::setEnabled, &g_profiler);
+    g_lua.bindSingletonFunction("g_app", "isProfilerEnabled", &Profiler::isEnabled, &g_profiler);
+    g_lua.bindSingletonFunction("g_app", "setProfilerFrameCount", &Profiler::setFrameCount, &g_profiler);
+    g_lua.bindSingletonFunction("g_app", "getProfilerFrameCount", &Profiler::getFrameCount, &g_profiler);
+    g_lua.bindSingletonFunction("g_app", "getProfilerFrames", &Profiler::getFrames, &g_profiler);
+    g_lua.bindSingletonFunction("g_app", "getProfilerSummary", &Profiler::getSummary, &g_profiler);
+    g_lua.bindSingletonFunction("g_app", "dumpProfilerTrace", &Profiler::dumpTrace, &g_profiler);
+
+    // DrawPoolManager
+    g_lua.registerSingletonClass("g_drawPool");
+    g_lua.bindSingletonFunction("g_drawPool", "getStats", &DrawPoolManager::getStats, &g_drawPool);
+    g_lua.bindSingletonFunction("g_drawPool", "setStatsOverlay", &DrawPoolManager::setStatsOverlay, &g_drawPool);
+    g_lua.bindSingletonFunction("g_drawPool", "isStatsOverlayEnabled", &DrawPoolManager::isStatsOverlayEnabled, &g_drawPool);
+    g_lua.bindSingletonFunction("g_drawPool", "setReorderDrawings", &DrawPoolManager::setReorderDrawings, &g_drawPool);
+    g_lua.bindSingletonFunction("g_drawPool", "isReorderingDrawings", &DrawPoolManager::isReorderingDrawings, &g_drawPool);
+    g_lua.bindSingletonFunction("g_drawPool", "setInstancing", &DrawPoolManager::setInstancing, &g_drawPool);
+    g_lua.bindSingletonFunction("g_drawPool", "isInstancing", &DrawPoolManager::isInstancing, &g_drawPool);
+    g_lua.bindSingletonFunction("g_drawPool", "setStreamingVertices", &DrawPoolManager::setStreamingVertices, &g_drawPool);
+    g_lua.bindSingletonFunction("g_drawPool", "isStreamingVertices", &DrawPoolManager::isStreamingVertices, &g_drawPool);
 
     // PlatformWindow
     g_lua.registerSingletonClass("g_window");
@@ -307,9 +385,25 @@ void Application::registerLuaFunctions()
     // Textures
     g_lua.registerSingletonClass("g_textures");
     g_lua.bindSingletonFunction("g_textures", "preload", &TextureManager::preload, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "prefetch", &TextureManager::prefetch, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getPendingPrefetchCount", &TextureManager::getPendingPrefetchCount, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "setUploadBudget", &TextureManager::setUploadBudget, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "setStreamingUploads", &TextureManager::setStreamingUploads, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "isStreamingUploads", &TextureManager::isStreamingUploads, &g_textures);
+    g_lua.bindSingletonFunction("g_textures", "getUploadStats", &TextureManager::getUploadStats, &g_textures);
     g_lua.bindSingletonFunction("g_textures", "clearCache", &TextureManager::clearCache, &g_textures);
     g_lua.bindSingletonFunction("g_textures", "liveReload", &TextureManager::liveReload, &g_textures);
 
+    // TextureAtlas
+    g_lua.registerSingletonClass("g_atlas");
+    g_lua.bindSingletonFunction("g_atlas", "setEnabled", &TextureAtlas::setEnabled, &g_atlas);
+    g_lua.bindSingletonFunction("g_atlas", "isEnabled", &TextureAtlas::isEnabled, &g_atlas);
+    g_lua.bindSingletonFunction("g_atlas", "setMaxPages", &TextureAtlas::setMaxPages, &g_atlas);
+    g_lua.bindSingletonFunction("g_atlas", "getMaxPages", &TextureAtlas::getMaxPages, &g_atlas);
+    g_lua.bindSingletonFunction("g_atlas", "getPageSize", &TextureAtlas::getPageSize, &g_atlas);
+    g_lua.bindSingletonFunction("g_atlas", "getStats", &TextureAtlas::getStats, &g_atlas);
+    g_lua.bindSingletonFunction("g_atlas", "clear", &TextureAtlas::clear, &g_atlas);
+
     // UI
     g_lua.registerSingletonClass("g_ui");
     g_lua.bindSingletonFunction("g_ui", "clearStyles", &UIManager::clearStyles, &g_ui);
@@ -317,6 +411,7 @@ void Application::registerLuaFunctions()
     g_lua.bindSingletonFunction("g_ui", "getStyle", &UIManager::getStyle, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "getStyleClass", &UIManager::getStyleClass, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "loadUI", &UIManager::loadUI, &g_ui);
+    g_lua.bindSingletonFunction("g_ui", "prefetch", &UIManager::prefetch, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "displayUI", &UIManager::displayUI, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "createWidget", &UIManager::createWidget, &g_ui);
     g_lua.bindSingletonFunction("g_ui", "createWidgetFromOTML", &UIManager::createWidgetFromOTML, &g_ui);
@@ -738,6 +833,12 @@ void Application::registerLuaFunctions()
     g_lua.bindClassMemberFunction<UIParticles>("addEffect", &UIParticles::addEffect);
 
 #ifdef FRAMEWORK_NET
+    // NetworkThread
+    g_lua.registerSingletonClass("g_network");
+    g_lua.bindSingletonFunction("g_network", "setEnabled", &NetworkThread::setEnabled, &g_network);
+    g_lua.bindSingletonFunction("g_network", "isEnabled", &NetworkThread::isEnabled, &g_network);
+    g_lua.bindSingletonFunction("g_network", "isRunning", &NetworkThread::isRunning, &g_network);
+
     // Server
     g_lua.registerClass<Server>();
     g_lua.bindClassStaticFunction<Server>("create", &Server::create);
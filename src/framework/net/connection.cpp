@@ -23,6 +23,7 @@
 #include "connection.h"
 
 #include <framework/core/application.h>
+#include <framework/core/profiler.h>
 
 #include <utility>
 #include <asio/read.hpp>
@@ -49,6 +50,8 @@ Connection::~Connection()
 
 void Connection::poll()
 {
+    PROFILE_ZONE("Connection::poll");
+
     // reset must always be called prior to poll
     g_ioService.reset();
     g_ioService.poll();
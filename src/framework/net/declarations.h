@@ -33,6 +33,8 @@ class Connection;
 class Protocol;
 class ProtocolHttp;
 class Server;
+class PacketRecorder;
+class NetworkStream;
 
 using InputMessagePtr = stdext::shared_object_ptr<InputMessage>;
 using OutputMessagePtr = stdext::shared_object_ptr<OutputMessage>;
@@ -40,3 +42,5 @@ using ConnectionPtr = stdext::shared_object_ptr<Connection>;
 using ProtocolPtr = stdext::shared_object_ptr<Protocol>;
 using ProtocolHttpPtr = stdext::shared_object_ptr<ProtocolHttp>;
 using ServerPtr = stdext::shared_object_ptr<Server>;
+using PacketRecorderPtr = std::shared_ptr<PacketRecorder>;
+using NetworkStreamPtr = std::shared_ptr<NetworkStream>;
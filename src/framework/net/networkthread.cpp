@@ -0,0 +1,448 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "networkthread.h"
+#include "protocol.h"
+
+#include <framework/core/profiler.h>
+
+#include <asio/connect.hpp>
+#include <asio/post.hpp>
+#include <asio/read.hpp>
+
+NetworkThread g_network;
+
+void NetworkStream::connect(const std::string_view host, uint16_t port)
+{
+    Command* command = prepareCommand();
+    command->type = Command::CONNECT;
+    command->buffer.assign(host.begin(), host.end());
+    command->port = port;
+    commitCommand();
+}
+
+void NetworkStream::configure(const Settings& settings)
+{
+    Command* command = prepareCommand();
+    command->type = Command::CONFIGURE;
+    command->settings = settings;
+    commitCommand();
+}
+
+void NetworkStream::startReading()
+{
+    prepareCommand()->type = Command::READ;
+    commitCommand();
+}
+
+void NetworkStream::send(const uint8_t* buffer, uint16_t size)
+{
+    Command* command = prepareCommand();
+    command->type = Command::SEND;
+    command->buffer.assign(buffer, buffer + size);
+    commitCommand();
+}
+
+void NetworkStream::close()
+{
+    prepareCommand()->type = Command::CLOSE;
+    commitCommand();
+}
+
+NetworkStream::Command* NetworkStream::prepareCommand()
+{
+    // the network thread empties the whole queue on every wake up, so it is only full for a moment
+    Command* command;
+    while (!(command = m_outbound.prepare()))
+        std::this_thread::yield();
+    return command;
+}
+
+void NetworkStream::commitCommand()
+{
+    m_outbound.commit();
+
+    // a single wake up drains everything committed before it runs
+    if (!m_wakePending.exchange(true, std::memory_order_acq_rel))
+        asio::post(m_socket.get_executor(), [self = shared_from_this()] { self->processCommands(); });
+}
+
+void NetworkStream::processCommands()
+{
+    m_wakePending.store(false, std::memory_order_release);
+
+    while (Command* command = m_outbound.front()) {
+        switch (command->type) {
+            case Command::CONNECT:
+                internalConnect({ command->buffer.begin(), command->buffer.end() }, command->port);
+                break;
+            case Command::CONFIGURE:
+                m_settings = command->settings;
+                break;
+            case Command::READ:
+                if (m_connected && !m_reading) {
+                    m_reading = true;
+                    readHeader();
+                }
+                break;
+            case Command::SEND:
+                internalSend(command->buffer);
+                break;
+            case Command::CLOSE:
+                // flush what was sent before closing, like Connection::close does
+                if (m_connected && !m_writing && !m_pendingWrite.empty()) {
+                    std::error_code error;
+                    asio::write(m_socket, asio::buffer(m_pendingWrite), error);
+                }
+                internalClose();
+                break;
+        }
+        m_outbound.pop();
+    }
+
+    // every message sent since the last wake up goes out in a single write
+    internalFlush();
+}
+
+void NetworkStream::internalConnect(const std::string& host, uint16_t port)
+{
+    m_connecting = true;
+    m_connected = false;
+
+    m_resolver.async_resolve(host, std::to_string(port), [self = shared_from_this()](const std::error_code& error, const asio::ip::tcp::resolver::results_type& endpoints)
+    {
+        self->m_readTimer.cancel();
+
+        if (error == asio::error::operation_aborted || !self->m_connecting)
+            return;
+
+        if (error) {
+            self->handleError(error);
+            return;
+        }
+
+        asio::async_connect(self->m_socket, endpoints, [self](const std::error_code& error, const asio::ip::tcp::endpoint&)
+        {
+            self->m_readTimer.cancel();
+
+            if (error == asio::error::operation_aborted || !self->m_connecting)
+                return;
+
+            if (error) {
+                self->handleError(error);
+                return;
+            }
+
+            self->m_connecting = false;
+            self->m_connected = true;
+            self->m_lastRead.store(stdext::millis(), std::memory_order_relaxed);
+
+            // disable nagle's algorithm, this make the game play smoother
+            std::error_code ignored;
+            self->m_socket.set_option(asio::ip::tcp::no_delay(true), ignored);
+
+            self->notify(Event::CONNECTED);
+        });
+
+        self->restartTimer(self->m_readTimer, READ_TIMEOUT);
+    });
+
+    restartTimer(m_readTimer, READ_TIMEOUT);
+}
+
+void NetworkStream::internalSend(const std::vector<uint8_t>& buffer)
+{
+    if (!m_connected)
+        return;
+
+    const Settings& settings = m_settings;
+    const size_t size = buffer.size();
+    const size_t headerSize = settings.checksum ? 6 : 2;
+
+    // the XTEA block holds its own size and is padded with zeros to a multiple of 8
+    const size_t bodySize = settings.xtea ? (size + 2 + 7) & ~static_cast<size_t>(7) : size;
+
+    const size_t offset = m_pendingWrite.size();
+    m_pendingWrite.resize(offset + headerSize + bodySize);
+
+    uint8_t* header = m_pendingWrite.data() + offset;
+    uint8_t* body = header + headerSize;
+    if (settings.xtea) {
+        stdext::writeULE16(body, size);
+        std::memcpy(body + 2, buffer.data(), size);
+        Protocol::xteaEncrypt(body, bodySize, settings.xteaKey);
+    } else
+        std::memcpy(body, buffer.data(), size);
+
+    if (settings.checksum)
+        stdext::writeULE32(header + 2, stdext::adler32(body, bodySize));
+
+    stdext::writeULE16(header, headerSize - 2 + bodySize);
+}
+
+void NetworkStream::internalFlush()
+{
+    if (!m_connected || m_writing || m_pendingWrite.empty())
+        return;
+
+    std::swap(m_writeBuffer, m_pendingWrite);
+    m_pendingWrite.clear();
+    m_writing = true;
+
+    asio::async_write(m_socket, asio::buffer(m_writeBuffer), [self = shared_from_this()](const std::error_code& error, size_t)
+    {
+        self->m_writeTimer.cancel();
+        self->m_writing = false;
+
+        if (error == asio::error::operation_aborted || !self->m_connected)
+            return;
+
+        if (error) {
+            self->handleError(error);
+            return;
+        }
+
+        self->internalFlush();
+    });
+
+    restartTimer(m_writeTimer, WRITE_TIMEOUT);
+}
+
+void NetworkStream::internalClose()
+{
+    m_connecting = false;
+    m_connected = false;
+    m_reading = false;
+    m_pendingWrite.clear();
+
+    m_resolver.cancel();
+    m_readTimer.cancel();
+    m_writeTimer.cancel();
+    m_retryTimer.cancel();
+
+    if (m_socket.is_open()) {
+        std::error_code error;
+        m_socket.shutdown(asio::ip::tcp::socket::shutdown_both, error);
+        m_socket.close(error);
+    }
+}
+
+void NetworkStream::readHeader()
+{
+    // the first 2 bytes contain the message size
+    m_readBuffer.resize(2);
+    asio::async_read(m_socket, asio::buffer(m_readBuffer), [self = shared_from_this()](const std::error_code& error, size_t)
+    {
+        if (self->onRead(error))
+            self->readBody(stdext::readULE16(self->m_readBuffer.data()));
+    });
+
+    restartTimer(m_readTimer, READ_TIMEOUT);
+}
+
+void NetworkStream::readBody(uint16_t size)
+{
+    m_readBuffer.resize(size);
+    asio::async_read(m_socket, asio::buffer(m_readBuffer), [self = shared_from_this()](const std::error_code& error, size_t)
+    {
+        if (self->onRead(error))
+            self->deliver(self->unpack());
+    });
+
+    restartTimer(m_readTimer, READ_TIMEOUT);
+}
+
+bool NetworkStream::onRead(const std::error_code& error)
+{
+    m_readTimer.cancel();
+
+    if (error == asio::error::operation_aborted || !m_connected)
+        return false;
+
+    if (error) {
+        handleError(error);
+        return false;
+    }
+
+    m_lastRead.store(stdext::millis(), std::memory_order_relaxed);
+    return true;
+}
+
+std::string_view NetworkStream::unpack()
+{
+    uint8_t* data = m_readBuffer.data();
+    size_t size = m_readBuffer.size();
+
+    if (m_settings.checksum) {
+        if (size < 4 || stdext::readULE32(data) != stdext::adler32(data + 4, size - 4))
+            return "got a network message with invalid checksum";
+
+        data += 4;
+        size -= 4;
+    }
+
+    if (m_settings.xtea) {
+        if (size == 0 || size % 8 != 0)
+            return "invalid encrypted network message";
+
+        Protocol::xteaDecrypt(data, size, m_settings.xteaKey);
+
+        const size_t decryptedSize = stdext::readULE16(data) + 2;
+        if (decryptedSize > size)
+            return "invalid decrypted network message";
+
+        data += 2;
+        size = decryptedSize - 2;
+    }
+
+    m_payload = { data, size };
+    return {};
+}
+
+void NetworkStream::deliver(std::string_view invalidReason)
+{
+    if (!pushEvent(invalidReason.empty() ? Event::MESSAGE : Event::INVALID_MESSAGE, {}, invalidReason)) {
+        // the main thread is behind, stop reading until the message fits in the queue
+        m_retryTimer.expires_after(std::chrono::milliseconds(1));
+        m_retryTimer.async_wait([self = shared_from_this(), invalidReason](const std::error_code& error)
+        {
+            if (!error && self->m_connected)
+                self->deliver(invalidReason);
+        });
+        return;
+    }
+
+    // like Connection, a message that can not be read ends the reading, nothing after it is trusted
+    if (invalidReason.empty())
+        readHeader();
+}
+
+void NetworkStream::notify(Event::Type type, const std::error_code& error)
+{
+    if (pushEvent(type, error))
+        return;
+
+    m_retryTimer.expires_after(std::chrono::milliseconds(1));
+    m_retryTimer.async_wait([self = shared_from_this(), type, error](const std::error_code& timerError)
+    {
+        if (!timerError)
+            self->notify(type, error);
+    });
+}
+
+bool NetworkStream::pushEvent(Event::Type type, const std::error_code& error, std::string_view reason)
+{
+    Event* event = m_inbound.prepare();
+    if (!event)
+        return false;
+
+    event->type = type;
+    event->error = error;
+    event->reason = reason;
+
+    // slots keep their buffer, so steady traffic does not allocate
+    if (type == Event::MESSAGE)
+        event->buffer.assign(m_payload.begin(), m_payload.end());
+    else
+        event->buffer.clear();
+
+    m_inbound.commit();
+    return true;
+}
+
+void NetworkStream::restartTimer(asio::steady_timer& timer, int seconds)
+{
+    timer.expires_after(std::chrono::seconds(seconds));
+    timer.async_wait([self = shared_from_this()](const std::error_code& error)
+    {
+        if (!error)
+            self->handleError(asio::error::timed_out);
+    });
+}
+
+void NetworkStream::handleError(const std::error_code& error)
+{
+    if (error == asio::error::operation_aborted || (!m_connected && !m_connecting))
+        return;
+
+    internalClose();
+    notify(Event::DISCONNECTED, error);
+}
+
+void NetworkThread::poll()
+{
+    if (m_protocols.empty())
+        return;
+
+    PROFILE_ZONE("NetworkThread::poll");
+
+    // callbacks may disconnect and remove protocols
+    m_polling = m_protocols;
+    for (const auto& protocol : m_polling)
+        protocol->pollStream();
+    m_polling.clear();
+}
+
+void NetworkThread::terminate()
+{
+    const auto protocols = std::move(m_protocols);
+    for (const auto& protocol : protocols)
+        protocol->disconnect();
+
+    if (!isRunning())
+        return;
+
+    m_work.reset();
+    m_service.stop();
+    m_thread.join();
+}
+
+void NetworkThread::start()
+{
+    if (isRunning())
+        return;
+
+    m_service.restart();
+    m_work = std::make_unique<asio::executor_work_guard<asio::io_context::executor_type>>(m_service.get_executor());
+    m_thread = std::thread([this] { m_service.run(); });
+}
+
+NetworkStreamPtr NetworkThread::createStream(const ProtocolPtr& protocol)
+{
+    start();
+
+    if (std::find(m_protocols.begin(), m_protocols.end(), protocol) == m_protocols.end())
+        m_protocols.push_back(protocol);
+
+    return std::make_shared<NetworkStream>(m_service);
+}
+
+void NetworkThread::removeStream(const Protocol* protocol)
+{
+    const auto it = std::find_if(m_protocols.begin(), m_protocols.end(), [protocol](const ProtocolPtr& p) { return p.get() == protocol; });
+    if (it == m_protocols.end())
+        return;
+
+    // the protocol may die with this reference, so it is released after the erase
+    const ProtocolPtr removed = std::move(*it);
+    m_protocols.erase(it);
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "declarations.h"
+
+#include <asio/executor_work_guard.hpp>
+#include <asio/io_context.hpp>
+#include <asio/steady_timer.hpp>
+#include <framework/stdext/spsc_queue.h>
+
+#include <span>
+#include <thread>
+
+/**
+ * Socket of a Protocol that lives on the network thread.
+ *
+ * The network thread resolves, connects, reads the framed messages ahead and checks their
+ * checksum and XTEA encryption, then hands the decrypted payloads to the main thread
+ * through the inbound queue. Outgoing messages take the reverse path and are encrypted
+ * and framed on the network thread. Changes of the settings are commands too, in order
+ * with the sends: a protocol enables XTEA around the login packet, so the replies it
+ * causes are read after the change. Nothing in here may touch a LuaObject.
+ */
+class NetworkStream : public std::enable_shared_from_this<NetworkStream>
+{
+public:
+    struct Settings
+    {
+        std::array<uint32_t, 4> xteaKey{};
+        bool checksum{ false };
+        bool xtea{ false };
+
+        bool operator==(const Settings&) const = default;
+    };
+
+    struct Event
+    {
+        enum Type : uint8_t { CONNECTED, MESSAGE, INVALID_MESSAGE, DISCONNECTED };
+
+        Type type{ MESSAGE };
+        std::vector<uint8_t> buffer; // the decrypted payload of a message
+        std::error_code error;
+        std::string_view reason;
+    };
+
+    NetworkStream(asio::io_context& service) : m_resolver(service), m_socket(service), m_readTimer(service), m_writeTimer(service), m_retryTimer(service) {}
+
+    // main thread only
+    void connect(const std::string_view host, uint16_t port);
+    void configure(const Settings& settings);
+    void startReading();
+    void send(const uint8_t* buffer, uint16_t size);
+    void close();
+
+    Event* front() { return m_inbound.front(); }
+    void pop() { m_inbound.pop(); }
+
+    ticks_t getLastRead() { return m_lastRead.load(std::memory_order_relaxed); }
+
+private:
+    enum
+    {
+        READ_TIMEOUT = 30,
+        WRITE_TIMEOUT = 30,
+        INBOUND_CAPACITY = 256,
+        OUTBOUND_CAPACITY = 1024
+    };
+
+    struct Command
+    {
+        enum Type : uint8_t { CONNECT, CONFIGURE, READ, SEND, CLOSE };
+
+        Type type{ SEND };
+        Settings settings;
+        std::vector<uint8_t> buffer;
+        uint16_t port{ 0 };
+    };
+
+    Command* prepareCommand();
+    void commitCommand();
+
+    // network thread only
+    void processCommands();
+    void internalConnect(const std::string& host, uint16_t port);
+    void internalSend(const std::vector<uint8_t>& buffer);
+    void internalFlush();
+    void internalClose();
+    void readHeader();
+    void readBody(uint16_t size);
+    bool onRead(const std::error_code& error);
+    std::string_view unpack();
+    void deliver(std::string_view invalidReason);
+    void notify(Event::Type type, const std::error_code& error = {});
+    bool pushEvent(Event::Type type, const std::error_code& error = {}, std::string_view reason = {});
+    void restartTimer(asio::steady_timer& timer, int seconds);
+    void handleError(const std::error_code& error);
+
+    asio::ip::tcp::resolver m_resolver;
+    asio::ip::tcp::socket m_socket;
+    asio::steady_timer m_readTimer;
+    asio::steady_timer m_writeTimer;
+    asio::steady_timer m_retryTimer;
+
+    stdext::spsc_queue<Command, OUTBOUND_CAPACITY> m_outbound;
+    stdext::spsc_queue<Event, INBOUND_CAPACITY> m_inbound;
+    std::atomic_bool m_wakePending{ false };
+    std::atomic<ticks_t> m_lastRead{ 0 };
+
+    Settings m_settings;
+    std::vector<uint8_t> m_readBuffer;
+    std::span<const uint8_t> m_payload;
+    std::vector<uint8_t> m_pendingWrite;
+    std::vector<uint8_t> m_writeBuffer;
+    bool m_connecting{ false };
+    bool m_connected{ false };
+    bool m_reading{ false };
+    bool m_writing{ false };
+};
+
+/**
+ * Owns the network thread and its io_context.
+ *
+ * Protocols connected while it is enabled run their socket on the network thread,
+ * poll() delivers their queued events on the main thread. Server and ProtocolHttp
+ * keep using the main thread io_service.
+ */
+class NetworkThread
+{
+public:
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() { return m_enabled; }
+    bool isRunning() { return m_thread.joinable(); }
+
+    void poll();
+    void terminate();
+
+private:
+    NetworkStreamPtr createStream(const ProtocolPtr& protocol);
+    void removeStream(const Protocol* protocol);
+
+    void start();
+
+    asio::io_context m_service;
+    std::unique_ptr<asio::executor_work_guard<asio::io_context::executor_type>> m_work;
+    std::thread m_thread;
+
+    std::vector<ProtocolPtr> m_protocols;
+    std::vector<ProtocolPtr> m_polling;
+    bool m_enabled{ false };
+
+    friend class Protocol;
+};
+
+extern NetworkThread g_network;
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "packetrecorder.h"
+#include <framework/core/filestream.h>
+#include <framework/core/resourcemanager.h>
+
+PacketRecorder::PacketRecorder(const std::string& fileName, uint16_t clientVersion, uint16_t protocolVersion, const std::vector<bool>& features)
+{
+    m_file = g_resources.createFile(fileName);
+    if (!m_file)
+        throw Exception("failed to open file '%s' for write", fileName);
+
+    m_file->addU32(MAGIC);
+    m_file->addU16(FORMAT_VERSION);
+    m_file->addU16(clientVersion);
+    m_file->addU16(protocolVersion);
+
+    m_file->addU16(features.size());
+    for (size_t i = 0; i < features.size(); i += 8) {
+        uint8_t bits = 0;
+        for (size_t j = 0; j < 8 && i + j < features.size(); ++j) {
+            if (features[i + j])
+                bits |= 1 << j;
+        }
+        m_file->addU8(bits);
+    }
+
+    m_timer.restart();
+}
+
+PacketRecorder::~PacketRecorder()
+{
+    close();
+}
+
+void PacketRecorder::addPacket(const uint8_t* buffer, uint16_t size)
+{
+    if (!m_file)
+        return;
+
+    // header and payload go in a single write
+    m_buffer.resize(6 + size);
+    stdext::writeULE32(m_buffer.data(), static_cast<uint32_t>(m_timer.elapsed_millis()));
+    stdext::writeULE16(m_buffer.data() + 4, size);
+    memcpy(m_buffer.data() + 6, buffer, size);
+
+    try {
+        m_file->write(m_buffer.data(), m_buffer.size());
+        ++m_packetCount;
+    } catch (const stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to record packet: %s", e.what()));
+        close();
+    }
+}
+
+void PacketRecorder::close()
+{
+    if (!m_file)
+        return;
+
+    try {
+        m_file->flush();
+        m_file->close();
+    } catch (const stdext::exception& e) {
+        g_logger.error(stdext::format("Unable to close packet recording: %s", e.what()));
+    }
+
+    m_file = nullptr;
+}
+
+PacketRecorder::Recording PacketRecorder::load(const std::string& fileName)
+{
+    const FileStreamPtr fin = g_resources.openFile(fileName);
+    fin->cache();
+
+    if (fin->getU32() != MAGIC)
+        throw Exception("'%s' is not a packet recording", fileName);
+
+    const uint16_t formatVersion = fin->getU16();
+    if (formatVersion != FORMAT_VERSION)
+        throw Exception("packet recording format %d is not supported", formatVersion);
+
+    Recording recording;
+    recording.clientVersion = fin->getU16();
+    recording.protocolVersion = fin->getU16();
+
+    recording.features.resize(fin->getU16());
+    for (size_t i = 0; i < recording.features.size(); i += 8) {
+        const uint8_t bits = fin->getU8();
+        for (size_t j = 0; j < 8 && i + j < recording.features.size(); ++j)
+            recording.features[i + j] = bits & (1 << j);
+    }
+
+    while (!fin->eof()) {
+        auto& packet = recording.packets.emplace_back();
+        packet.time = fin->getU32();
+        packet.data.resize(fin->getU16());
+        if (fin->read(packet.data.data(), packet.data.size()) != 1)
+            throw Exception("packet recording '%s' is truncated", fileName);
+    }
+
+    return recording;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "declarations.h"
+#include <framework/core/declarations.h>
+#include <framework/stdext/time.h>
+
+/**
+ * Captures decrypted incoming payloads so a session can be replayed offline.
+ *
+ * File layout (little endian):
+ *   u32 magic "OTPR", u16 format version, u16 client version, u16 protocol version,
+ *   u16 feature count followed by the packed feature bits,
+ *   then one record per message: u32 milliseconds since start, u16 size, payload.
+ */
+class PacketRecorder
+{
+public:
+    static constexpr uint32_t MAGIC = 0x5250544F; // "OTPR"
+    static constexpr uint16_t FORMAT_VERSION = 1;
+
+    struct Packet
+    {
+        uint32_t time;
+        std::string data;
+    };
+
+    struct Recording
+    {
+        uint16_t clientVersion{ 0 };
+        uint16_t protocolVersion{ 0 };
+        std::vector<bool> features;
+        std::vector<Packet> packets;
+    };
+
+    PacketRecorder(const std::string& fileName, uint16_t clientVersion, uint16_t protocolVersion, const std::vector<bool>& features);
+    ~PacketRecorder();
+
+    void addPacket(const uint8_t* buffer, uint16_t size);
+    void close();
+
+    bool isOpen() { return m_file != nullptr; }
+    uint32_t getPacketCount() { return m_packetCount; }
+
+    static Recording load(const std::string& fileName);
+
+private:
+    FileStreamPtr m_file;
+    stdext::timer m_timer;
+    uint32_t m_packetCount{ 0 };
+    std::vector<uint8_t> m_buffer;
+};
@@ -22,6 +22,7 @@
 
 #include "protocol.h"
 #include "connection.h"
+#include "packetrecorder.h"
 #include <framework/core/application.h>
 #include <random>
 
@@ -37,6 +38,23 @@ Protocol::~Protocol()
 
 void Protocol::connect(const std::string_view host, uint16_t port)
 {
+    if (g_network.isEnabled()) {
+        if (m_stream)
+            m_stream->close();
+
+        m_stream = g_network.createStream(asProtocol());
+        m_streamConnecting = true;
+        m_streamConnected = false;
+        m_streamReading = false;
+        m_recvPending = false;
+        m_stream->connect(host, port);
+
+        // a new stream starts with the default settings
+        m_streamSettings = {};
+        configureStream();
+        return;
+    }
+
     m_connection = ConnectionPtr(new Connection);
     m_connection->setErrorCallback([capture0 = asProtocol()](auto&& PH1)
     { capture0->onError(std::forward<decltype(PH1)>(PH1));    });
@@ -49,10 +67,53 @@ void Protocol::disconnect()
         m_connection->close();
         m_connection.reset();
     }
+
+    if (m_stream) {
+        m_stream->close();
+        m_stream.reset();
+        m_streamConnecting = false;
+        m_streamConnected = false;
+
+        // may release the last reference to this protocol
+        g_network.removeStream(this);
+    }
+}
+
+bool Protocol::isConnected()
+{
+    if (m_stream)
+        return m_streamConnected;
+
+    return m_connection && m_connection->isConnected();
+}
+
+bool Protocol::isConnecting()
+{
+    if (m_stream)
+        return m_streamConnecting;
+
+    return m_connection && m_connection->isConnecting();
+}
+
+ticks_t Protocol::getElapsedTicksSinceLastRead()
+{
+    if (m_stream)
+        return m_streamConnected ? stdext::millis() - m_stream->getLastRead() : -1;
+
+    return m_connection ? m_connection->getElapsedTicksSinceLastRead() : -1;
 }
 
 void Protocol::send(const OutputMessagePtr& outputMessage)
 {
+    // framing and encryption happen on the network thread, the settings of this moment were sent before
+    if (m_stream) {
+        if (m_streamConnected)
+            m_stream->send(outputMessage->getHeaderBuffer(), outputMessage->getMessageSize());
+
+        outputMessage->reset();
+        return;
+    }
+
     // encrypt
     if (m_xteaEncryptionEnabled)
         xteaEncrypt(outputMessage);
@@ -74,15 +135,14 @@ void Protocol::send(const OutputMessagePtr& outputMessage)
 
 void Protocol::recv()
 {
-    m_inputMessage->reset();
+    // the network thread reads ahead, this only allows pollStream to deliver the next message
+    if (m_stream) {
+        m_recvPending = true;
+        startStreamReading();
+        return;
+    }
 
-    // first update message header size
-    int headerSize = 2; // 2 bytes for message size
-    if (m_checksumEnabled)
-        headerSize += 4; // 4 bytes for checksum
-    if (m_xteaEncryptionEnabled)
-        headerSize += 2; // 2 bytes for XTEA encrypted message size
-    m_inputMessage->setHeaderSize(headerSize);
+    resetInputMessage();
 
     // read the first 2 bytes which contain the message size
     if (m_connection)
@@ -93,6 +153,19 @@ void Protocol::recv()
     });
 }
 
+void Protocol::resetInputMessage()
+{
+    m_inputMessage->reset();
+
+    // first update message header size
+    int headerSize = 2; // 2 bytes for message size
+    if (m_checksumEnabled)
+        headerSize += 4; // 4 bytes for checksum
+    if (m_xteaEncryptionEnabled)
+        headerSize += 2; // 2 bytes for XTEA encrypted message size
+    m_inputMessage->setHeaderSize(headerSize);
+}
+
 void Protocol::internalRecvHeader(uint8_t* buffer, uint16_t size)
 {
     // read message size
@@ -117,7 +190,11 @@ void Protocol::internalRecvData(uint8_t* buffer, uint16_t size)
     }
 
     m_inputMessage->fillBuffer(buffer, size);
+    processInputMessage();
+}
 
+void Protocol::processInputMessage()
+{
     if (m_checksumEnabled && !m_inputMessage->readChecksum()) {
         g_logger.traceError("got a network message with invalid checksum");
         return;
@@ -129,14 +206,95 @@ void Protocol::internalRecvData(uint8_t* buffer, uint16_t size)
             return;
         }
     }
+
+    if (m_recorder)
+        m_recorder->addPacket(m_inputMessage->getReadBuffer(), m_inputMessage->getUnreadSize());
+
     onRecv(m_inputMessage);
 }
 
+void Protocol::configureStream()
+{
+    // applied by the network thread in order with the sends, see NetworkStream
+    const NetworkStream::Settings settings{ m_xteaKey, m_checksumEnabled, m_xteaEncryptionEnabled };
+    if (!m_stream || settings == m_streamSettings)
+        return;
+
+    m_streamSettings = settings;
+    m_stream->configure(settings);
+}
+
+void Protocol::startStreamReading()
+{
+    // reading is not possible before connecting, just like Connection::read
+    if (!m_streamConnected || m_streamReading)
+        return;
+
+    m_streamReading = true;
+    m_stream->startReading();
+}
+
+void Protocol::pollStream()
+{
+    while (m_stream) {
+        NetworkStream::Event* event = m_stream->front();
+        if (!event)
+            break;
+
+        switch (event->type) {
+            case NetworkStream::Event::CONNECTED:
+                m_stream->pop();
+                m_streamConnecting = false;
+                m_streamConnected = true;
+                onConnect();
+                break;
+
+            case NetworkStream::Event::MESSAGE:
+                // queued messages wait for recv()
+                if (!m_recvPending)
+                    return;
+
+                m_recvPending = false;
+                m_inputMessage->reset();
+                m_inputMessage->fillBuffer(event->buffer.data(), event->buffer.size());
+                m_stream->pop();
+
+                if (m_recorder)
+                    m_recorder->addPacket(m_inputMessage->getReadBuffer(), m_inputMessage->getUnreadSize());
+
+                onRecv(m_inputMessage);
+                break;
+
+            case NetworkStream::Event::INVALID_MESSAGE:
+                if (!m_recvPending)
+                    return;
+
+                // the network thread stopped reading, the recv it answers never gets a message,
+                // the same as processInputMessage returning without onRecv
+                m_recvPending = false;
+                g_logger.traceError(event->reason);
+                m_stream->pop();
+                break;
+
+            case NetworkStream::Event::DISCONNECTED:
+            {
+                const std::error_code error = event->error;
+                m_stream->pop();
+                m_streamConnecting = false;
+                m_streamConnected = false;
+                onError(error);
+                break;
+            }
+        }
+    }
+}
+
 void Protocol::generateXteaKey()
 {
     std::random_device rd;
     std::uniform_int_distribution<uint32_t > unif;
     std::generate(m_xteaKey.begin(), m_xteaKey.end(), [&unif, &rd] { return unif(rd); });
+    configureStream();
 }
 
 namespace
@@ -164,6 +322,26 @@ namespace
     }
 }
 
+void Protocol::xteaDecrypt(uint8_t* buffer, size_t length, const std::array<uint32_t, 4>& key)
+{
+    for (uint32_t i = 0, sum = delta << 5, next_sum = sum - delta; i < 32; ++i, sum = next_sum, next_sum -= delta) {
+        apply_rounds(buffer, length, [&](uint32_t & left, uint32_t & right) {
+            right -= ((left << 4 ^ left >> 5) + left) ^ (sum + key[(sum >> 11) & 3]);
+            left -= ((right << 4 ^ right >> 5) + right) ^ (next_sum + key[next_sum & 3]);
+        });
+    }
+}
+
+void Protocol::xteaEncrypt(uint8_t* buffer, size_t length, const std::array<uint32_t, 4>& key)
+{
+    for (uint32_t i = 0, sum = 0, next_sum = sum + delta; i < 32; ++i, sum = next_sum, next_sum += delta) {
+        apply_rounds(buffer, length, [&](uint32_t & left, uint32_t & right) {
+            left += ((right << 4 ^ right >> 5) + right) ^ (sum + key[sum & 3]);
+            right += ((left << 4 ^ left >> 5) + left) ^ (next_sum + key[(next_sum >> 11) & 3]);
+        });
+    }
+}
+
 bool Protocol::xteaDecrypt(const InputMessagePtr& inputMessage)
 {
     const uint16_t encryptedSize = inputMessage->getUnreadSize();
@@ -172,12 +350,7 @@ bool Protocol::xteaDecrypt(const InputMessagePtr& inputMessage)
         return false;
     }
 
-    for (uint32_t i = 0, sum = delta << 5, next_sum = sum - delta; i < 32; ++i, sum = next_sum, next_sum -= delta) {
-        apply_rounds(inputMessage->getReadBuffer(), encryptedSize, [&](uint32_t & left, uint32_t & right) {
-            right -= ((left << 4 ^ left >> 5) + left) ^ (sum + m_xteaKey[(sum >> 11) & 3]);
-            left -= ((right << 4 ^ right >> 5) + right) ^ (next_sum + m_xteaKey[next_sum & 3]);
-        });
-    }
+    xteaDecrypt(inputMessage->getReadBuffer(), encryptedSize, m_xteaKey);
 
     const uint16_t decryptedSize = inputMessage->getU16() + 2;
     const int sizeDelta = decryptedSize - encryptedSize;
@@ -202,12 +375,7 @@ void Protocol::xteaEncrypt(const OutputMessagePtr& outputMessage)
         encryptedSize += n;
     }
 
-    for (uint32_t i = 0, sum = 0, next_sum = sum + delta; i < 32; ++i, sum = next_sum, next_sum += delta) {
-        apply_rounds(outputMessage->getDataBuffer() - 2, encryptedSize, [&](uint32_t & left, uint32_t & right) {
-            left += ((right << 4 ^ right >> 5) + right) ^ (sum + m_xteaKey[sum & 3]);
-            right += ((left << 4 ^ left >> 5) + left) ^ (next_sum + m_xteaKey[(next_sum >> 11) & 3]);
-        });
-    }
+    xteaEncrypt(outputMessage->getDataBuffer() - 2, encryptedSize, m_xteaKey);
 }
 
 void Protocol::onConnect() { callLuaField("onConnect"); }
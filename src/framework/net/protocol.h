@@ -25,6 +25,7 @@
 #include "connection.h"
 #include "declarations.h"
 #include "inputmessage.h"
+#include "networkthread.h"
 #include "outputmessage.h"
 
 #include <framework/luaengine/luaobject.h>
@@ -39,41 +40,66 @@ public:
     void connect(const std::string_view host, uint16_t port);
     void disconnect();
 
-    bool isConnected() { return m_connection && m_connection->isConnected(); }
-    bool isConnecting() { return m_connection && m_connection->isConnecting(); }
-    ticks_t getElapsedTicksSinceLastRead() { return m_connection ? m_connection->getElapsedTicksSinceLastRead() : -1; }
+    bool isConnected();
+    bool isConnecting();
+    ticks_t getElapsedTicksSinceLastRead();
 
     ConnectionPtr getConnection() { return m_connection; }
     void setConnection(const ConnectionPtr& connection) { m_connection = connection; }
 
     void generateXteaKey();
-    void setXteaKey(uint32_t a, uint32_t b, uint32_t c, uint32_t d) { m_xteaKey = { a, b, c, d }; }
+    void setXteaKey(uint32_t a, uint32_t b, uint32_t c, uint32_t d) { m_xteaKey = { a, b, c, d }; configureStream(); }
     std::vector<uint32_t > getXteaKey() { return { m_xteaKey.begin(), m_xteaKey.end() }; }
-    void enableXteaEncryption() { m_xteaEncryptionEnabled = true; }
+    void enableXteaEncryption() { m_xteaEncryptionEnabled = true; configureStream(); }
 
-    void enableChecksum() { m_checksumEnabled = true; }
+    void enableChecksum() { m_checksumEnabled = true; configureStream(); }
+
+    // every decrypted incoming message is written to the recorder while it is set
+    void setRecorder(const PacketRecorderPtr& recorder) { m_recorder = recorder; }
+    PacketRecorderPtr getRecorder() { return m_recorder; }
 
     virtual void send(const OutputMessagePtr& outputMessage);
     virtual void recv();
 
     ProtocolPtr asProtocol() { return static_self_cast<Protocol>(); }
 
+    // length must be a multiple of 8, shared with the network thread
+    static void xteaEncrypt(uint8_t* buffer, size_t length, const std::array<uint32_t, 4>& key);
+    static void xteaDecrypt(uint8_t* buffer, size_t length, const std::array<uint32_t, 4>& key);
+
 protected:
     virtual void onConnect();
     virtual void onRecv(const InputMessagePtr& inputMessage);
     virtual void onError(const std::error_code& err);
 
+    bool xteaDecrypt(const InputMessagePtr& inputMessage);
+    void xteaEncrypt(const OutputMessagePtr& outputMessage);
+
     std::array<uint32_t, 4> m_xteaKey{};
 
 private:
+    void resetInputMessage();
     void internalRecvHeader(uint8_t* buffer, uint16_t size);
     void internalRecvData(uint8_t* buffer, uint16_t size);
+    void processInputMessage();
 
-    bool xteaDecrypt(const InputMessagePtr& inputMessage);
-    void xteaEncrypt(const OutputMessagePtr& outputMessage);
+    // network thread mode, see NetworkThread
+    void pollStream();
+    void configureStream();
+    void startStreamReading();
 
     bool m_checksumEnabled{ false };
     bool m_xteaEncryptionEnabled{ false };
     ConnectionPtr m_connection;
+
+    NetworkStreamPtr m_stream;
+    NetworkStream::Settings m_streamSettings;
+    bool m_streamConnecting{ false };
+    bool m_streamConnected{ false };
+    bool m_streamReading{ false };
+    bool m_recvPending{ false };
     InputMessagePtr m_inputMessage;
+    PacketRecorderPtr m_recorder;
+
+    friend class NetworkThread;
 };
@@ -23,6 +23,11 @@
 #include "otmlnode.h"
 #include "otmlemitter.h"
 
+#include <framework/core/memorytracker.h>
+
+OTMLNode::OTMLNode() { g_memory.add(MemoryTracker::OTML_NODES, sizeof(OTMLNode)); }
+OTMLNode::~OTMLNode() { g_memory.remove(MemoryTracker::OTML_NODES, sizeof(OTMLNode)); }
+
 OTMLNodePtr OTMLNode::create(const std::string_view tag, bool unique)
 {
     OTMLNodePtr node(new OTMLNode);
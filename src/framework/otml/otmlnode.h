@@ -27,7 +27,7 @@
 class OTMLNode : public stdext::shared_object
 {
 public:
-    ~OTMLNode() override = default;
+    ~OTMLNode() override;
 
     static OTMLNodePtr create(const std::string_view tag = "", bool unique = false);
     static OTMLNodePtr create(const std::string_view tag, const std::string_view value);
@@ -91,7 +91,7 @@ public:
     OTMLNodePtr asOTMLNode() { return static_self_cast<OTMLNode>(); }
 
 protected:
-    OTMLNode() = default;
+    OTMLNode();
 
     OTMLNodeList m_children;
     std::string m_tag;
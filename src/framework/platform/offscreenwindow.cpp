@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifdef FRAMEWORK_OFFSCREEN
+
+#include "offscreenwindow.h"
+
+#include <cstring>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+OffscreenWindow::OffscreenWindow()
+{
+    m_minimumSize = Size(600, 480);
+    m_size = Size(960, 704);
+}
+
+void OffscreenWindow::init()
+{
+    // prefer the surfaceless platform, it does not need any display server
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions && std::strstr(extensions, "EGL_MESA_platform_surfaceless")) {
+        const auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay)
+            m_eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+
+    if (m_eglDisplay == EGL_NO_DISPLAY)
+        m_eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    if (m_eglDisplay == EGL_NO_DISPLAY)
+        g_logger.fatal("EGL not supported");
+
+    if (!eglInitialize(m_eglDisplay, nullptr, nullptr))
+        g_logger.fatal("Unable to initialize EGL");
+
+#ifdef OPENGL_ES
+    eglBindAPI(EGL_OPENGL_ES_API);
+#else
+    eglBindAPI(EGL_OPENGL_API);
+#endif
+
+    static constexpr EGLint attrList[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+#ifdef OPENGL_ES
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+#else
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+#endif
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+
+    EGLint numConfig;
+    if (!eglChooseConfig(m_eglDisplay, attrList, &m_eglConfig, 1, &numConfig) || numConfig == 0)
+        g_logger.fatal("Failed to choose EGL config");
+
+#ifdef OPENGL_ES
+    static constexpr EGLint contextAttrList[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+#else
+    static constexpr EGLint contextAttrList[] = { EGL_NONE };
+#endif
+
+    m_eglContext = eglCreateContext(m_eglDisplay, m_eglConfig, EGL_NO_CONTEXT, contextAttrList);
+    if (m_eglContext == EGL_NO_CONTEXT)
+        g_logger.fatal(stdext::format("Unable to create EGL context: %d", eglGetError()));
+
+    internalCreateSurface();
+    m_created = true;
+}
+
+void OffscreenWindow::terminate()
+{
+    if (m_eglDisplay == EGL_NO_DISPLAY)
+        return;
+
+    eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    internalDestroySurface();
+
+    if (m_eglContext != EGL_NO_CONTEXT) {
+        eglDestroyContext(m_eglDisplay, m_eglContext);
+        m_eglContext = EGL_NO_CONTEXT;
+    }
+
+    eglTerminate(m_eglDisplay);
+    m_eglDisplay = EGL_NO_DISPLAY;
+    m_created = false;
+}
+
+void OffscreenWindow::internalCreateSurface()
+{
+    const EGLint attrList[] = {
+        EGL_WIDTH, m_size.width(),
+        EGL_HEIGHT, m_size.height(),
+        EGL_NONE
+    };
+
+    m_eglSurface = eglCreatePbufferSurface(m_eglDisplay, m_eglConfig, attrList);
+    if (m_eglSurface == EGL_NO_SURFACE)
+        g_logger.fatal(stdext::format("Unable to create EGL pbuffer surface: %d", eglGetError()));
+
+    if (!eglMakeCurrent(m_eglDisplay, m_eglSurface, m_eglSurface, m_eglContext))
+        g_logger.fatal("Unable to make the offscreen EGL context current");
+}
+
+void OffscreenWindow::internalDestroySurface()
+{
+    if (m_eglSurface != EGL_NO_SURFACE) {
+        eglDestroySurface(m_eglDisplay, m_eglSurface);
+        m_eglSurface = EGL_NO_SURFACE;
+    }
+}
+
+void OffscreenWindow::resize(const Size& size)
+{
+    if (size.width() < m_minimumSize.width() || size.height() < m_minimumSize.height() || size == m_size)
+        return;
+
+    m_size = size;
+
+    // pbuffers have a fixed size, the context moves to a new one
+    if (m_created) {
+        eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, m_eglContext);
+        internalDestroySurface();
+        internalCreateSurface();
+    }
+
+    m_resized = true;
+}
+
+void OffscreenWindow::show()
+{
+    m_visible = true;
+    m_focused = true;
+    m_resized = true;
+}
+
+void OffscreenWindow::poll()
+{
+    // resizes are notified from poll, like a real window does
+    if (m_resized && m_onResize) {
+        m_resized = false;
+        m_onResize(m_size);
+    }
+
+    fireKeysPress();
+}
+
+void OffscreenWindow::swapBuffers() { eglSwapBuffers(m_eglDisplay, m_eglSurface); }
+
+void OffscreenWindow::makeContextCurrent(bool current)
+{
+    if (!current) {
+        eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        return;
+    }
+
+    // the bound api is per thread
+#ifdef OPENGL_ES
+    eglBindAPI(EGL_OPENGL_ES_API);
+#else
+    eglBindAPI(EGL_OPENGL_API);
+#endif
+    eglMakeCurrent(m_eglDisplay, m_eglSurface, m_eglSurface, m_eglContext);
+}
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "platformwindow.h"
+#include <framework/graphics/glutil.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+/**
+ * Window without any display, the GL context renders into an EGL pbuffer of the
+ * window size. It is meant for benchmarks and golden image runs in containers,
+ * with a software driver (e.g. LIBGL_ALWAYS_SOFTWARE=1 with mesa llvmpipe).
+ *
+ * The surfaceless mesa platform is used when available, so no X server is
+ * needed. There is no input, the window is always visible and focused once
+ * shown, and the clipboard only lives in memory.
+ */
+class OffscreenWindow : public PlatformWindow
+{
+public:
+    OffscreenWindow();
+
+    void init() override;
+    void terminate() override;
+
+    void move(const Point& pos) override { m_position = pos; }
+    void resize(const Size& size) override;
+    void show() override;
+    void hide() override { m_visible = false; }
+    void maximize() override {}
+    void poll() override;
+    void swapBuffers() override;
+    void makeContextCurrent(bool current) override;
+    void showMouse() override {}
+    void hideMouse() override {}
+
+    void setMouseCursor(int /*cursorId*/) override {}
+    void restoreMouseCursor() override {}
+
+    void setTitle(const std::string_view /*title*/) override {}
+    void setMinimumSize(const Size& minimumSize) override { m_minimumSize = minimumSize; }
+    void setFullscreen(bool fullscreen) override { m_fullscreen = fullscreen; }
+    void setVerticalSync(bool /*enable*/) override {}
+    void setIcon(const std::string& /*iconFile*/) override {}
+    void setClipboardText(const std::string_view text) override { m_clipboardText = text; }
+
+    Size getDisplaySize() override { return m_size; }
+    std::string getClipboardText() override { return m_clipboardText; }
+    std::string getPlatformType() override { return "Offscreen-EGL"; }
+
+protected:
+    int internalLoadMouseCursor(const ImagePtr& /*image*/, const Point& /*hotSpot*/) override { return -1; }
+
+private:
+    void internalCreateSurface();
+    void internalDestroySurface();
+
+    EGLDisplay m_eglDisplay{ EGL_NO_DISPLAY };
+    EGLConfig m_eglConfig{ nullptr };
+    EGLContext m_eglContext{ EGL_NO_CONTEXT };
+    EGLSurface m_eglSurface{ EGL_NO_SURFACE };
+
+    bool m_resized{ false };
+    std::string m_clipboardText;
+};
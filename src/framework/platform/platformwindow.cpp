@@ -22,7 +22,10 @@
 
 #include "platformwindow.h"
 
-#ifdef WIN32
+#if defined(FRAMEWORK_OFFSCREEN)
+#include "offscreenwindow.h"
+OffscreenWindow window;
+#elif defined(WIN32)
 #include "win32window.h"
 WIN32Window window;
 #else
@@ -49,6 +49,8 @@ public:
     virtual void maximize() = 0;
     virtual void poll() = 0;
     virtual void swapBuffers() = 0;
+    // the GL context is current on a single thread at a time, see Graphics::makeCurrent
+    virtual void makeContextCurrent(bool current) = 0;
     virtual void showMouse() = 0;
     virtual void hideMouse() = 0;
     virtual void displayFatalError(const std::string_view /*message*/) {}
@@ -805,6 +805,21 @@ void WIN32Window::swapBuffers()
 #endif
 }
 
+void WIN32Window::makeContextCurrent(bool current)
+{
+#ifdef OPENGL_ES
+    if (current)
+        eglMakeCurrent(m_eglDisplay, m_eglSurface, m_eglSurface, m_eglContext);
+    else
+        eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+#else
+    if (current)
+        wglMakeCurrent(m_deviceContext, m_wglContext);
+    else
+        wglMakeCurrent(nullptr, nullptr);
+#endif
+}
+
 void WIN32Window::showMouse()
 {
     ShowCursor(true);
@@ -64,6 +64,7 @@ public:
     void maximize() override;
     void poll() override;
     void swapBuffers() override;
+    void makeContextCurrent(bool current) override;
     void showMouse() override;
     void hideMouse() override;
     void displayFatalError(const std::string_view message) override;
@@ -275,6 +275,9 @@ void X11Window::terminate()
 
 void X11Window::internalOpenDisplay()
 {
+    // the display is shared with the render thread, which swaps the buffers
+    XInitThreads();
+
     m_display = XOpenDisplay(nullptr);
     if(!m_display)
         g_logger.fatal("Unable to open X11 display");
@@ -852,6 +855,21 @@ void X11Window::swapBuffers()
 #endif
 }
 
+void X11Window::makeContextCurrent(bool current)
+{
+#ifdef OPENGL_ES
+    if(current)
+        eglMakeCurrent(m_eglDisplay, m_eglSurface, m_eglSurface, m_eglContext);
+    else
+        eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+#else
+    if(current)
+        glXMakeCurrent(m_display, m_window, m_glxContext);
+    else
+        glXMakeCurrent(m_display, None, nullptr);
+#endif
+}
+
 void X11Window::showMouse()
 {
     restoreMouseCursor();
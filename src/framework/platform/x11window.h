@@ -63,6 +63,7 @@ public:
     void maximize();
     void poll();
     void swapBuffers();
+    void makeContextCurrent(bool current);
     void showMouse();
     void hideMouse();
 
@@ -23,16 +23,20 @@
 #include "soundbuffer.h"
 #include "soundfile.h"
 
+#include <framework/core/memorytracker.h>
+
 SoundBuffer::SoundBuffer()
 {
     alGenBuffers(1, &m_bufferId);
     assert(alGetError() == AL_NO_ERROR);
+    g_memory.add(MemoryTracker::SOUND_BUFFERS, 0);
 }
 
 SoundBuffer::~SoundBuffer()
 {
     alDeleteBuffers(1, &m_bufferId);
     assert(alGetError() == AL_NO_ERROR);
+    g_memory.remove(MemoryTracker::SOUND_BUFFERS, m_size);
 }
 
 bool SoundBuffer::fillBuffer(const SoundFilePtr& soundFile)
@@ -61,5 +65,9 @@ bool SoundBuffer::fillBuffer(ALenum sampleFormat, const DataBuffer<char>& data,
         g_logger.error(stdext::format("unable to fill audio buffer data: %s", alGetString(err)));
         return false;
     }
+
+    // the buffer data is replaced, not appended
+    g_memory.add(MemoryTracker::SOUND_BUFFERS, size - m_size, 0);
+    m_size = size;
     return true;
 }
@@ -39,4 +39,5 @@ public:
 
 private:
     uint32_t m_bufferId{ 0 };
+    int m_size{ 0 };
 };
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2010-2022 OTClient <https://github.com/edubart/otclient>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace stdext
+{
+    /**
+     * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+     *
+     * Slots are never destroyed while the queue lives, the producer may refill a popped
+     * slot in place through prepare() to reuse its buffers. Only the producer may call
+     * prepare/commit/push and only the consumer may call front/pop.
+     */
+    template<typename T, size_t Capacity>
+    class spsc_queue
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "spsc_queue capacity must be a power of two");
+
+    public:
+        // free slot to be filled by the producer, nullptr when the queue is full
+        T* prepare()
+        {
+            const size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_cachedHead == Capacity) {
+                m_cachedHead = m_head.load(std::memory_order_acquire);
+                if (tail - m_cachedHead == Capacity)
+                    return nullptr;
+            }
+            return &m_slots[tail & MASK];
+        }
+
+        // publishes the slot returned by the last prepare()
+        void commit() { m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+        bool push(T&& value)
+        {
+            T* slot = prepare();
+            if (!slot)
+                return false;
+
+            *slot = std::move(value);
+            commit();
+            return true;
+        }
+
+        // oldest published slot, nullptr when the queue is empty
+        T* front()
+        {
+            const size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_cachedTail) {
+                m_cachedTail = m_tail.load(std::memory_order_acquire);
+                if (head == m_cachedTail)
+                    return nullptr;
+            }
+            return &m_slots[head & MASK];
+        }
+
+        // releases the slot returned by front(), it must not be touched afterwards
+        void pop() { m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+        bool empty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+        static constexpr size_t capacity() { return Capacity; }
+
+    private:
+        static constexpr size_t MASK = Capacity - 1;
+
+        // consumer side
+        alignas(64) std::atomic<size_t> m_head{ 0 };
+        size_t m_cachedTail{ 0 };
+
+        // producer side
+        alignas(64) std::atomic<size_t> m_tail{ 0 };
+        size_t m_cachedHead{ 0 };
+
+        alignas(64) std::array<T, Capacity> m_slots{};
+    };
+}
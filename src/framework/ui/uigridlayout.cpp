@@ -117,8 +117,9 @@ bool UIGridLayout::internalUpdate()
     preferredHeight += parentWidget->getPaddingTop() + parentWidget->getPaddingBottom();
 
     if (m_fitChildren && preferredHeight != parentWidget->getHeight()) {
-        // must set the preferred height later
-        g_dispatcher.addEvent([=] {
+        // must set the preferred height later, still in this poll
+        EventDispatcher::UrgentScope urgent;
+        g_dispatcher.addTask([=] {
             parentWidget->setHeight(preferredHeight);
         });
     }
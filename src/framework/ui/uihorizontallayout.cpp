@@ -93,8 +93,9 @@ bool UIHorizontalLayout::internalUpdate()
     preferredWidth += parentWidget->getPaddingLeft() + parentWidget->getPaddingRight();
 
     if (m_fitChildren && preferredWidth != parentWidget->getWidth()) {
-        // must set the preferred width later
-        g_dispatcher.addEvent([=] {
+        // must set the preferred width later, still in this poll
+        EventDispatcher::UrgentScope urgent;
+        g_dispatcher.addTask([=] {
             parentWidget->setWidth(preferredWidth);
         });
     }
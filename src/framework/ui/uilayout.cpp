@@ -63,8 +63,10 @@ void UILayout::updateLater()
     if (!getParentWidget())
         return;
 
+    // layout updates ignore the poll budget, a chain of them spilled into the next poll renders half done
+    EventDispatcher::UrgentScope urgent;
     auto self = static_self_cast<UILayout>();
-    g_dispatcher.addEvent([self] {
+    g_dispatcher.addTask([self] {
         self->m_updateScheduled = false;
         self->update();
     });
@@ -24,6 +24,7 @@
 #include "ui.h"
 
 #include <framework/core/application.h>
+#include <framework/core/asyncdispatcher.h>
 #include <framework/core/eventdispatcher.h>
 #include <framework/core/resourcemanager.h>
 #include <framework/otml/otml.h>
@@ -53,6 +54,7 @@ void UIManager::terminate()
     m_styles.clear();
     m_destroyedWidgets.clear();
     m_checkEvent = nullptr;
+    m_prefetchedDocuments.clear();
 }
 
 void UIManager::render(Fw::DrawPane drawPane)
@@ -251,7 +253,7 @@ void UIManager::updateHoveredWidget(bool now)
         func();
     else {
         m_hoverUpdateScheduled = true;
-        g_dispatcher.addEvent(func);
+        g_dispatcher.addTask(func);
     }
 }
 
@@ -318,7 +320,7 @@ bool UIManager::importStyle(const std::string& fl)
 {
     const std::string file{ g_resources.guessFilePath(fl, "otui") };
     try {
-        const OTMLDocumentPtr doc = OTMLDocument::parse(file);
+        const OTMLDocumentPtr doc = parseDocument(file);
 
         for (const OTMLNodePtr& styleNode : doc->children())
             importStyleFromOTML(styleNode);
@@ -400,10 +402,49 @@ std::string UIManager::getStyleClass(const std::string_view styleName)
     return "";
 }
 
+void UIManager::prefetch(const std::string& file)
+{
+    // the path is resolved here, it depends on the calling script
+    const std::string path = g_resources.resolvePath(g_resources.guessFilePath(file, "otui"));
+    if (g_asyncDispatcher.getWorkerCount() == 0 || m_prefetchedDocuments.contains(path))
+        return;
+
+    m_prefetchedDocuments[path] = g_asyncDispatcher.schedule([path] {
+        const auto parsed = std::make_shared<ParsedDocument>();
+        try {
+            parsed->document = OTMLDocument::parse(path);
+        } catch (const std::exception&) {
+            // parseDocument parses it again, to report the error to the caller
+        }
+        return parsed;
+    });
+}
+
+OTMLDocumentPtr UIManager::parseDocument(const std::string& file)
+{
+    if (!m_prefetchedDocuments.empty()) {
+        const auto it = m_prefetchedDocuments.find(g_resources.resolvePath(file));
+        if (it != m_prefetchedDocuments.end()) {
+            std::shared_ptr<ParsedDocument> parsed;
+            try {
+                parsed = it->second.get();
+            } catch (const std::future_error&) {
+                // the workers stopped before running it
+            }
+            m_prefetchedDocuments.erase(it);
+
+            if (parsed && parsed->document)
+                return std::move(parsed->document);
+        }
+    }
+
+    return OTMLDocument::parse(file);
+}
+
 UIWidgetPtr UIManager::loadUI(const std::string& file, const UIWidgetPtr& parent)
 {
     try {
-        const OTMLDocumentPtr doc = OTMLDocument::parse(g_resources.guessFilePath(file, "otui"));
+        const OTMLDocumentPtr doc = parseDocument(g_resources.guessFilePath(file, "otui"));
         UIWidgetPtr widget;
         for (const OTMLNodePtr& node : doc->children()) {
             std::string tag = node->tag();
@@ -26,6 +26,8 @@
 #include <framework/core/inputevent.h>
 #include <framework/otml/declarations.h>
 
+#include <future>
+
  //@bindsingleton g_ui
 class UIManager
 {
@@ -47,6 +49,9 @@ public:
     OTMLNodePtr getStyle(const std::string_view styleName);
     std::string getStyleClass(const std::string_view styleName);
 
+    // parses the otui file on a worker, the next loadUI or importStyle of it takes the result
+    void prefetch(const std::string& file);
+
     UIWidgetPtr loadUI(const std::string& file, const UIWidgetPtr& parent);
     UIWidgetPtr displayUI(const std::string& file) { return loadUI(file, m_rootWidget); }
     UIWidgetPtr createWidget(const std::string_view styleName, const UIWidgetPtr& parent);
@@ -76,6 +81,14 @@ protected:
     friend class UIWidget;
 
 private:
+    // moved out on the main thread, so the worker never shares the document
+    struct ParsedDocument
+    {
+        OTMLDocumentPtr document;
+    };
+
+    OTMLDocumentPtr parseDocument(const std::string& file);
+
     UIWidgetPtr m_rootWidget;
     UIWidgetPtr m_mouseReceiver;
     UIWidgetPtr m_keyboardReceiver;
@@ -87,6 +100,7 @@ private:
     stdext::map<std::string, OTMLNodePtr> m_styles;
     UIWidgetList m_destroyedWidgets;
     ScheduledEventPtr m_checkEvent;
+    stdext::map<std::string, std::shared_future<std::shared_ptr<ParsedDocument>>> m_prefetchedDocuments;
 };
 
 extern UIManager g_ui;
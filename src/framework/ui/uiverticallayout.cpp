@@ -95,8 +95,9 @@ bool UIVerticalLayout::internalUpdate()
     preferredHeight += parentWidget->getPaddingTop() + parentWidget->getPaddingBottom();
 
     if (m_fitChildren && preferredHeight != parentWidget->getHeight()) {
-        // must set the preferred width later
-        g_dispatcher.addEvent([=] {
+        // must set the preferred width later, still in this poll
+        EventDispatcher::UrgentScope urgent;
+        g_dispatcher.addTask([=] {
             parentWidget->setHeight(preferredHeight);
         });
     }
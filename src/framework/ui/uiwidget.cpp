@@ -63,8 +63,8 @@ void UIWidget::draw(const Rect& visibleRect, Fw::DrawPane drawPane)
     }
 
     if (m_rotation != 0.0f) {
-        g_painter->pushTransformMatrix();
-        g_painter->rotate(m_rect.center(), m_rotation * (std::numbers::pi / 180.0));
+        g_drawPool.pushTransformMatrix();
+        g_drawPool.rotate(m_rect.center(), m_rotation * (std::numbers::pi / 180.0));
     }
 
     drawSelf(drawPane);
@@ -77,7 +77,7 @@ void UIWidget::draw(const Rect& visibleRect, Fw::DrawPane drawPane)
     }
 
     if (m_rotation != 0.0f)
-        g_painter->popTransformMatrix();
+        g_drawPool.popTransformMatrix();
 
     if (m_clipping) {
         g_drawPool.setClipRect(oldClipRect);
@@ -973,8 +973,9 @@ bool UIWidget::setRect(const Rect& rect)
 
     // avoid massive update events
     if (!m_updateEventScheduled) {
+        EventDispatcher::UrgentScope urgent;
         UIWidgetPtr self = static_self_cast<UIWidget>();
-        g_dispatcher.addEvent([self, oldRect] {
+        g_dispatcher.addTask([self, oldRect] {
             self->m_updateEventScheduled = false;
             if (oldRect != self->getRect())
                 self->onGeometryChange(oldRect, self->getRect());
@@ -1460,8 +1461,9 @@ void UIWidget::updateStyle()
         return;
 
     if (m_loadingStyle && !m_updateStyleScheduled) {
+        EventDispatcher::UrgentScope urgent;
         UIWidgetPtr self = static_self_cast<UIWidget>();
-        g_dispatcher.addEvent([self] {
+        g_dispatcher.addTask([self] {
             self->m_updateStyleScheduled = false;
             self->updateStyle();
         });
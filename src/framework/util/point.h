@@ -37,7 +37,7 @@ public:
     TPoint() : x(0), y(0) {}
     TPoint(T xy) : x(xy), y(xy) {}
     TPoint(T x, T y) : x(x), y(y) {}
-    TPoint(const TPoint<T>& other) : x(other.x), y(other.y) {}
+    TPoint(const TPoint<T>& other) = default;
 
     bool isNull() const { return x == 0 && y == 0; }
     TSize<T> toSize() const { return TSize<T>(x, y); }
@@ -71,7 +71,7 @@ public:
     bool operator<(const TPoint<T>& other) const { return x < other.x&& y < other.y; }
     bool operator>(const TPoint<T>& other) const { return x > other.x && y > other.y; }
 
-    TPoint<T>& operator=(const TPoint<T>& other) { x = other.x; y = other.y; return *this; }
+    TPoint<T>& operator=(const TPoint<T>& other) = default;
     bool operator==(const TPoint<T>& other) const { return other.x == x && other.y == y; }
     bool operator!=(const TPoint<T>& other) const { return other.x != x || other.y != y; }
 
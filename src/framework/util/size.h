@@ -32,7 +32,7 @@ public:
     TSize() : wd(-1), ht(-1) {};
     TSize(T widthHeight) : wd(widthHeight), ht(widthHeight) {};
     TSize(T width, T height) : wd(width), ht(height) {};
-    TSize(const TSize<T>& other) : wd(other.wd), ht(other.ht) {};
+    TSize(const TSize<T>& other) = default;
 
     TPoint<T> toPoint() const { return TPoint<T>(wd, ht); }
 
@@ -67,7 +67,7 @@ public:
     bool operator<(const TSize<T>& other) const { return wd < other.wd || ht < other.ht; }
     bool operator>(const TSize<T>& other) const { return wd > other.wd || ht > other.ht; }
 
-    TSize<T>& operator=(const TSize<T>& other) { wd = other.wd; ht = other.ht; return *this; }
+    TSize<T>& operator=(const TSize<T>& other) = default;
     bool operator==(const TSize<T>& other) const { return other.wd == wd && other.ht == ht; }
     bool operator!=(const TSize<T>& other) const { return other.wd != wd || other.ht != ht; }
 